@@ -0,0 +1,313 @@
+#include "AdaptiveFilter.hpp"
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <iostream>
+#include "globals.hpp"
+
+AdaptiveFilter::AdaptiveFilter() :
+	_isSetup(false), _algorithm(AdaptiveAlgorithm::NLMS), _taps(1), _step(0.1), _regularization(1e-3),
+	_index(0), _updates(0), _alpha(1.0 / 1024), _primaryPower(0.0), _errorPower(0.0), _regressorPower(0.0),
+	_lastErrorPower(0.0), _window(1024), _count(0), _converged(false), _divergences(0)
+{}
+
+bool AdaptiveFilter::set(AdaptiveAlgorithm algorithm, size_t taps, double step, double regularization) {
+	if (taps < 1) {
+		std::cerr << "The adaptive filter needs at least one weight" << std::endl;
+		return false;
+	}
+	if (algorithm == AdaptiveAlgorithm::RLS) {
+		if (step <= 0.0 || step > 1.0) {
+			std::cerr << "The forgetting factor must be in ]0, 1]" << std::endl;
+			return false;
+		}
+	} else if (step <= 0.0) {
+		std::cerr << "The step size must be positive" << std::endl;
+		return false;
+	}
+	if (regularization <= 0.0) {
+		std::cerr << "The regularization must be positive" << std::endl;
+		return false;
+	}
+
+	_algorithm = algorithm;
+	_taps = taps;
+	_step = step;
+	_regularization = regularization;
+	_isSetup = false;
+	return true;
+}
+
+void AdaptiveFilter::setup() {
+	_weights.assign(_taps, 0.0);
+	_history.assign(2 * _taps, 0.0);
+	if (_algorithm == AdaptiveAlgorithm::RLS) {
+		_P.assign(_taps * _taps, 0.0);
+		_Px.assign(_taps, 0.0);
+	} else {
+		_P.clear();
+		_Px.clear();
+	}
+	_isSetup = true;
+	reset();
+}
+
+void AdaptiveFilter::resetWeights() {
+	std::fill(_weights.begin(), _weights.end(), 0.0);
+	if (_algorithm == AdaptiveAlgorithm::RLS) {
+		std::fill(_P.begin(), _P.end(), 0.0);
+		for (size_t i = 0; i < _taps; i++) {
+			_P[i * _taps + i] = 1.0 / _regularization;
+		}
+	}
+	_updates = 0;
+}
+
+void AdaptiveFilter::reset() {
+	resetWeights();
+	std::fill(_history.begin(), _history.end(), 0.0);
+	_index = 0;
+	_primaryPower = 0.0;
+	_errorPower = 0.0;
+	_regressorPower = 0.0;
+	_lastErrorPower = std::numeric_limits<double>::infinity();
+	_count = 0;
+	_converged = false;
+	_divergences = 0;
+}
+
+void AdaptiveFilter::setMonitorWindow(size_t window) {
+	_window = std::max<size_t>(window, 1);
+	_alpha = 1.0 / static_cast<double>(_window);
+}
+
+double AdaptiveFilter::update(const double *regressor, double primary) {
+	if (!_isSetup) {
+		throw std::invalid_argument("Adaptive filter is not set up");
+	}
+
+	const size_t N = _taps;
+	const double *__restrict x = regressor;
+	double *__restrict w = _weights.data();
+
+	// estimation et énergie du régresseur dans la même boucle
+	double estimate = 0.0;
+	double energy = 0.0;
+	for (size_t k = 0; k < N; k++) {
+		estimate += w[k] * x[k];
+		energy += x[k] * x[k];
+	}
+	double error = primary - estimate;
+
+	switch (_algorithm) {
+		case AdaptiveAlgorithm::LMS:
+		case AdaptiveAlgorithm::NLMS: {
+			double gain = _step * error;
+			if (_algorithm == AdaptiveAlgorithm::NLMS) {
+				gain /= _regularization + energy;
+			}
+			for (size_t k = 0; k < N; k++) {
+				w[k] += gain * x[k];
+			}
+			break;
+		}
+		case AdaptiveAlgorithm::RLS: {
+			const double lambda = _step;
+			double *__restrict P = _P.data();
+			double *__restrict Px = _Px.data();
+			double xPx = 0.0;
+			for (size_t i = 0; i < N; i++) {
+				double sum = 0.0;
+				for (size_t j = 0; j < N; j++) {
+					sum += P[i * N + j] * x[j];
+				}
+				Px[i] = sum;
+				xPx += x[i] * sum;
+			}
+			// gain k = P.x / (lambda + x'.P.x), puis P = (P - k.(P.x)') / lambda
+			double inverse = 1.0 / (lambda + xPx);
+			for (size_t i = 0; i < N; i++) {
+				double k = Px[i] * inverse;
+				w[i] += k * error;
+				double *__restrict row = P + i * N;
+				for (size_t j = 0; j < N; j++) {
+					row[j] = (row[j] - k * Px[j]) / lambda;
+				}
+			}
+			// symétrisation périodique contre la dérive numérique
+			if (++_updates % 1024 == 0) {
+				for (size_t i = 0; i < N; i++) {
+					for (size_t j = i + 1; j < N; j++) {
+						double mean = 0.5 * (P[i * N + j] + P[j * N + i]);
+						P[i * N + j] = mean;
+						P[j * N + i] = mean;
+					}
+				}
+			}
+			break;
+		}
+	}
+
+	_regressorPower += _alpha * (energy / static_cast<double>(N) - _regressorPower);
+	updateMonitor(primary, error);
+	if (!std::isfinite(error)) {
+		return primary;
+	}
+	return error;
+}
+
+void AdaptiveFilter::updateMonitor(double primary, double error) {
+	_primaryPower += _alpha * (primary * primary - _primaryPower);
+	_errorPower += _alpha * (error * error - _errorPower);
+
+	// divergence : poids non finis ou erreur beaucoup plus forte que l'entrée
+	bool diverged = !std::isfinite(_errorPower) || (_count >= _window && _errorPower > 1e3 * _primaryPower + 1e-300);
+	if (diverged) {
+		if (_divergences == 0) {
+			std::cerr << "The adaptive filter diverged, its weights are reset (reduce the step size)" << std::endl;
+		}
+		_divergences++;
+		resetWeights();
+		_errorPower = _primaryPower;
+		_lastErrorPower = std::numeric_limits<double>::infinity();
+		_converged = false;
+		_count = 0;
+		return;
+	}
+
+	// convergence : la puissance de l'erreur ne diminue plus d'une fenêtre à l'autre
+	if (++_count % _window == 0) {
+		_converged = _errorPower >= 0.95 * _lastErrorPower;
+		_lastErrorPower = _errorPower;
+	}
+}
+
+double AdaptiveFilter::apply(double reference, double primary) {
+	if (!_isSetup) {
+		throw std::invalid_argument("Adaptive filter is not set up");
+	}
+	// ligne à retard parcourue à rebours : le régresseur est contigu
+	_index = (_index == 0) ? _taps - 1 : _index - 1;
+	_history[_index] = reference;
+	_history[_index + _taps] = reference;
+	return update(_history.data() + _index, primary);
+}
+
+void AdaptiveFilter::process(const double *reference, const double *primary, double *output, size_t n) {
+	for (size_t i = 0; i < n; i++) {
+		output[i] = apply(reference[i], primary[i]);
+	}
+}
+
+Signal AdaptiveFilter::apply(const Signal &reference, const Signal &primary) {
+	if (reference.size() != primary.size()) {
+		throw std::invalid_argument("The reference and primary signals must have the same size");
+	}
+	Signal output(primary.size());
+	reset();
+	process(reference.data(), primary.data(), output.data(), primary.size());
+	return output;
+}
+
+double AdaptiveFilter::getAttenuation() const {
+	if (_primaryPower <= 0.0 || _errorPower <= 0.0) {
+		return 0.0;
+	}
+	return 10.0 * std::log10(_primaryPower / _errorPower);
+}
+
+double AdaptiveFilter::getNormalizedStep() const {
+	switch (_algorithm) {
+		case AdaptiveAlgorithm::LMS:
+			return _step * static_cast<double>(_taps) * _regressorPower;
+		case AdaptiveAlgorithm::NLMS:
+			return _step;
+		default:
+			return 0.0;
+	}
+}
+
+/* -------------------------------------------------------------------------- */
+
+MainsCanceller::MainsCanceller() :
+	_isSetup(false), _mainsFrequency(50.0), _harmonics(3), _algorithm(AdaptiveAlgorithm::NLMS),
+	_bandwidth(1.0), _samplingFrequency(0.0), _samples(0)
+{}
+
+bool MainsCanceller::set(double mains_frequency, int harmonics, AdaptiveAlgorithm algorithm, double bandwidth, double sampling_frequency) {
+	if (mains_frequency <= 0.0 || harmonics < 1 || bandwidth <= 0.0 || sampling_frequency < 0.0) {
+		std::cerr << "Invalid parameters for the mains canceller" << std::endl;
+		return false;
+	}
+	_mainsFrequency = mains_frequency;
+	_harmonics = harmonics;
+	_algorithm = algorithm;
+	_bandwidth = bandwidth;
+	_samplingFrequency = sampling_frequency;
+	_isSetup = false;
+	return true;
+}
+
+void MainsCanceller::setup() {
+	double fs = (_samplingFrequency > 0.0) ? _samplingFrequency : static_cast<double>(SAMPLING_FREQUENCY);
+	if (_harmonics * _mainsFrequency >= fs / 2.0) {
+		throw std::invalid_argument("The harmonics of the mains must be below the Nyquist frequency");
+	}
+
+	// Chaque paire (sin, cos) forme un filtre réjecteur adaptatif de largeur à -3 dB
+	// B = mu'.fs/(2.pi), mu' étant le pas vu par une paire : mu pour le LMS, mu/harmonics
+	// pour le NLMS (énergie du régresseur = harmonics), 2.(1 - lambda) pour le RLS.
+	double step = 2.0 * M_PI * _bandwidth / fs;
+	if (_algorithm == AdaptiveAlgorithm::NLMS) {
+		step *= _harmonics;
+	} else if (_algorithm == AdaptiveAlgorithm::RLS) {
+		step = 1.0 - step / 2.0;
+	}
+	if (!_filter.set(_algorithm, 2 * _harmonics, step)) {
+		throw std::invalid_argument("The bandwidth of the mains canceller is too large");
+	}
+	_filter.setup();
+	_filter.setMonitorWindow(static_cast<size_t>(std::ceil(fs / _mainsFrequency)));
+	_regressor.assign(2 * _harmonics, 0.0);
+	_phasors.assign(_harmonics, 1.0);
+	_rotations.resize(_harmonics);
+	for (int h = 0; h < _harmonics; h++) {
+		_rotations[h] = std::polar(1.0, 2.0 * M_PI * (h + 1) * _mainsFrequency / fs);
+	}
+	_isSetup = true;
+	reset();
+}
+
+void MainsCanceller::reset() {
+	_filter.reset();
+	std::fill(_phasors.begin(), _phasors.end(), 1.0);
+	_samples = 0;
+}
+
+void MainsCanceller::process(const double *input, double *output, size_t n) {
+	if (!_isSetup) {
+		throw std::invalid_argument("Mains canceller is not set up");
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		for (int h = 0; h < _harmonics; h++) {
+			_regressor[2 * h]     = _phasors[h].imag();
+			_regressor[2 * h + 1] = _phasors[h].real();
+			_phasors[h] *= _rotations[h];
+		}
+		// renormalisation des oscillateurs contre la dérive d'amplitude
+		if (++_samples % 1024 == 0) {
+			for (std::complex<double> &phasor : _phasors) {
+				phasor /= std::abs(phasor);
+			}
+		}
+		output[i] = _filter.update(_regressor.data(), input[i]);
+	}
+}
+
+Signal MainsCanceller::apply(const Signal &input) {
+	Signal output(input.size());
+	reset();
+	process(input.data(), output.data(), input.size());
+	return output;
+}
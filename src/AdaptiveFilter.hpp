@@ -0,0 +1,237 @@
+#ifndef __ADAPTIVEFILTER_HPP
+#define __ADAPTIVEFILTER_HPP
+
+#include <vector>
+#include <complex>
+#include "Signal.hpp"
+
+/**
+ * @brief Algorithm used to adapt the weights
+ */
+enum class AdaptiveAlgorithm {
+	LMS,  // Least mean squares, w += mu.e.x
+	NLMS, // Normalized LMS, w += mu.e.x / (eps + |x|^2)
+	RLS,  // Recursive least squares, with a forgetting factor
+};
+
+/**
+ * @brief Adaptive linear combiner used as a noise canceller
+ * @details The weights are adapted so that their combination of the reference
+ *          regressor matches the part of the primary input which is correlated
+ *          with it. The error (primary - estimate) is the cleaned signal.
+ *          The state is kept between calls, so that a stream can be processed block
+ *          by block. A monitor follows the powers of the primary input and of the
+ *          error, and resets the weights if the adaptation diverges.
+ */
+class AdaptiveFilter {
+public:
+	AdaptiveFilter();
+
+	/**
+	 * @brief Set the parameters of the filter
+	 * @param[in] algorithm Adaptation algorithm
+	 * @param[in] taps Number of weights
+	 * @param[in] step Step size mu (LMS, NLMS, stable for 0 < mu < 2), or forgetting
+	 *            factor lambda (RLS, 0 < lambda <= 1, typically 0.99 to 0.9999)
+	 * @param[in] regularization Regularization eps of the NLMS normalization, or
+	 *            initial value delta of the RLS inverse correlation matrix (P = I/delta)
+	 * @return true if the parameters are valid, false otherwise
+	 */
+	bool set(AdaptiveAlgorithm algorithm, size_t taps, double step, double regularization = 1e-3);
+
+	/**
+	 * @brief Allocate the weights and the delay line
+	 */
+	void setup();
+
+	/**
+	 * @brief Check if the filter is setup
+	 */
+	bool isSetup() const { return _isSetup; }
+
+	/**
+	 * @brief Reset the weights, the delay line and the monitor
+	 */
+	void reset();
+
+	/**
+	 * @brief Set the time constant of the power monitor
+	 * @param[in] window Number of samples
+	 */
+	void setMonitorWindow(size_t window);
+
+	/**
+	 * @brief One adaptation step on an arbitrary regressor
+	 * @param[in] regressor Reference values, one per weight
+	 * @param[in] primary Primary sample
+	 * @return Error, i.e. the cleaned primary sample
+	 */
+	double update(const double *regressor, double primary);
+
+	/**
+	 * @brief Cancel from the primary input the part correlated with a reference channel
+	 * @param[in] reference Reference sample, pushed into the delay line of the FIR
+	 * @param[in] primary Primary sample
+	 * @return Cleaned primary sample
+	 */
+	double apply(double reference, double primary);
+
+	/**
+	 * @brief Cancel a block, following the previous one (streaming mode)
+	 * @param[in] reference Reference samples
+	 * @param[in] primary Primary samples
+	 * @param[out] output Cleaned samples (may be equal to primary)
+	 * @param[in] n Number of samples
+	 */
+	void process(const double *reference, const double *primary, double *output, size_t n);
+
+	/**
+	 * @brief Cancel a complete signal, from null weights
+	 * @param[in] reference Reference signal
+	 * @param[in] primary Primary signal, of the same size
+	 * @return Cleaned signal
+	 */
+	Signal apply(const Signal &reference, const Signal &primary);
+
+	/**
+	 * @brief Weights of the combiner (the taps of the FIR for a reference channel)
+	 */
+	const std::vector<double> &getWeights() const { return _weights; }
+
+	/**
+	 * @brief Mean power of the primary input over the monitor window
+	 */
+	double getPrimaryPower() const { return _primaryPower; }
+
+	/**
+	 * @brief Mean power of the error over the monitor window
+	 */
+	double getErrorPower() const { return _errorPower; }
+
+	/**
+	 * @brief Attenuation of the interference (primary power / error power) in dB
+	 */
+	double getAttenuation() const;
+
+	/**
+	 * @brief Step size relative to the stability limit of the algorithm
+	 * @details mu.taps.(reference power) for the LMS, mu for the NLMS (both must stay
+	 *          below 2, and well below for a low misadjustment), 0 for the RLS.
+	 */
+	double getNormalizedStep() const;
+
+	/**
+	 * @brief True when the error power stopped decreasing during the last monitor window
+	 */
+	bool isConverged() const { return _converged; }
+
+	/**
+	 * @brief Number of times the weights were reset because the adaptation diverged
+	 */
+	size_t getDivergences() const { return _divergences; }
+
+private:
+	void updateMonitor(double primary, double error);
+	void resetWeights();
+
+	bool _isSetup;
+	AdaptiveAlgorithm _algorithm;
+	size_t _taps;
+	double _step;
+	double _regularization;
+
+	std::vector<double> _weights;
+	std::vector<double> _history; // delay line written twice, newest sample first
+	size_t _index;
+
+	// RLS
+	std::vector<double> _P;       // inverse correlation matrix, _taps x _taps
+	std::vector<double> _Px;
+	size_t _updates;
+
+	// monitor
+	double _alpha;
+	double _primaryPower, _errorPower, _regressorPower;
+	double _lastErrorPower;
+	size_t _window, _count;
+	bool _converged;
+	size_t _divergences;
+};
+
+/**
+ * @brief Adaptive canceller of the mains frequency and its harmonics
+ * @details The reference is synthesized: a sine and a cosine per harmonic, which
+ *          an adaptive combiner scales to the amplitude and phase of the pickup.
+ *          The canceller behaves as a comb of notches whose -3 dB width is the given
+ *          bandwidth; it converges in about 1/(pi.bandwidth) seconds. The oscillators
+ *          keep their phase between calls to process().
+ * @note The canceller notches the signal around every harmonic of the mains; it must
+ *       not be used to measure a signal at one of these frequencies.
+ */
+class MainsCanceller {
+public:
+	MainsCanceller();
+
+	/**
+	 * @brief Set the parameters of the canceller
+	 * @param[in] mains_frequency Frequency of the mains (50 or 60 Hz)
+	 * @param[in] harmonics Number of harmonics cancelled (fundamental included)
+	 * @param[in] algorithm Adaptation algorithm
+	 * @param[in] bandwidth Width of each notch in Hz, converted into the step size or
+	 *            the forgetting factor of the algorithm
+	 * @param[in] sampling_frequency Sampling frequency (0 : SAMPLING_FREQUENCY at setup)
+	 * @return true if the parameters are valid, false otherwise
+	 */
+	bool set(double mains_frequency = 50.0, int harmonics = 3, AdaptiveAlgorithm algorithm = AdaptiveAlgorithm::NLMS, double bandwidth = 1.0, double sampling_frequency = 0.0);
+
+	/**
+	 * @brief Setup the oscillators and the adaptive filter
+	 */
+	void setup();
+
+	/**
+	 * @brief Check if the canceller is setup
+	 */
+	bool isSetup() const { return _isSetup; }
+
+	/**
+	 * @brief Reset the weights and the phase of the oscillators
+	 */
+	void reset();
+
+	/**
+	 * @brief Cancel the mains in a block, following the previous one (streaming mode)
+	 * @param[in] input Input samples
+	 * @param[out] output Cleaned samples (may be equal to input)
+	 * @param[in] n Number of samples
+	 */
+	void process(const double *input, double *output, size_t n);
+
+	/**
+	 * @brief Cancel the mains in a complete signal, from null weights
+	 * @param[in] input Input signal
+	 * @return Cleaned signal
+	 */
+	Signal apply(const Signal &input);
+
+	/**
+	 * @brief Adaptive filter, for its monitor
+	 */
+	const AdaptiveFilter &getFilter() const { return _filter; }
+
+private:
+	bool _isSetup;
+	double _mainsFrequency;
+	int _harmonics;
+	AdaptiveAlgorithm _algorithm;
+	double _bandwidth;
+	double _samplingFrequency;
+
+	AdaptiveFilter _filter;
+	std::vector<std::complex<double>> _phasors;   // exp(j.k.w.n) of each harmonic
+	std::vector<std::complex<double>> _rotations; // exp(j.k.w)
+	std::vector<double> _regressor;               // (sin, cos) of each harmonic
+	size_t _samples;
+};
+
+#endif // __ADAPTIVEFILTER_HPP
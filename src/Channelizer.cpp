@@ -0,0 +1,173 @@
+#include "Channelizer.hpp"
+#include <cmath>
+#include <stdexcept>
+#include <iostream>
+#include "Decimator.hpp"
+
+Channelizer::Channelizer() : _isSetup(false), _channels(2), _tapsPerBranch(8), _windowType(WindowType::Blackman), _decimation(2), _index(0), _phase(0), _time(0) {}
+
+bool Channelizer::set(size_t channels, size_t taps_per_branch, WindowType window_type, size_t decimation) {
+	if (channels < 2 || (channels & (channels - 1)) != 0) {
+		std::cerr << "The number of channels must be a power of two" << std::endl;
+		return false;
+	}
+	if (taps_per_branch < 1) {
+		std::cerr << "The branches need at least one tap" << std::endl;
+		return false;
+	}
+	if (decimation == 0) {
+		decimation = channels;
+	}
+	if (channels % decimation != 0) {
+		std::cerr << "The decimation must divide the number of channels" << std::endl;
+		return false;
+	}
+
+	_channels = channels;
+	_tapsPerBranch = taps_per_branch;
+	_windowType = window_type;
+	_decimation = decimation;
+	_isSetup = false;
+	return true;
+}
+
+void Channelizer::setup() {
+	const size_t M = _channels;
+	const size_t L = M * _tapsPerBranch;
+
+	_prototype = designLowPassFIR(L, 0.5 / M, _windowType);
+
+	_branches.assign(M, 0.0);
+	_packed.assign(M / 2, 0.0);
+
+	_twiddles.resize(M);
+	for (size_t k = 0; k < M; k++) {
+		_twiddles[k] = std::polar(1.0, -2.0 * M_PI * k / M);
+	}
+
+	const size_t N = M / 2;
+	size_t bits = 0;
+	while ((size_t(1) << bits) < N) {
+		bits++;
+	}
+	_reversed.resize(N);
+	for (size_t k = 0; k < N; k++) {
+		size_t r = 0;
+		for (size_t b = 0; b < bits; b++) {
+			r |= ((k >> b) & 1) << (bits - 1 - b);
+		}
+		_reversed[k] = r;
+	}
+
+	_isSetup = true;
+	reset();
+}
+
+void Channelizer::reset() {
+	_history.assign(2 * _prototype.size(), 0.0);
+	_index = 0;
+	_phase = 0;
+	_time = 0;
+}
+
+void Channelizer::fft(complexd *data) const {
+	const size_t N = _channels / 2;
+	for (size_t k = 0; k < N; k++) {
+		size_t r = _reversed[k];
+		if (r > k) {
+			std::swap(data[k], data[r]);
+		}
+	}
+	for (size_t size = 2; size <= N; size <<= 1) {
+		const size_t half = size / 2;
+		const size_t step = _channels / size;
+		for (size_t start = 0; start < N; start += size) {
+			for (size_t i = 0; i < half; i++) {
+				complexd t = _twiddles[i * step] * data[start + i + half];
+				complexd u = data[start + i];
+				data[start + i] = u + t;
+				data[start + i + half] = u - t;
+			}
+		}
+	}
+}
+
+size_t Channelizer::process(const double *input, size_t n, complexd *output) {
+	if (!_isSetup) {
+		throw std::invalid_argument("Channelizer is not set up");
+	}
+
+	const size_t M = _channels;
+	const size_t N = M / 2;
+	const size_t L = _prototype.size();
+	const size_t outputs = getNumberOfOutputs();
+	const double *__restrict h = _prototype.data();
+	size_t frames = 0;
+
+	for (size_t i = 0; i < n; i++) {
+		// ligne à retard parcourue à rebours : d[j] = x(n - j)
+		_index = (_index == 0) ? L - 1 : _index - 1;
+		_history[_index] = input[i];
+		_history[_index + L] = input[i];
+		const size_t t = _time;
+		_time = (_time + 1 == M) ? 0 : _time + 1;
+
+		if (_phase != 0) {
+			_phase--;
+			continue;
+		}
+		_phase = _decimation - 1;
+
+		// sortie des M branches du filtre polyphase
+		const double *__restrict d = _history.data() + _index;
+		double *__restrict v = _branches.data();
+		for (size_t r = 0; r < M; r++) {
+			v[r] = h[r] * d[r];
+		}
+		for (size_t p = 1; p < _tapsPerBranch; p++) {
+			const double *hp = h + p * M;
+			const double *dp = d + p * M;
+			for (size_t r = 0; r < M; r++) {
+				v[r] += hp[r] * dp[r];
+			}
+		}
+
+		// FFT réelle de M points par une FFT complexe de M/2 points
+		for (size_t r = 0; r < N; r++) {
+			_packed[r] = complexd(v[2 * r], v[2 * r + 1]);
+		}
+		fft(_packed.data());
+
+		complexd *y = output + frames * outputs;
+		for (size_t k = 0; k <= N; k++) {
+			complexd Zk = _packed[k % N];
+			complexd Zc = std::conj(_packed[(N - k) % N]);
+			complexd even = 0.5 * (Zk + Zc);
+			complexd odd = complexd(0.0, -0.5) * (Zk - Zc);
+			complexd V = even + _twiddles[k] * odd;
+			// la voie k est ramenée en bande de base : exp(-2j.pi.k.n/M)
+			y[k] = _twiddles[(k * t) % M] * std::conj(V);
+		}
+		frames++;
+	}
+	return frames;
+}
+
+std::vector<std::vector<complexd>> Channelizer::apply(const Signal &input) {
+	if (!_isSetup) {
+		throw std::invalid_argument("Channelizer is not set up");
+	}
+
+	reset();
+	const size_t outputs = getNumberOfOutputs();
+	std::vector<complexd> frames((input.size() / _decimation + 1) * outputs);
+	size_t count = process(input.data(), input.size(), frames.data());
+
+	std::vector<std::vector<complexd>> streams(outputs, std::vector<complexd>(count));
+	for (size_t m = 0; m < count; m++) {
+		for (size_t k = 0; k < outputs; k++) {
+			streams[k][m] = frames[m * outputs + k];
+		}
+	}
+	return streams;
+}
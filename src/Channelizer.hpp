@@ -0,0 +1,121 @@
+#ifndef __CHANNELIZER_HPP
+#define __CHANNELIZER_HPP
+
+#include <vector>
+#include "globals.hpp"
+#include "Signal.hpp"
+#include "Window.hpp"
+
+/**
+ * @brief Polyphase FFT channelizer
+ * @details The input band [0, fs/2] is split into channels of width fs/M centered on
+ *          k.fs/M. A prototype low pass FIR of M.P taps (cutoff fs/(2M)) is split into
+ *          M branches of P taps; at each output instant the branches are summed and an
+ *          M-point FFT turns them into the M channels, already mixed down to baseband and
+ *          decimated. The cost per output frame is M.P multiplications plus one FFT,
+ *          instead of M mixers and M filters running at the input rate.
+ *
+ *          The input being real, channel M-k is the conjugate of channel k, so only the
+ *          channels 0 to M/2 are computed (with an M/2-point complex FFT).
+ *          A complex tone A.exp(j.w.n) in a channel gives an output of amplitude A, a real
+ *          sine of amplitude A gives A/2. The outputs are delayed by (M.P - 1)/2 input samples.
+ */
+class Channelizer {
+public:
+	Channelizer();
+
+	/**
+	 * @brief Set the parameters of the channelizer
+	 * @param[in] channels Number of channels M (power of two, at least 2)
+	 * @param[in] taps_per_branch Number of taps P of each branch of the prototype filter
+	 * @param[in] window_type Window used to design the prototype filter
+	 * @param[in] decimation Decimation factor, dividing M (0 for M, critically sampled).
+	 *            M/2 gives overlapping channels without aliasing at their edges.
+	 * @return true if the parameters are valid, false otherwise
+	 */
+	bool set(size_t channels, size_t taps_per_branch = 8, WindowType window_type = WindowType::Blackman, size_t decimation = 0);
+
+	/**
+	 * @brief Design the prototype filter and the FFT tables
+	 */
+	void setup();
+
+	/**
+	 * @brief Check if the channelizer is setup
+	 */
+	bool isSetup() const { return _isSetup; }
+
+	/**
+	 * @brief Reset the delay line
+	 */
+	void reset();
+
+	/**
+	 * @brief Channelize a block of samples, following the previous one (streaming mode)
+	 * @param[in] input Input samples
+	 * @param[in] n Number of input samples
+	 * @param[out] output Output frames, output[m*getNumberOfOutputs() + k] for channel k.
+	 *             Must hold (n / getDecimation() + 1) frames.
+	 * @return Number of output frames
+	 */
+	size_t process(const double *input, size_t n, complexd *output);
+
+	/**
+	 * @brief Channelize a complete signal from a null state
+	 * @param[in] input Input signal
+	 * @return Decimated complex stream of each channel (getNumberOfOutputs() streams)
+	 */
+	std::vector<std::vector<complexd>> apply(const Signal &input);
+
+	/**
+	 * @brief Number of channels M of the filter bank
+	 */
+	size_t getChannels() const { return _channels; }
+
+	/**
+	 * @brief Number of channels computed for a real input (M/2 + 1)
+	 */
+	size_t getNumberOfOutputs() const { return _channels / 2 + 1; }
+
+	/**
+	 * @brief Decimation factor of the output streams
+	 */
+	size_t getDecimation() const { return _decimation; }
+
+	/**
+	 * @brief Center frequency of a channel
+	 * @param[in] channel Index of the channel
+	 * @param[in] input_rate Sampling frequency of the input
+	 */
+	double getChannelFrequency(size_t channel, double input_rate) const {
+		return static_cast<double>(channel) * input_rate / static_cast<double>(_channels);
+	}
+
+	/**
+	 * @brief Taps of the prototype filter
+	 */
+	const std::vector<double> &getPrototype() const { return _prototype; }
+
+private:
+	// FFT complexe en place de _channels/2 points
+	void fft(complexd *data) const;
+
+	bool _isSetup;
+	size_t _channels;
+	size_t _tapsPerBranch;
+	WindowType _windowType;
+	size_t _decimation;
+
+	std::vector<double> _prototype;
+	std::vector<double> _history;    // delay line written twice, newest sample first
+	size_t _index;
+	size_t _phase;                   // input samples until the next output
+	size_t _time;                    // index of the next input sample, modulo M
+
+	std::vector<double> _branches;   // outputs of the M branches
+	std::vector<complexd> _packed;   // branches packed two by two for the real FFT
+	std::vector<size_t> _reversed;   // bit reversal of the FFT
+	std::vector<complexd> _twiddles; // exp(-2j.pi.k/M), k < M
+};
+
+#endif // __CHANNELIZER_HPP
@@ -0,0 +1,426 @@
+#include "Decimator.hpp"
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include <iostream>
+#include "globals.hpp"
+
+std::vector<double> designLowPassFIR(size_t taps, double cutoff, WindowType window_type) {
+	if (taps < 1 || cutoff <= 0.0 || cutoff >= 0.5) {
+		throw std::invalid_argument("Invalid parameters for the FIR design");
+	}
+
+	// La fenêtre est calculée sur taps+2 points pour ne pas avoir de coefficients nuls aux extrémités
+	Window window;
+	window.set(window_type, taps + 2);
+	window.setup();
+
+	std::vector<double> h(taps);
+	double center = (taps - 1) / 2.0;
+	double sum = 0.0;
+	for (size_t n = 0; n < taps; n++) {
+		double t = n - center;
+		double ideal = (t == 0.0) ? 2.0 * cutoff : std::sin(2.0 * M_PI * cutoff * t) / (M_PI * t);
+		h[n] = ideal * window.apply(1.0, n + 1);
+		sum += h[n];
+	}
+	for (double &tap : h) {
+		tap /= sum;
+	}
+	return h;
+}
+
+// Nombre de coefficients d'un filtre fenêtré par Blackman pour une bande de transition donnée
+static size_t firLength(double rate, double transition, size_t minimum) {
+	double length = 5.5 * rate / transition;
+	if (length > 255.0) length = 255.0;
+	size_t taps = static_cast<size_t>(std::ceil(length));
+	return std::max(taps, minimum);
+}
+
+// Filtre demi-bande : 4K+3 coefficients, un coefficient sur deux est nul
+static std::vector<double> designHalfband(size_t taps) {
+	while ((taps + 1) % 4 != 0) taps++;
+	std::vector<double> h = designLowPassFIR(taps, 0.25);
+	size_t center = (taps - 1) / 2;
+	for (size_t n = 0; n < taps; n++) {
+		size_t offset = (n > center) ? n - center : center - n;
+		if (offset != 0 && offset % 2 == 0) h[n] = 0.0;
+	}
+	double sum = 0.0;
+	for (double tap : h) sum += tap;
+	for (double &tap : h) tap /= sum;
+	return h;
+}
+
+// FIR de compensation de la chute du CIC dans la bande passante, décimant par 2
+static std::vector<double> designCompensationFIR(size_t taps, const CICDecimator &cic) {
+	if (taps % 2 == 0) taps++;
+
+	// Réponse désirée : 1/|H_cic| jusqu'à fs/4, nulle au-delà (échantillonnage en fréquence)
+	const size_t K = 2048;
+	std::vector<double> desired(K);
+	for (size_t k = 0; k < K; k++) {
+		double nu = (k + 0.5) / (2.0 * K);
+		desired[k] = (nu < 0.25) ? 1.0 / cic.response(nu) : 0.0;
+	}
+
+	Window window;
+	window.set(WindowType::Blackman, taps + 2);
+	window.setup();
+
+	std::vector<double> h(taps);
+	double center = (taps - 1) / 2.0;
+	double sum = 0.0;
+	for (size_t n = 0; n < taps; n++) {
+		double acc = 0.0;
+		for (size_t k = 0; k < K; k++) {
+			double nu = (k + 0.5) / (2.0 * K);
+			acc += desired[k] * std::cos(2.0 * M_PI * nu * (n - center));
+		}
+		h[n] = acc / K * window.apply(1.0, n + 1);
+		sum += h[n];
+	}
+	for (double &tap : h) {
+		tap /= sum;
+	}
+	return h;
+}
+
+std::string decimatorStageTypeToString(DecimatorStageType type) {
+	switch (type) {
+		case DecimatorStageType::CIC:              return "CIC";
+		case DecimatorStageType::COMPENSATION_FIR: return "CompensationFIR";
+		case DecimatorStageType::HALFBAND:         return "Halfband";
+		case DecimatorStageType::FIR:              return "FIR";
+		default:                                   return "Unknown";
+	}
+}
+
+/* -------------------------------------------------------------------------- */
+
+CICDecimator::CICDecimator() : _order(0), _ratio(1), _delay(1), _phase(0), _scale(1.0), _outputScale(1.0), _combIndex(0) {}
+
+bool CICDecimator::set(int order, int ratio, int differential_delay) {
+	if (order < 1 || ratio < 1 || differential_delay < 1) {
+		std::cerr << "CIC order, ratio and differential delay must be positive" << std::endl;
+		return false;
+	}
+
+	// croissance des registres : N.log2(R.M) bits
+	int growth = order * static_cast<int>(std::ceil(std::log2(static_cast<double>(ratio) * differential_delay)));
+	// bits restants pour quantifier l'entrée (|x| < 32, signe et marge compris)
+	int quantization = 62 - growth - 6;
+	if (quantization < 8) {
+		std::cerr << "CIC register growth is too large for 64 bits registers" << std::endl;
+		return false;
+	}
+
+	_order = order;
+	_ratio = ratio;
+	_delay = differential_delay;
+	_scale = std::ldexp(1.0, quantization);
+	_outputScale = 1.0 / (_scale * std::pow(static_cast<double>(ratio) * differential_delay, order));
+	reset();
+	return true;
+}
+
+void CICDecimator::reset() {
+	_integrators.assign(_order, 0);
+	_combs.assign(_order * _delay, 0);
+	_combIndex = 0;
+	_phase = 0;
+}
+
+size_t CICDecimator::process(const double *input, size_t n, double *output) {
+	size_t m = 0;
+	for (size_t i = 0; i < n; i++) {
+		// arithmétique modulo 2^64 : les débordements des intégrateurs sont compensés par les peignes
+		uint64_t acc = static_cast<uint64_t>(std::llround(input[i] * _scale));
+		for (int k = 0; k < _order; k++) {
+			_integrators[k] += acc;
+			acc = _integrators[k];
+		}
+
+		if (++_phase == _ratio) {
+			_phase = 0;
+			for (int k = 0; k < _order; k++) {
+				uint64_t &delayed = _combs[k * _delay + _combIndex];
+				uint64_t previous = delayed;
+				delayed = acc;
+				acc -= previous;
+			}
+			_combIndex = (_combIndex + 1) % _delay;
+			output[m++] = static_cast<double>(static_cast<int64_t>(acc)) * _outputScale;
+		}
+	}
+	return m;
+}
+
+double CICDecimator::response(double frequency) const {
+	// |H(nu)| = |sin(pi.M.nu) / (R.M.sin(pi.nu/R))|^N, nu normalisée à la sortie
+	double x = M_PI * frequency;
+	if (std::abs(x) < 1e-12) {
+		return 1.0;
+	}
+	double h = std::sin(_delay * x) / (_ratio * _delay * std::sin(x / _ratio));
+	return std::pow(std::abs(h), _order);
+}
+
+/* -------------------------------------------------------------------------- */
+
+FIRDecimator::FIRDecimator() : _index(0), _factor(1), _phase(0), _halfband(false) {}
+
+bool FIRDecimator::set(const std::vector<double> &taps, int factor, bool halfband) {
+	if (taps.empty() || factor < 1) {
+		std::cerr << "FIR decimator needs taps and a positive factor" << std::endl;
+		return false;
+	}
+	if (halfband && (taps.size() % 2 == 0)) {
+		std::cerr << "Halfband filter must have an odd number of taps" << std::endl;
+		return false;
+	}
+	_taps.assign(taps.rbegin(), taps.rend());
+	_factor = factor;
+	_halfband = halfband;
+	reset();
+	return true;
+}
+
+void FIRDecimator::reset() {
+	_history.assign(2 * _taps.size(), 0.0);
+	_index = 0;
+	_phase = 0;
+}
+
+size_t FIRDecimator::process(const double *input, size_t n, double *output) {
+	const size_t L = _taps.size();
+	const double *h = _taps.data();
+	size_t m = 0;
+
+	for (size_t i = 0; i < n; i++) {
+		_history[_index] = input[i];
+		_history[_index + L] = input[i];
+
+		if (++_phase == _factor) {
+			_phase = 0;
+			// les L derniers échantillons, du plus ancien au plus récent
+			const double *x = _history.data() + _index + 1;
+			double y = 0.0;
+			if (_halfband) {
+				size_t c = (L - 1) / 2;
+				y = h[c] * x[c];
+				for (size_t j = 1; j <= c; j += 2) {
+					y += h[c - j] * (x[c - j] + x[c + j]);
+				}
+			} else {
+				for (size_t k = 0; k < L; k++) {
+					y += h[k] * x[k];
+				}
+			}
+			output[m++] = y;
+		}
+
+		if (++_index == L) _index = 0;
+	}
+	return m;
+}
+
+/* -------------------------------------------------------------------------- */
+
+Decimator::Decimator() : _isSetup(false), _inputRate(0.0), _outputRate(0.0), _passband(0.0), _cicOrder(4), _decimation(1), _hasCic(false) {}
+
+bool Decimator::set(double input_rate, double output_rate, double passband, int cic_order) {
+	if (input_rate <= 0.0 || output_rate <= 0.0 || output_rate > input_rate) {
+		std::cerr << "Output rate must be positive and lower than the input rate" << std::endl;
+		return false;
+	}
+	if (passband <= 0.0 || passband >= output_rate / 2.0) {
+		std::cerr << "Passband must be positive and lower than half the output rate" << std::endl;
+		return false;
+	}
+	if (cic_order < 1) {
+		std::cerr << "CIC order must be positive" << std::endl;
+		return false;
+	}
+	double ratio = input_rate / output_rate;
+	if (std::abs(ratio - std::round(ratio)) > 1e-6 * ratio) {
+		std::cerr << "Input rate must be an integer multiple of the output rate" << std::endl;
+		return false;
+	}
+
+	_inputRate = input_rate;
+	_outputRate = output_rate;
+	_passband = passband;
+	_cicOrder = cic_order;
+	_isSetup = false;
+	return true;
+}
+
+std::vector<DecimatorStagePlan> Decimator::plan(double input_rate, double output_rate, double passband, int cic_order) {
+	std::vector<DecimatorStagePlan> stages;
+	int D = static_cast<int>(std::lround(input_rate / output_rate));
+	if (D <= 1) {
+		return stages;
+	}
+
+	int odd = D;
+	int pow2 = 0;
+	while (odd % 2 == 0) {
+		odd /= 2;
+		pow2++;
+	}
+
+	double rate = input_rate;
+	int halfbands = pow2;
+
+	if (D >= 8 && pow2 >= 1) {
+		// CIC -> FIR de compensation (/2) -> demi-bandes (/2) : le CIC prend le plus
+		// grand facteur possible tant que ses registres tiennent sur 64 bits
+		int reserved = (pow2 >= 2) ? 2 : 1;
+		int cicPow = pow2 - reserved;
+		int R = odd << cicPow;
+		while (R > 1 && R % 2 == 0 && cic_order * std::ceil(std::log2(static_cast<double>(R))) > 32) {
+			R /= 2;
+			cicPow--;
+		}
+		if (R > 1) {
+			stages.push_back({DecimatorStageType::CIC, R, static_cast<size_t>(cic_order), rate});
+			rate /= R;
+		}
+		double transition = rate / 2.0 - 2.0 * passband;
+		stages.push_back({DecimatorStageType::COMPENSATION_FIR, 2, firLength(rate, transition, 15) | 1, rate});
+		rate /= 2.0;
+		halfbands = pow2 - cicPow - 1;
+		odd = (R > 1) ? 1 : odd;
+	}
+
+	for (int i = 0; i < halfbands; i++) {
+		double transition = rate / 2.0 - 2.0 * passband;
+		size_t taps = firLength(rate, transition, 7);
+		while ((taps + 1) % 4 != 0) taps++;
+		stages.push_back({DecimatorStageType::HALFBAND, 2, taps, rate});
+		rate /= 2.0;
+	}
+
+	if (odd > 1) {
+		double transition = rate / odd - 2.0 * passband;
+		stages.push_back({DecimatorStageType::FIR, odd, firLength(rate, transition, 15) | 1, rate});
+		rate /= odd;
+	}
+
+	return stages;
+}
+
+void Decimator::setup() {
+	if (_isSetup) {
+		return;
+	}
+
+	_plan = plan(_inputRate, _outputRate, _passband, _cicOrder);
+	_firs.clear();
+	_hasCic = false;
+	_decimation = 1;
+
+	for (const DecimatorStagePlan &stage : _plan) {
+		FIRDecimator fir;
+		switch (stage.type) {
+			case DecimatorStageType::CIC:
+				if (!_cic.set(static_cast<int>(stage.taps), stage.factor)) {
+					throw std::runtime_error("Unable to set the CIC stage");
+				}
+				_hasCic = true;
+				break;
+			case DecimatorStageType::COMPENSATION_FIR:
+				fir.set(designCompensationFIR(stage.taps, _cic), stage.factor);
+				_firs.push_back(fir);
+				break;
+			case DecimatorStageType::HALFBAND:
+				fir.set(designHalfband(stage.taps), stage.factor, true);
+				_firs.push_back(fir);
+				break;
+			case DecimatorStageType::FIR:
+				fir.set(designLowPassFIR(stage.taps, 0.5 / stage.factor), stage.factor);
+				_firs.push_back(fir);
+				break;
+		}
+		_decimation *= stage.factor;
+	}
+
+	_isSetup = true;
+}
+
+void Decimator::reset() {
+	_cic.reset();
+	for (FIRDecimator &fir : _firs) {
+		fir.reset();
+	}
+}
+
+Signal Decimator::apply(const Signal &input) {
+	if (!_isSetup) {
+		throw std::invalid_argument("Decimator is not set up");
+	}
+	reset();
+	return process(input);
+}
+
+Signal Decimator::process(const Signal &input) {
+	Signal output(input.size() / _decimation + 1);
+	size_t m = process(input.data(), input.size(), output.data());
+	output.resize(m);
+	return output;
+}
+
+size_t Decimator::process(const double *input, size_t n, double *output) {
+	if (!_isSetup) {
+		throw std::invalid_argument("Decimator is not set up");
+	}
+
+	if (!_hasCic && _firs.empty()) {
+		std::copy(input, input + n, output);
+		return n;
+	}
+
+	// chaque étage écrit dans un tampon intermédiaire, le dernier directement dans la sortie
+	const double *src = input;
+	size_t count = n;
+	std::vector<double> *buffers[2] = {&_bufferA, &_bufferB};
+	int current = 0;
+	size_t remaining = _firs.size();
+
+	if (_hasCic) {
+		double *dst = output;
+		if (remaining > 0) {
+			buffers[current]->resize(count / _cic.getRatio() + 1);
+			dst = buffers[current]->data();
+		}
+		count = _cic.process(src, count, dst);
+		src = dst;
+		current ^= 1;
+	}
+
+	for (FIRDecimator &fir : _firs) {
+		remaining--;
+		double *dst = output;
+		if (remaining > 0) {
+			buffers[current]->resize(count + 1);
+			dst = buffers[current]->data();
+		}
+		count = fir.process(src, count, dst);
+		src = dst;
+		current ^= 1;
+	}
+
+	return count;
+}
+
+void Decimator::printPlan() const {
+	std::cout << "Decimation " << _decimation << " : " << _inputRate << " Hz -> " << getOutputRate() << " Hz" << std::endl;
+	for (const DecimatorStagePlan &stage : _plan) {
+		std::cout << "  " << decimatorStageTypeToString(stage.type)
+		          << " /" << stage.factor
+		          << " (" << stage.taps << (stage.type == DecimatorStageType::CIC ? " sections" : " taps") << ")"
+		          << " at " << stage.inputRate << " Hz" << std::endl;
+	}
+}
@@ -0,0 +1,240 @@
+#ifndef __DECIMATOR_HPP
+#define __DECIMATOR_HPP
+
+#include <vector>
+#include <cstdint>
+#include <string>
+#include "Signal.hpp"
+#include "Window.hpp"
+
+/**
+ * @brief Design a linear phase low pass FIR filter with the window method
+ * @param[in] taps Number of taps (odd values keep an integer group delay)
+ * @param[in] cutoff Cutoff frequency normalized to the sampling frequency (0 < cutoff < 0.5)
+ * @param[in] window_type Window applied to the ideal impulse response
+ * @return Taps of the filter, normalized to a unity DC gain
+ */
+std::vector<double> designLowPassFIR(size_t taps, double cutoff, WindowType window_type = WindowType::Blackman);
+
+/**
+ * @brief Type of a decimation stage
+ */
+enum class DecimatorStageType {
+	CIC,              // Cascaded integrator-comb
+	COMPENSATION_FIR, // FIR compensating the passband droop of the CIC
+	HALFBAND,         // Halfband FIR decimating by 2
+	FIR,              // Generic low pass FIR
+};
+
+/**
+ * @brief Description of one stage of a decimation chain
+ */
+struct DecimatorStagePlan {
+	DecimatorStageType type;
+	int factor;        // Decimation factor of the stage
+	size_t taps;       // Number of taps (FIR stages) or order (CIC)
+	double inputRate;  // Sampling frequency at the input of the stage
+};
+
+/**
+ * @brief Cascaded integrator-comb decimator
+ * @details Integrators and combs run on 64 bits integers with wrap-around arithmetic,
+ *          which keeps the filter exact whatever the length of the stream.
+ *          The gain (R*M)^N of the filter is removed from the output.
+ */
+class CICDecimator {
+public:
+	CICDecimator();
+
+	/**
+	 * @brief Set the parameters of the CIC
+	 * @param[in] order Number of integrator and comb sections (N)
+	 * @param[in] ratio Decimation factor (R)
+	 * @param[in] differential_delay Differential delay of the combs (M)
+	 * @return true if the parameters are valid, false otherwise
+	 */
+	bool set(int order, int ratio, int differential_delay = 1);
+
+	/**
+	 * @brief Reset the integrators and the combs
+	 */
+	void reset();
+
+	/**
+	 * @brief Decimate a block of samples, keeping the state between calls
+	 * @param[in] input Input samples
+	 * @param[in] n Number of input samples
+	 * @param[out] output Output samples, must hold at least n / ratio + 1 samples
+	 * @return Number of output samples
+	 */
+	size_t process(const double *input, size_t n, double *output);
+
+	/**
+	 * @brief Magnitude response of the CIC (without its gain)
+	 * @param[in] frequency Frequency normalized to the output sampling frequency
+	 */
+	double response(double frequency) const;
+
+	int getRatio() const { return _ratio; }
+
+private:
+	int _order;
+	int _ratio;
+	int _delay;
+	int _phase;          // position in the decimation period
+	double _scale;       // quantization of the input
+	double _outputScale; // removes the quantization and the gain of the CIC
+	std::vector<uint64_t> _integrators;
+	std::vector<uint64_t> _combs; // M delayed values of each comb
+	size_t _combIndex;
+};
+
+/**
+ * @brief Polyphase FIR decimator
+ * @details Outputs are only computed at the output rate. Halfband filters use
+ *          the symmetry of their taps and skip the null taps.
+ */
+class FIRDecimator {
+public:
+	FIRDecimator();
+
+	/**
+	 * @brief Set the taps and the decimation factor
+	 * @param[in] taps Taps of the filter
+	 * @param[in] factor Decimation factor
+	 * @param[in] halfband True if the taps are a halfband filter (every other tap is null)
+	 * @return true if the parameters are valid, false otherwise
+	 */
+	bool set(const std::vector<double> &taps, int factor, bool halfband = false);
+
+	/**
+	 * @brief Reset the delay line
+	 */
+	void reset();
+
+	/**
+	 * @brief Decimate a block of samples, keeping the state between calls
+	 * @param[in] input Input samples
+	 * @param[in] n Number of input samples
+	 * @param[out] output Output samples, must hold at least n / factor + 1 samples
+	 * @return Number of output samples
+	 */
+	size_t process(const double *input, size_t n, double *output);
+
+	const std::vector<double> &getTaps() const { return _taps; }
+
+private:
+	std::vector<double> _taps;     // taps in reversed order (oldest sample first)
+	std::vector<double> _history;  // delay line written twice to stay contiguous
+	size_t _index;
+	int _factor;
+	int _phase;
+	bool _halfband;
+};
+
+/**
+ * @brief Multistage decimation chain (CIC, compensation FIR and halfband filters)
+ * @details The stages are planned automatically from the input rate, the requested
+ *          output rate and the passband to preserve. The chain keeps its state
+ *          between calls to process(), so that consecutive blocks can be streamed.
+ */
+class Decimator {
+public:
+	Decimator();
+
+	/**
+	 * @brief Set the parameters of the decimation chain
+	 * @param[in] input_rate Sampling frequency of the input
+	 * @param[in] output_rate Requested sampling frequency of the output
+	 * @param[in] passband Highest frequency to preserve
+	 * @param[in] cic_order Order of the CIC stage
+	 * @return true if the parameters are valid, false otherwise
+	 */
+	bool set(double input_rate, double output_rate, double passband, int cic_order = 4);
+
+	/**
+	 * @brief Build the stages of the chain
+	 */
+	void setup();
+
+	/**
+	 * @brief Check if the decimator is setup
+	 */
+	bool isSetup() const { return _isSetup; }
+
+	/**
+	 * @brief Reset the state of all the stages
+	 */
+	void reset();
+
+	/**
+	 * @brief Decimate a complete signal from a null state
+	 * @param[in] input Input signal
+	 * @return Decimated signal
+	 */
+	Signal apply(const Signal &input);
+
+	/**
+	 * @brief Decimate a block, following the previous one (streaming mode)
+	 * @param[in] input Input signal
+	 * @return Decimated signal
+	 */
+	Signal process(const Signal &input);
+
+	/**
+	 * @brief Decimate a block of samples, following the previous one (streaming mode)
+	 * @param[in] input Input samples
+	 * @param[in] n Number of input samples
+	 * @param[out] output Output samples, must hold at least n / getDecimation() + 1 samples
+	 * @return Number of output samples
+	 */
+	size_t process(const double *input, size_t n, double *output);
+
+	/**
+	 * @brief Plan the stages of a decimation chain
+	 * @param[in] input_rate Sampling frequency of the input
+	 * @param[in] output_rate Requested sampling frequency of the output
+	 * @param[in] passband Highest frequency to preserve
+	 * @param[in] cic_order Order of the CIC stage
+	 * @return List of the stages
+	 */
+	static std::vector<DecimatorStagePlan> plan(double input_rate, double output_rate, double passband, int cic_order = 4);
+
+	/**
+	 * @brief Total decimation factor of the chain
+	 */
+	int getDecimation() const { return _decimation; }
+
+	/**
+	 * @brief Sampling frequency of the output
+	 */
+	double getOutputRate() const { return _inputRate / _decimation; }
+
+	/**
+	 * @brief Stages of the chain
+	 */
+	const std::vector<DecimatorStagePlan> &getPlan() const { return _plan; }
+
+	/**
+	 * @brief Print the stages of the chain (for debugging purposes)
+	 */
+	void printPlan() const;
+
+private:
+	bool _isSetup;
+	double _inputRate;
+	double _outputRate;
+	double _passband;
+	int _cicOrder;
+	int _decimation;
+
+	std::vector<DecimatorStagePlan> _plan;
+	CICDecimator _cic;
+	std::vector<FIRDecimator> _firs;
+	bool _hasCic;
+	std::vector<double> _bufferA, _bufferB; // buffers between the stages
+};
+
+std::string decimatorStageTypeToString(DecimatorStageType type);
+
+#endif // __DECIMATOR_HPP
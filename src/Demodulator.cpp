@@ -1,53 +1,300 @@
 #include "Demodulator.hpp"
-#include "rp.h"
 #include "utils.hpp"
+#include "Denormal.hpp"
+#include <algorithm>
 
-Demodulator::Demodulator() : _freqFilter(0.0), _freqOscillator(0.0), _filter(), _isSetup(false)
+Demodulator::Demodulator() : _freqFilter(0.0), _freqOscillator(0.0), _samplingFrequency(0.0), _filter(), _sinus(nullptr), _cosinus(nullptr), _generatedSinus(0), _generatedCosinus(0), _generatedFrequency(0.0), _generatedSampling(0.0), _zeroPhase(false), _useConverter(false), _isSetup(false)
 {}
 
-Demodulator::Demodulator(double freq_filter, double freq_oscillator) : _freqFilter(freq_filter), _freqOscillator(freq_oscillator), _filter(), _isSetup(false)
+Demodulator::Demodulator(double freq_filter, double freq_oscillator) : _freqFilter(freq_filter), _freqOscillator(freq_oscillator), _samplingFrequency(0.0), _filter(), _sinus(nullptr), _cosinus(nullptr), _generatedSinus(0), _generatedCosinus(0), _generatedFrequency(0.0), _generatedSampling(0.0), _zeroPhase(false), _useConverter(false), _isSetup(false)
 {
     if (_filter.set(4, _freqFilter, 0, FilterGabarit::LOW_PASS, AnalogFilter::BUTTERWORTH) == false) {
         throw std::invalid_argument("Error while setting filter");
     }
 }
 
-bool Demodulator::set(double freq_filter, double freq_oscillator) {
+bool Demodulator::set(double freq_filter, double freq_oscillator, double sampling_frequency) {
 	_freqFilter = freq_filter;
 	_freqOscillator = freq_oscillator;
-	return _filter.set(4, _freqFilter, 0, FilterGabarit::LOW_PASS, AnalogFilter::BUTTERWORTH);
+	_samplingFrequency = sampling_frequency;
+	_sinus = nullptr;
+	_cosinus = nullptr;
+	return _filter.set(4, _freqFilter, 0, FilterGabarit::LOW_PASS, AnalogFilter::BUTTERWORTH, 0, 0, _samplingFrequency);
 }
 
 void Demodulator::setup() {
 	_filter.setup();
+	_bank.setup(_filter);
+	_dualBank.setup(_filter);
 	_isSetup = true;
 }
 
+void Demodulator::setup(const std::vector<Biquad> &sections) {
+	_filter.setup(sections);
+	_bank.setup(sections);
+	_dualBank.setup(sections);
+	_isSetup = true;
+}
+
+void Demodulator::setReference(const Signal *sinus, const Signal *cosinus) {
+	_sinus = sinus;
+	_cosinus = cosinus;
+}
+
+void Demodulator::references(size_t size, const Signal *&sinus, const Signal *&cosinus) {
+	sinus = _sinus;
+	cosinus = _cosinus;
+	if (sinus == nullptr || cosinus == nullptr || sinus->size() != size || cosinus->size() != size) {
+		// les tables ne sont recalculées que si la fréquence, fs ou la taille change
+		const double fs = (_samplingFrequency > 0.0) ? _samplingFrequency : SAMPLING_FREQUENCY;
+		if (_generatedSinus.size() != size || _generatedFrequency != _freqOscillator || _generatedSampling != fs) {
+			_generatedSinus.resize(size);
+			_generatedCosinus.resize(size);
+			const double step = 2.0 * M_PI * _freqOscillator / fs;
+			for (size_t i = 0; i < size; i++) {
+				_generatedSinus[i] = std::sin(step * static_cast<double>(i));
+				_generatedCosinus[i] = std::sin(step * static_cast<double>(i) + M_PI/2.0);
+			}
+			_generatedFrequency = _freqOscillator;
+			_generatedSampling = fs;
+		}
+		sinus = &_generatedSinus;
+		cosinus = &_generatedCosinus;
+	}
+}
+
+template <size_t N>
+void Demodulator::filterProducts(FilterBank<N> &bank, size_t size) {
+	if (_zeroPhase) {
+		// filtrage aller-retour voie par voie
+		Signal stream(size);
+		for (size_t c = 0; c < N; c++) {
+			for (size_t i = 0; i < size; i++) {
+				stream[i] = _buffer[i*N + c];
+			}
+			_filter.filtfilt(stream.data(), stream.data(), size);
+			for (size_t i = 0; i < size; i++) {
+				_buffer[i*N + c] = stream[i];
+			}
+		}
+	} else {
+		// une seule passe pour toutes les voies
+		bank.reset();
+		bank.process(_buffer.data(), size);
+	}
+}
+
+void Demodulator::setPolar(PolarPrecision precision, bool unwrap) {
+	_converter.set(precision, unwrap);
+	_useConverter = (precision != PolarPrecision::EXACT) || unwrap;
+}
+
+void Demodulator::polar(size_t offset, size_t stride, Signal &outputAmplitude, Signal &outputPhase, bool rms) {
+	if (_useConverter) {
+		// conversion vectorisée, la phase est déroulée depuis le début du signal
+		_converter.reset();
+		_converter.process(_buffer.data() + offset, stride, outputAmplitude.data(), outputPhase.data(), outputAmplitude.size());
+		const double scale = rms ? sqrt(2.0) : 2.0;
+		for (double &amplitude : outputAmplitude) {
+			amplitude *= scale;
+		}
+		return;
+	}
+
+	const double *product = _buffer.data() + offset;
+	for (size_t i = 0; i < outputAmplitude.size(); i++, product += stride) {
+		double A = product[0];
+		double Phi = product[1];
+		if (rms) {
+			outputAmplitude[i] = std::sqrt(A*A + Phi*Phi)*sqrt(2.0);
+		} else {
+			outputAmplitude[i] = std::sqrt(2.0*A*A + 2.0*Phi*Phi)*sqrt(2.0);
+		}
+		outputPhase[i] = (A != 0.0)? modulo(atan2(Phi, A), 2*M_PI) : 0.0;
+	}
+}
+
 void Demodulator::apply(Signal &signal, Signal &outputAmplitude, Signal &outputPhase, bool rms) {
 	if (_isSetup == false) {
 		throw std::invalid_argument("Demodulator not setup");
 	}
 
-	Signal sinus(signal.size());
-	Signal cosinus(signal.size());
-	outputAmplitude.resize(signal.size());
-	outputPhase.resize(signal.size());
+	const size_t size = signal.size();
+	outputAmplitude.resize(size);
+	outputPhase.resize(size);
 
-	sinus.generateWaveform(RP_WAVEFORM_SINE, 1.0, _freqOscillator);
-	cosinus.generateWaveform(RP_WAVEFORM_SINE, 1.0, _freqOscillator, M_PI/2.0);
+	const Signal *sinus, *cosinus;
+	references(size, sinus, cosinus);
 
-	Signal tempA = signal * sinus;
-	tempA = _filter.apply(tempA);
+	// produits entrelacés (A, Phi)
+	_buffer.resize(2*size);
+	for (size_t i = 0; i < size; i++) {
+		_buffer[2*i]     = signal[i] * (*sinus)[i];
+		_buffer[2*i + 1] = signal[i] * (*cosinus)[i];
+	}
+	filterProducts(_bank, size);
 
-	Signal tempPhi = signal * cosinus;
-	tempPhi = _filter.apply(tempPhi);
-	
-	for (size_t i = 0; i<tempPhi.size(); i++) {
-		if (rms) {
-			outputAmplitude[i] = std::sqrt(tempA[i]*tempA[i] + tempPhi[i]*tempPhi[i])*sqrt(2.0);
+	polar(0, 2, outputAmplitude, outputPhase, rms);
+}
+
+void Demodulator::dualProducts(const Signal &signal1, const Signal &signal2, const Signal &sinus, const Signal &cosinus) {
+	const size_t size = signal1.size();
+
+	// produits entrelacés (A1, Phi1, A2, Phi2)
+	_buffer.resize(4*size);
+	for (size_t i = 0; i < size; i++) {
+		double s = sinus[i];
+		double c = cosinus[i];
+		_buffer[4*i]     = signal1[i] * s;
+		_buffer[4*i + 1] = signal1[i] * c;
+		_buffer[4*i + 2] = signal2[i] * s;
+		_buffer[4*i + 3] = signal2[i] * c;
+	}
+	filterProducts(_dualBank, size);
+}
+
+void Demodulator::apply(Signal &signal1, Signal &signal2, Signal &outputAmplitude1, Signal &outputPhase1, Signal &outputAmplitude2, Signal &outputPhase2, bool rms) {
+	if (_isSetup == false) {
+		throw std::invalid_argument("Demodulator not setup");
+	}
+	if (signal1.size() != signal2.size()) {
+		throw std::invalid_argument("The demodulated signals must have the same size");
+	}
+
+	const size_t size = signal1.size();
+	outputAmplitude1.resize(size);
+	outputPhase1.resize(size);
+	outputAmplitude2.resize(size);
+	outputPhase2.resize(size);
+
+	const Signal *sinus, *cosinus;
+	references(size, sinus, cosinus);
+
+	dualProducts(signal1, signal2, *sinus, *cosinus);
+
+	polar(0, 4, outputAmplitude1, outputPhase1, rms);
+	polar(2, 4, outputAmplitude2, outputPhase2, rms);
+}
+
+template <size_t N, typename Accumulator>
+void Demodulator::reduce(const std::array<const double *, N> &signals, size_t size, size_t start_index, Accumulator &&accumulate) {
+	const Signal *sinus, *cosinus;
+	references(size, sinus, cosinus);
+
+	if (_zeroPhase) {
+		// le filtrage aller-retour a besoin des produits complets
+		_buffer.resize(2*N*size);
+		for (size_t i = 0; i < size; i++) {
+			for (size_t c = 0; c < N; c++) {
+				_buffer[2*N*i + 2*c]     = signals[c][i] * (*sinus)[i];
+				_buffer[2*N*i + 2*c + 1] = signals[c][i] * (*cosinus)[i];
+			}
+		}
+		if constexpr (N == 1) {
+			filterProducts(_bank, size);
 		} else {
-			outputAmplitude[i] = std::sqrt(2.0*tempA[i]*tempA[i] + 2.0*tempPhi[i]*tempPhi[i])*sqrt(2.0);
+			filterProducts(_dualBank, size);
+		}
+		for (size_t i = start_index; i < size; i++) {
+			accumulate(_buffer.data() + 2*N*i);
+		}
+		return;
+	}
+
+	// une seule passe : mélange, filtrage section par section et accumulation, sans tampon
+	const std::vector<Biquad> &sections = _filter.getSections();
+	std::vector<std::array<double, 2*N>> state(2*sections.size(), std::array<double, 2*N>{});
+	std::array<double, 2*N> v;
+
+	DenormalGuard guard;
+
+	for (size_t i = 0; i < size; i++) {
+		const double s = (*sinus)[i];
+		const double c = (*cosinus)[i];
+		for (size_t k = 0; k < N; k++) {
+			v[2*k]     = signals[k][i] * s;
+			v[2*k + 1] = signals[k][i] * c;
+		}
+		for (size_t q = 0; q < sections.size(); q++) {
+			const Biquad &b = sections[q];
+			std::array<double, 2*N> &z1 = state[2*q];
+			std::array<double, 2*N> &z2 = state[2*q + 1];
+			for (size_t k = 0; k < 2*N; k++) {
+				double y = b.b0 * v[k] + z1[k];
+				z1[k] = b.b1 * v[k] - b.a1 * y + z2[k];
+				z2[k] = b.b2 * v[k] - b.a2 * y;
+				v[k] = y;
+			}
+		}
+		if (i >= start_index) {
+			accumulate(v.data());
 		}
-		outputPhase[i] = (tempA[i] != 0.0)? modulo(atan2(tempPhi[i], tempA[i]), 2*M_PI) : 0.0;
 	}
 }
+
+DemodulationEstimate Demodulator::estimate(const Signal &signal, size_t start_index, bool rms) {
+	if (_isSetup == false) {
+		throw std::invalid_argument("Demodulator not setup");
+	}
+
+	const size_t size = signal.size();
+	if (start_index >= size) {
+		throw std::invalid_argument("The start index must be lower than the size of the signal");
+	}
+
+	// sommes de Z et de |Z|^2 sur le régime permanent, avec Z = A + j.Phi
+	double sumA = 0.0, sumPhi = 0.0, sumNorm = 0.0;
+	reduce<1>({signal.data()}, size, start_index, [&](const double *product) {
+		sumA   += product[0];
+		sumPhi += product[1];
+		sumNorm += product[0]*product[0] + product[1]*product[1];
+	});
+
+	// même échelle que polar() : sqrt(2).|Z| en RMS, 2.|Z| sinon
+	const double n = static_cast<double>(size - start_index);
+	const double scale = rms ? sqrt(2.0) : 2.0;
+	complexd mean(sumA / n, sumPhi / n);
+	DemodulationEstimate result;
+	result.value = scale * mean;
+	result.variance = scale * scale * std::max(sumNorm / n - std::norm(mean), 0.0);
+	result.count = size - start_index;
+	return result;
+}
+
+DualDemodulation Demodulator::applyRatio(const Signal &input, const Signal &output, size_t start_index, bool rms) {
+	if (_isSetup == false) {
+		throw std::invalid_argument("Demodulator not setup");
+	}
+	if (input.size() != output.size()) {
+		throw std::invalid_argument("The demodulated signals must have the same size");
+	}
+
+	const size_t size = input.size();
+	if (start_index >= size) {
+		throw std::invalid_argument("The start index must be lower than the size of the signals");
+	}
+
+	// accumulation de Z2.conj(Z1) et |Z1|^2, avec Z = A + j.Phi
+	double crossRe = 0.0, crossIm = 0.0, power1 = 0.0;
+	double sumAmplitude1 = 0.0, sumAmplitude2 = 0.0;
+	reduce<2>({input.data(), output.data()}, size, start_index, [&](const double *product) {
+		double A1 = product[0], Phi1 = product[1];
+		double A2 = product[2], Phi2 = product[3];
+		double norm1 = A1*A1 + Phi1*Phi1;
+		double norm2 = A2*A2 + Phi2*Phi2;
+		crossRe += A2*A1 + Phi2*Phi1;
+		crossIm += Phi2*A1 - A2*Phi1;
+		power1 += norm1;
+		sumAmplitude1 += std::sqrt(norm1);
+		sumAmplitude2 += std::sqrt(norm2);
+	});
+
+	// même échelle que polar() : sqrt(2).|Z| en RMS, 2.|Z| sinon
+	const double n = static_cast<double>(size - start_index);
+	const double scale = rms ? sqrt(2.0) : 2.0;
+	DualDemodulation result;
+	result.ratio = (power1 > 0.0) ? complexd(crossRe, crossIm) / power1 : complexd(0.0, 0.0);
+	result.amplitude1 = scale * sumAmplitude1 / n;
+	result.amplitude2 = scale * sumAmplitude2 / n;
+	return result;
+}
\ No newline at end of file
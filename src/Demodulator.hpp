@@ -3,8 +3,49 @@
 
 #include <iostream>
 #include <complex>
+#include <array>
 #include "Signal.hpp"
 #include "Filter.hpp"
+#include "FilterBank.hpp"
+#include "Polar.hpp"
+
+/**
+ * @brief Result of the demodulation of two channels at the same frequency
+ */
+struct DualDemodulation {
+	complexd ratio;    // H = Y/X, estimated by sum(Z2.conj(Z1)) / sum(|Z1|^2)
+	double amplitude1; // mean amplitude of the first channel (X)
+	double amplitude2; // mean amplitude of the second channel (Y)
+
+	/**
+	 * @brief Gain |H| of the second channel relative to the first one
+	 */
+	double getGain() const { return std::abs(ratio); }
+
+	/**
+	 * @brief Phase of the second channel relative to the first one, in ]-pi, pi]
+	 */
+	double getPhase() const { return std::arg(ratio); }
+};
+
+/**
+ * @brief Result of the demodulation of a signal reduced to a single value
+ */
+struct DemodulationEstimate {
+	complexd value;  // mean of A + j.Phi, scaled so that |value| is the amplitude and arg(value) the phase
+	double variance; // variance of A + j.Phi around the mean over the window, same scale
+	size_t count;    // number of samples in the window
+
+	double getAmplitude() const { return std::abs(value); }
+	double getPhase() const { return std::arg(value); }
+
+	/**
+	 * @brief Standard deviation of the amplitude and phase fluctuations, relative to the amplitude
+	 * @note The filtered samples are correlated, the error on the mean is larger than
+	 *       sqrt(variance/count)
+	 */
+	double getRelativeDeviation() const { return (std::abs(value) > 0.0) ? std::sqrt(variance) / std::abs(value) : 0.0; }
+};
 
 class Demodulator {
 public:
@@ -15,15 +56,49 @@ public:
 	 * @brief Set the parameters of the demodulator
 	 * @param freq_filter Frequency of the filter
 	 * @param freq_oscillator Frequency of the oscillator
+	 * @param sampling_frequency Sampling frequency of the signals (0 : SAMPLING_FREQUENCY)
 	 * @return true if the parameters are valid, false otherwise
+	 * @note The reference tables given to setReference() are forgotten
 	 */
-	bool set(double freq_filter, double freq_oscillator);
+	bool set(double freq_filter, double freq_oscillator, double sampling_frequency = 0.0);
 
 	/**
 	 * @brief Setup the demodulator
 	 */
 	void setup();
 
+	/**
+	 * @brief Setup the demodulator with a filter already designed
+	 * @param sections Second order sections of the low pass filter
+	 */
+	void setup(const std::vector<Biquad> &sections);
+
+	/**
+	 * @brief Use precomputed reference tables instead of generating the oscillator at each call
+	 * @param sinus Sine table at the oscillator frequency (nullptr to generate it again)
+	 * @param cosinus Cosine table at the oscillator frequency (nullptr to generate it again)
+	 * @note The tables are not copied and must outlive the calls to apply(). They are only
+	 *       used when their size matches the size of the demodulated signal. Otherwise the
+	 *       demodulator generates its own tables, and keeps them as long as the frequency of
+	 *       the oscillator, the sampling frequency and the size of the signals do not change.
+	 */
+	void setReference(const Signal *sinus, const Signal *cosinus);
+
+	/**
+	 * @brief Filter the mixed signals without phase shift (forward-backward filtering)
+	 * @param zero_phase True to use IIRFilter::filtfilt(), false for the causal filter
+	 * @note The transient at the beginning of the signal is shorter, and the ripple at
+	 *       twice the oscillator frequency is attenuated twice
+	 */
+	void setZeroPhase(bool zero_phase) { _zeroPhase = zero_phase; }
+
+	/**
+	 * @brief Set how apply() converts the filtered products to amplitude and phase
+	 * @param precision EXACT (default) uses std::atan2, the other precisions a vectorized polynomial
+	 * @param unwrap True to remove the 2.pi jumps of the output phase within each call
+	 */
+	void setPolar(PolarPrecision precision, bool unwrap = false);
+
 	/**
 	 * @brief Demodulate a signal
 	 * @param signal Input signal
@@ -32,9 +107,75 @@ public:
 	 * @param rms If true, output amplitude will be the RMS value of the signal
 	 */
 	void apply(Signal &signal, Signal &outputAmplitude, Signal &outputPhase, bool rms = false);
+
+	/**
+	 * @brief Demodulate two signals sampled together (CH1 and CH2) at the same frequency
+	 * @param signal1 First input signal
+	 * @param signal2 Second input signal, of the same size
+	 * @param outputAmplitude1 Output signal containing amplitude of the first signal
+	 * @param outputPhase1 Output signal containing phase of the first signal
+	 * @param outputAmplitude2 Output signal containing amplitude of the second signal
+	 * @param outputPhase2 Output signal containing phase of the second signal
+	 * @param rms If true, output amplitudes will be the RMS values of the signals
+	 * @note The four mixed signals are filtered in a single pass of a FilterBank<4>
+	 */
+	void apply(Signal &signal1, Signal &signal2, Signal &outputAmplitude1, Signal &outputPhase1, Signal &outputAmplitude2, Signal &outputPhase2, bool rms = false);
+
+	/**
+	 * @brief Demodulate two signals sampled together and compare them, without output signals
+	 * @param input First signal X (e.g. the excitation, CH1)
+	 * @param output Second signal Y, of the same size (e.g. the response, CH2)
+	 * @param start_index First sample used in the estimation (end of the transient)
+	 * @param rms If true, the mean amplitudes will be RMS values
+	 * @return Complex ratio H = Y/X and the mean amplitudes of both channels
+	 * @details Both channels are mixed with the same references and filtered in a single pass
+	 *          of a FilterBank<4>. The complex outputs Z1, Z2 are accumulated from start_index,
+	 *          and the phase difference is taken from sum(Z2.conj(Z1)), so it does not wrap
+	 *          around when the phases of the channels are near +-pi.
+	 */
+	DualDemodulation applyRatio(const Signal &input, const Signal &output, size_t start_index = 0, bool rms = false);
+
+	/**
+	 * @brief Demodulate a signal and reduce it to its mean value (integrate and dump)
+	 * @param signal Input signal
+	 * @param start_index First sample of the window (end of the transient)
+	 * @param rms If true, the amplitude will be the RMS value of the signal
+	 * @return Mean of the complex output over the window, and its variance
+	 * @details Mixing, filtering and accumulation run in a single pass, without output
+	 *          signals and without amplitude or phase conversion per sample. The phase of
+	 *          the estimate, std::arg(value), is in ]-pi, pi] like the phase apply() gives.
+	 */
+	DemodulationEstimate estimate(const Signal &signal, size_t start_index = 0, bool rms = false);
 private:
+	// tables de référence : précalculées si leur taille convient, générées (une fois) sinon
+	void references(size_t size, const Signal *&sinus, const Signal *&cosinus);
+
+	// filtrage des N produits entrelacés de _buffer
+	template <size_t N>
+	void filterProducts(FilterBank<N> &bank, size_t size);
+
+	// mélange, filtrage et accumulation en une passe des N signaux (produits filtrés (A, Phi) de chaque signal)
+	template <size_t N, typename Accumulator>
+	void reduce(const std::array<const double *, N> &signals, size_t size, size_t start_index, Accumulator &&accumulate);
+
+	// produits (A1, Phi1, A2, Phi2) filtrés des deux signaux dans _buffer
+	void dualProducts(const Signal &signal1, const Signal &signal2, const Signal &sinus, const Signal &cosinus);
+
+	// amplitude et phase à partir des produits (A, Phi) entrelacés
+	void polar(size_t offset, size_t stride, Signal &outputAmplitude, Signal &outputPhase, bool rms);
+
 	double _freqFilter, _freqOscillator;
+	double _samplingFrequency; // 0 : SAMPLING_FREQUENCY
 	IIRFilter _filter;
+	FilterBank<2> _bank;       // A, Phi
+	FilterBank<4> _dualBank;   // A1, Phi1, A2, Phi2
+	std::vector<double> _buffer;
+	const Signal *_sinus, *_cosinus;
+	Signal _generatedSinus, _generatedCosinus; // cache of the tables generated by references()
+	double _generatedFrequency, _generatedSampling;
+	bool _zeroPhase;
+	PolarConverter _converter;
+	bool _useConverter;
 	bool _isSetup;
 };
 
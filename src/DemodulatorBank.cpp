@@ -0,0 +1,267 @@
+#include "DemodulatorBank.hpp"
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include <iostream>
+#include "Denormal.hpp"
+#include "utils.hpp"
+
+DemodulatorBank::DemodulatorBank() : _freqFilter(0.0), _decimation(1), _filter(), _fundamentalFrequency(0.0), _fundamental(1.0), _fundamentalRotation(1.0), _isSetup(false)
+{}
+
+bool DemodulatorBank::set(const std::vector<double> &frequencies, double freq_filter, size_t decimation) {
+	if (frequencies.empty()) {
+		std::cerr << "The demodulator bank needs at least one frequency" << std::endl;
+		return false;
+	}
+	for (double f : frequencies) {
+		if (f < 0.0) {
+			std::cerr << "The frequencies of the oscillators must be positive" << std::endl;
+			return false;
+		}
+		if (f >= SAMPLING_FREQUENCY / 2.0) {
+			std::cerr << "The frequency " << f << " Hz is not below the Nyquist frequency (" << SAMPLING_FREQUENCY / 2.0 << " Hz)" << std::endl;
+			return false;
+		}
+	}
+	if (decimation < 1) {
+		std::cerr << "The decimation must be at least 1" << std::endl;
+		return false;
+	}
+
+	_frequencies = frequencies;
+	_harmonics.clear();
+	_freqFilter = freq_filter;
+	_decimation = decimation;
+	_isSetup = false;
+	return _filter.set(4, _freqFilter, 0, FilterGabarit::LOW_PASS, AnalogFilter::BUTTERWORTH);
+}
+
+bool DemodulatorBank::setHarmonics(double fundamental, const std::vector<int> &harmonics, double freq_filter, size_t decimation) {
+	if (fundamental <= 0.0 || harmonics.empty()) {
+		std::cerr << "The fundamental frequency and at least one harmonic must be given" << std::endl;
+		return false;
+	}
+	std::vector<int> orders = harmonics;
+	std::sort(orders.begin(), orders.end());
+	orders.erase(std::unique(orders.begin(), orders.end()), orders.end());
+	if (orders.front() < 1) {
+		std::cerr << "The harmonic orders must be positive" << std::endl;
+		return false;
+	}
+
+	std::vector<double> frequencies;
+	for (int h : orders) {
+		frequencies.push_back(h * fundamental);
+	}
+	if (!set(frequencies, freq_filter, decimation)) {
+		return false;
+	}
+	_harmonics = orders;
+	_fundamentalFrequency = fundamental;
+	return true;
+}
+
+void DemodulatorBank::mixHarmonics(const double *x, size_t count) {
+	const size_t P = _phasorRe.size();
+	const size_t L = 2 * P;
+	double *__restrict br = _baseRe.data();
+	double *__restrict bi = _baseIm.data();
+	double *__restrict pr = _powerRe.data();
+	double *__restrict pi = _powerIm.data();
+
+	// un seul oscillateur, à la fréquence fondamentale
+	for (size_t i = 0; i < count; i++) {
+		br[i] = _fundamental.real();
+		bi[i] = _fundamental.imag();
+		_fundamental *= _fundamentalRotation;
+	}
+	_fundamental /= std::abs(_fundamental);
+
+	// multiplication de l'angle : exp(j.h.wn) = exp(j.(h-1).wn).exp(j.wn), sans dépendance d'un échantillon à l'autre
+	std::copy(br, br + count, pr);
+	std::copy(bi, bi + count, pi);
+	int order = 1;
+	for (size_t k = 0; k < _harmonics.size(); k++) {
+		for (; order < _harmonics[k]; order++) {
+			for (size_t i = 0; i < count; i++) {
+				double r = pr[i] * br[i] - pi[i] * bi[i];
+				pi[i]    = pr[i] * bi[i] + pi[i] * br[i];
+				pr[i]    = r;
+			}
+		}
+		double *v = _block.data() + k;
+		for (size_t i = 0; i < count; i++, v += L) {
+			v[0] = x[i] * pi[i];
+			v[P] = x[i] * pr[i];
+		}
+	}
+}
+
+void DemodulatorBank::setup() {
+	_filter.setup();
+	setup(_filter.getSections());
+}
+
+void DemodulatorBank::setup(const std::vector<Biquad> &sections) {
+	if (_frequencies.empty()) {
+		throw std::invalid_argument("Demodulator bank not set");
+	}
+	if (sections.empty()) {
+		throw std::invalid_argument("The demodulator bank needs at least one section");
+	}
+	for (double f : _frequencies) {
+		if (f >= SAMPLING_FREQUENCY / 2.0) {
+			throw std::invalid_argument("The frequencies of the oscillators must be below the Nyquist frequency");
+		}
+	}
+	_sections = sections;
+
+	// voies complétées à un multiple de LANES, pour des boucles internes de longueur fixe
+	const size_t K = _frequencies.size();
+	const size_t P = (K + LANES - 1) / LANES * LANES;
+	_phasorRe.assign(P, 0.0);
+	_phasorIm.assign(P, 0.0);
+	_rotationRe.assign(P, 1.0);
+	_rotationIm.assign(P, 0.0);
+	for (size_t k = 0; k < K; k++) {
+		double w = 2.0 * M_PI * _frequencies[k] / SAMPLING_FREQUENCY;
+		_rotationRe[k] = std::cos(w);
+		_rotationIm[k] = std::sin(w);
+	}
+	_block.assign(BLOCK * 2 * P, 0.0);
+	if (!_harmonics.empty()) {
+		_fundamentalRotation = std::polar(1.0, 2.0 * M_PI * _fundamentalFrequency / SAMPLING_FREQUENCY);
+		_powerRe.resize(BLOCK);
+		_powerIm.resize(BLOCK);
+		_baseRe.resize(BLOCK);
+		_baseIm.resize(BLOCK);
+	}
+	_state.resize(2 * _sections.size() * 2 * P);
+	_isSetup = true;
+}
+
+void DemodulatorBank::apply(const Signal &signal, std::vector<Signal> &outputAmplitudes, std::vector<Signal> &outputPhases, bool rms) {
+	if (_isSetup == false) {
+		throw std::invalid_argument("Demodulator bank not setup");
+	}
+
+	const size_t K = _frequencies.size();
+	const size_t size = signal.size();
+	const size_t outputs = (size + _decimation - 1) / _decimation;
+
+	outputAmplitudes.resize(K, Signal(0));
+	outputPhases.resize(K, Signal(0));
+	for (size_t k = 0; k < K; k++) {
+		outputAmplitudes[k].resize(outputs);
+		outputPhases[k].resize(outputs);
+	}
+
+	const size_t P = _phasorRe.size();
+	const size_t L = 2 * P;
+	std::fill(_phasorRe.begin(), _phasorRe.begin() + K, 1.0);
+	std::fill(_phasorIm.begin(), _phasorIm.end(), 0.0);
+	std::fill(_state.begin(), _state.end(), 0.0);
+	_fundamental = 1.0;
+
+	double *__restrict re = _phasorRe.data();
+	double *__restrict im = _phasorIm.data();
+	const double *__restrict cr = _rotationRe.data();
+	const double *__restrict ci = _rotationIm.data();
+
+	DenormalGuard guard;
+
+	size_t phase = 0;
+	size_t m = 0;
+	for (size_t start = 0; start < size; start += BLOCK) {
+		const size_t count = std::min(BLOCK, size - start);
+
+		if (_harmonics.empty()) {
+			// mélange et avance des oscillateurs : une ligne de L produits par échantillon
+			for (size_t i = 0; i < count; i++) {
+				const double x = signal[start + i];
+				double *__restrict v = _block.data() + i * L;
+				for (size_t g = 0; g < P; g += LANES) {
+					for (size_t j = 0; j < LANES; j++) {
+						size_t k = g + j;
+						v[k]     = x * im[k];
+						v[P + k] = x * re[k];
+						double r = re[k] * cr[k] - im[k] * ci[k];
+						im[k]    = re[k] * ci[k] + im[k] * cr[k];
+						re[k]    = r;
+					}
+				}
+			}
+			// renormalisation des oscillateurs contre la dérive d'amplitude
+			for (size_t k = 0; k < K; k++) {
+				double norm = 1.0 / std::sqrt(re[k] * re[k] + im[k] * im[k]);
+				re[k] *= norm;
+				im[k] *= norm;
+			}
+		} else {
+			mixHarmonics(signal.data() + start, count);
+		}
+
+		// filtrage du bloc section par section, par groupes de LANES voies
+		for (size_t s = 0; s < _sections.size(); s++) {
+			const Biquad q = _sections[s];
+			double *__restrict z1 = _state.data() + 2 * s * L;
+			double *__restrict z2 = z1 + L;
+			for (size_t g = 0; g < L; g += LANES) {
+				double a1[LANES], a2[LANES];
+				for (size_t j = 0; j < LANES; j++) {
+					a1[j] = z1[g + j];
+					a2[j] = z2[g + j];
+				}
+				double *__restrict v = _block.data() + g;
+				for (size_t i = 0; i < count; i++, v += L) {
+					for (size_t j = 0; j < LANES; j++) {
+						double y = q.b0 * v[j] + a1[j];
+						a1[j] = q.b1 * v[j] - q.a1 * y + a2[j];
+						a2[j] = q.b2 * v[j] - q.a2 * y;
+						v[j] = y;
+					}
+				}
+				for (size_t j = 0; j < LANES; j++) {
+					z1[g + j] = a1[j];
+					z2[g + j] = a2[j];
+				}
+			}
+		}
+
+		// amplitude et phase des seules sorties décimées
+		for (size_t i = phase; i < count; i += _decimation) {
+			const double *v = _block.data() + i * L;
+			for (size_t k = 0; k < K; k++) {
+				double A = v[k];
+				double Phi = v[P + k];
+				if (rms) {
+					outputAmplitudes[k][m] = std::sqrt(A*A + Phi*Phi)*sqrt(2.0);
+				} else {
+					outputAmplitudes[k][m] = std::sqrt(2.0*A*A + 2.0*Phi*Phi)*sqrt(2.0);
+				}
+				outputPhases[k][m] = (A != 0.0)? modulo(atan2(Phi, A), 2*M_PI) : 0.0;
+			}
+			m++;
+		}
+		// position de la prochaine sortie dans le bloc suivant
+		phase = (phase + _decimation - count % _decimation) % _decimation;
+	}
+}
+
+double DemodulatorBank::getTHD(const std::vector<Signal> &outputAmplitudes, size_t start_index) const {
+	if (_harmonics.empty() || _harmonics.front() != 1) {
+		throw std::invalid_argument("The THD needs the fundamental among the demodulated harmonics");
+	}
+	if (outputAmplitudes.size() != _harmonics.size()) {
+		throw std::invalid_argument("One amplitude signal per harmonic is expected");
+	}
+
+	double fundamental = outputAmplitudes[0].mean(start_index);
+	double sum = 0.0;
+	for (size_t k = 1; k < outputAmplitudes.size(); k++) {
+		double amplitude = outputAmplitudes[k].mean(start_index);
+		sum += amplitude * amplitude;
+	}
+	return (fundamental > 0.0) ? std::sqrt(sum) / fundamental : 0.0;
+}
@@ -0,0 +1,123 @@
+#ifndef __DEMODULATORBANK_HPP
+#define __DEMODULATORBANK_HPP
+
+#include <vector>
+#include <complex>
+#include "Signal.hpp"
+#include "Filter.hpp"
+
+/**
+ * @brief Demodulation of several tones of a signal in a single pass
+ * @details Each sample is mixed with K numerically controlled oscillators, and the
+ *          2K products (sine then cosine of each tone) are filtered together by the
+ *          same low pass filter. The oscillators, the products and the states of the
+ *          filter are stored lane by lane, so the loops on the tones have no
+ *          dependency and are vectorized; the input is read only once whatever the
+ *          number of tones. Amplitude and phase are only computed for the decimated
+ *          outputs.
+ *
+ *          The references, the filter and the outputs follow the conventions of
+ *          Demodulator: with a decimation of 1, each tone gives the amplitude and the
+ *          phase Demodulator::apply() would give at its frequency.
+ */
+class DemodulatorBank {
+public:
+	DemodulatorBank();
+
+	/**
+	 * @brief Set the parameters of the bank
+	 * @param frequencies Frequencies of the oscillators, one per tone, below SAMPLING_FREQUENCY/2
+	 * @param freq_filter Cutoff frequency of the low pass filter, below the spacing between the tones
+	 * @param decimation Only one output sample out of decimation is converted to amplitude and phase
+	 * @return true if the parameters are valid, false otherwise
+	 */
+	bool set(const std::vector<double> &frequencies, double freq_filter, size_t decimation = 1);
+
+	/**
+	 * @brief Demodulate harmonics of a fundamental frequency
+	 * @param fundamental Fundamental frequency f
+	 * @param harmonics Orders n of the demodulated harmonics n.f (sorted, duplicates removed),
+	 *                  with n.f below SAMPLING_FREQUENCY/2
+	 * @param freq_filter Cutoff frequency of the low pass filter, below f
+	 * @param decimation Only one output sample out of decimation is converted to amplitude and phase
+	 * @return true if the parameters are valid, false otherwise
+	 * @details The references come from a single oscillator at f, raised to the power n
+	 *          (angle multiplication), so the harmonics keep an exact phase relation.
+	 *          The tones are the harmonics in increasing order.
+	 */
+	bool setHarmonics(double fundamental, const std::vector<int> &harmonics, double freq_filter, size_t decimation = 1);
+
+	/**
+	 * @brief Setup the bank
+	 */
+	void setup();
+
+	/**
+	 * @brief Setup the bank with a filter already designed
+	 * @param sections Second order sections of the low pass filter
+	 */
+	void setup(const std::vector<Biquad> &sections);
+
+	/**
+	 * @brief Check if the bank is setup
+	 */
+	bool isSetup() const { return _isSetup; }
+
+	/**
+	 * @brief Demodulate every tone of a signal, from a null state
+	 * @param signal Input signal
+	 * @param outputAmplitudes Amplitude of each tone, (size + decimation - 1) / decimation samples
+	 * @param outputPhases Phase of each tone, same size
+	 * @param rms If true, output amplitudes will be RMS values
+	 */
+	void apply(const Signal &signal, std::vector<Signal> &outputAmplitudes, std::vector<Signal> &outputPhases, bool rms = false);
+
+	/**
+	 * @brief Total harmonic distortion of the demodulated harmonics
+	 * @param outputAmplitudes Amplitudes given by apply() in harmonic mode
+	 * @param start_index First output sample of the steady state
+	 * @return sqrt(sum of A_n^2, n > 1) / A_1, from the mean amplitudes over the steady state
+	 * @note Only the demodulated harmonics are counted; the fundamental (order 1) must be one of them
+	 */
+	double getTHD(const std::vector<Signal> &outputAmplitudes, size_t start_index = 0) const;
+
+	/**
+	 * @brief Number of tones K
+	 */
+	size_t getNumberOfTones() const { return _frequencies.size(); }
+
+	const std::vector<double> &getFrequencies() const { return _frequencies; }
+
+	/**
+	 * @brief Orders of the harmonics (empty if the tones were given by their frequencies)
+	 */
+	const std::vector<int> &getHarmonics() const { return _harmonics; }
+	size_t getDecimation() const { return _decimation; }
+
+private:
+	std::vector<double> _frequencies;
+	double _freqFilter;
+	size_t _decimation;
+	IIRFilter _filter;
+	std::vector<Biquad> _sections;
+
+	static constexpr size_t LANES = 4;   // tones processed together by the inner loops
+	static constexpr size_t BLOCK = 256; // samples mixed then filtered together
+
+	// K tones padded to P lanes : lanes [0, P) products by the sine, [P, 2P) by the cosine
+	std::vector<double> _phasorRe, _phasorIm;     // cos(wn), sin(wn) of each tone
+	std::vector<double> _rotationRe, _rotationIm; // cos(w), sin(w)
+	std::vector<double> _block;                   // 2P products of each sample of the block
+	std::vector<double> _state;                   // z1 then z2 of each section, 2P lanes each
+
+	// harmonics of a single oscillator
+	void mixHarmonics(const double *x, size_t count);
+	std::vector<int> _harmonics;
+	double _fundamentalFrequency;
+	std::complex<double> _fundamental, _fundamentalRotation;
+	std::vector<double> _baseRe, _baseIm;         // exp(j.wn) over the block
+	std::vector<double> _powerRe, _powerIm;       // exp(j.h.wn) over the block
+	bool _isSetup;
+};
+
+#endif // __DEMODULATORBANK_HPP
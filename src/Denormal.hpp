@@ -0,0 +1,53 @@
+#ifndef __DENORMAL_HPP
+#define __DENORMAL_HPP
+
+#include <cmath>
+#include <cstdint>
+#if defined(__SSE2__)
+#include <xmmintrin.h>
+#endif
+
+/**
+ * @brief Active le mode "flush-to-zero" du FPU pendant la durée de vie de l'objet
+ * @details Les nombres dénormalisés apparaissent dans les états des filtres récursifs
+ *          lorsque l'entrée s'annule, et sont très lents à traiter sur ARM comme sur x86.
+ */
+class DenormalGuard {
+public:
+	DenormalGuard() {
+#if defined(__aarch64__)
+		asm volatile("mrs %0, fpcr" : "=r"(_saved));
+		asm volatile("msr fpcr, %0" : : "r"(_saved | (1ull << 24)));
+#elif defined(__arm__) && defined(__ARM_FP)
+		asm volatile("vmrs %0, fpscr" : "=r"(_saved));
+		asm volatile("vmsr fpscr, %0" : : "r"(_saved | (1u << 24)));
+#elif defined(__SSE2__)
+		_saved = _mm_getcsr();
+		_mm_setcsr(_saved | 0x8040); // FTZ | DAZ
+#endif
+	}
+
+	~DenormalGuard() {
+#if defined(__aarch64__)
+		asm volatile("msr fpcr, %0" : : "r"(_saved));
+#elif defined(__arm__) && defined(__ARM_FP)
+		asm volatile("vmsr fpscr, %0" : : "r"(_saved));
+#elif defined(__SSE2__)
+		_mm_setcsr(_saved);
+#endif
+	}
+
+private:
+#if defined(__aarch64__)
+	uint64_t _saved;
+#else
+	uint32_t _saved;
+#endif
+};
+
+// Remise à zéro des états trop petits pour rester dans les nombres normalisés
+inline double flushDenormal(double value) {
+	return (std::fabs(value) < 1e-30) ? 0.0 : value;
+}
+
+#endif // __DENORMAL_HPP
@@ -0,0 +1,22 @@
+#include "Device.hpp"
+#include "SimulatedDevice.hpp"
+#ifndef SIMULATION_ONLY
+#include "RPDevice.hpp"
+#endif
+
+static std::unique_ptr<Device> currentDevice;
+
+Device &getDevice() {
+	if (!currentDevice) {
+#ifdef SIMULATION_ONLY
+		currentDevice = std::make_unique<SimulatedDevice>();
+#else
+		currentDevice = std::make_unique<RPDevice>();
+#endif
+	}
+	return *currentDevice;
+}
+
+void setDevice(std::unique_ptr<Device> device) {
+	currentDevice = std::move(device);
+}
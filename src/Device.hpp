@@ -0,0 +1,176 @@
+#ifndef __DEVICE_HPP
+#define __DEVICE_HPP
+
+#include <memory>
+#include <cstdint>
+#include "rp_enums.h"
+#include "Signal.hpp"
+
+// taille de l'anneau de l'ADC, définie par rp.h dans la version pour la carte
+#ifndef ADC_BUFFER_SIZE
+#define ADC_BUFFER_SIZE (16 * 1024)
+#endif
+
+/**
+ * @brief Output 1 of the card
+ */
+class GeneratorBackend {
+public:
+	virtual ~GeneratorBackend() = default;
+
+	/**
+	 * @brief Stop the output and go back to the default settings
+	 */
+	virtual void reset() = 0;
+
+	virtual void setWaveform(rp_waveform_t waveform) = 0;
+
+	/**
+	 * @brief Set the period of the arbitrary waveform
+	 * @param[in] data Samples of one period, between -1 and 1
+	 * @param[in] size Number of samples
+	 */
+	virtual void setArbitraryWaveform(const float *data, size_t size) = 0;
+
+	virtual void setFrequency(double frequency) = 0;
+	virtual void setAmplitude(double amplitude) = 0;
+	virtual void setOffset(double offset) = 0;
+
+	/**
+	 * @brief Set the phase of the waveform, in degrees
+	 */
+	virtual void setPhase(double phase) = 0;
+
+	/**
+	 * @brief Set the duty cycle of the PWM waveform, between 0 and 1
+	 */
+	virtual void setDutyCycle(double duty_cycle) = 0;
+
+	/**
+	 * @brief Enable the output and start the waveform
+	 */
+	virtual void enable() = 0;
+
+	/**
+	 * @brief Disable the output
+	 */
+	virtual void disable() = 0;
+};
+
+/**
+ * @brief Inputs 1 and 2 of the card
+ */
+class AcquisitionBackend {
+public:
+	virtual ~AcquisitionBackend() = default;
+
+	/**
+	 * @brief Initialize the acquisition
+	 * @param[in] trigger_level Trigger level, in volts
+	 * @param[in] trigger_delay Trigger delay, in samples (ADC_BUFFER_SIZE/2 : the buffer starts at the trigger)
+	 */
+	virtual void init(float trigger_level, int32_t trigger_delay) = 0;
+
+	/**
+	 * @brief Release the acquisition buffers
+	 */
+	virtual void release() = 0;
+
+	/**
+	 * @brief Acquire BUFFER_SIZE samples at the current DECIMATION
+	 * @param[out] channel1 Samples of input 1 (nullptr to ignore the channel)
+	 * @param[out] channel2 Samples of input 2 (nullptr to ignore the channel)
+	 * @param[in] trigger Trigger source
+	 */
+	virtual void acquire(Signal *channel1, Signal *channel2, rp_acq_trig_src_t trigger = RP_TRIG_SRC_CHA_PE) = 0;
+};
+
+/**
+ * @brief DMA ring of inputs 1 and 2, written continuously by the card
+ * @details Once started, both inputs are written without interruption at the current
+ *          DECIMATION into a ring, which wraps around when full. The reader follows the
+ *          write pointer and must read the samples before they are overwritten.
+ */
+class StreamBackend {
+public:
+	virtual ~StreamBackend() = default;
+
+	/**
+	 * @brief Start writing the inputs into the ring
+	 * @param[in] samples Requested size of the ring, in samples per input
+	 * @return Size of the ring, limited by the memory reserved for the DMA
+	 */
+	virtual size_t start(size_t samples) = 0;
+
+	/**
+	 * @brief Stop writing the inputs
+	 */
+	virtual void stop() = 0;
+
+	/**
+	 * @brief Position in the ring of the next sample written
+	 */
+	virtual size_t getWritePointer() = 0;
+
+	/**
+	 * @brief Copy samples of the ring, wrapping at its end
+	 * @param[in] position Position in the ring of the first sample
+	 * @param[in] count Number of samples, at most the size of the ring
+	 * @param[out] channel1 Samples of input 1 (nullptr to ignore the channel)
+	 * @param[out] channel2 Samples of input 2 (nullptr to ignore the channel)
+	 */
+	virtual void read(size_t position, size_t count, double *channel1, double *channel2) = 0;
+};
+
+/**
+ * @brief Card used by the tests and the modules: the Red Pitaya through librp, or a simulation
+ */
+class Device {
+public:
+	virtual ~Device() = default;
+
+	/**
+	 * @brief Initialize the card
+	 * @return true if the card is ready, false otherwise
+	 */
+	virtual bool open() = 0;
+
+	/**
+	 * @brief Release the card
+	 */
+	virtual void close() = 0;
+
+	virtual GeneratorBackend &generator() = 0;
+	virtual AcquisitionBackend &acquisition() = 0;
+	virtual StreamBackend &stream() = 0;
+
+	/**
+	 * @brief Time of the clock of the device, in seconds
+	 */
+	virtual double now() = 0;
+
+	/**
+	 * @brief Wait until the clock of the device reaches a time
+	 */
+	virtual void waitUntil(double time) = 0;
+
+	/**
+	 * @brief Wait for a duration, in seconds
+	 */
+	void wait(double duration) { waitUntil(now() + duration); }
+
+	virtual bool isSimulated() const = 0;
+};
+
+/**
+ * @brief Device used by the tests and the modules
+ * @note The Red Pitaya by default, or the simulated device when built with SIMULATION_ONLY
+ */
+Device &getDevice();
+
+/**
+ * @brief Replace the device used by the tests and the modules
+ */
+void setDevice(std::unique_ptr<Device> device);
+
+#endif // __DEVICE_HPP
@@ -1,16 +1,19 @@
 #include "Filter.hpp"
 #include <algorithm>
 #include <numeric>
+#include <array>
+#include <thread>
 #include "Signal.hpp"
+#include "Denormal.hpp"
 #include "globals.hpp"
 
-IIRFilter::IIRFilter() : _isSetup(false) {}
+IIRFilter::IIRFilter() : _isSetup(false), _fs(0.0) {}
 
 IIRFilter::~IIRFilter() {
 	// Destructor logic if needed (automatic cleanup of vectors)
 }
 
-bool IIRFilter::set(int order, double fc1, double fc2, FilterGabarit gabarit, AnalogFilter analogFilter, double rp, double rs)
+bool IIRFilter::set(int order, double fc1, double fc2, FilterGabarit gabarit, AnalogFilter analogFilter, double rp, double rs, double fs)
 {
 	if (order < 1) {
 		std::cerr << "Warning: L'ordre du filtre doit être supérieur ou égal à 1.\n";
@@ -24,6 +27,10 @@ bool IIRFilter::set(int order, double fc1, double fc2, FilterGabarit gabarit, An
 		std::cerr << "Warning: la fréquence de coupure fc1 doit être inférieur à la fréquence de coupre fc2.\n";
 		return false;
 	}
+	if (fs < 0) {
+		std::cerr << "Warning: La fréquence d'échantillonnage doit être positive.\n";
+		return false;
+	}
 
 	_order = order;
 	_fc1 = fc1;
@@ -32,58 +39,97 @@ bool IIRFilter::set(int order, double fc1, double fc2, FilterGabarit gabarit, An
 	_analogFilter = analogFilter;
 	_rp = rp; // passband ripple	  (Chebyshev I, Chebyshev II & elliptic filter)
 	_rs = rs; // stopband attenuation (Chebyshev II & elliptic filter)
+	_fs = fs;
 
 	_isSetup = false;
 	return true;
 }
 
 void IIRFilter::reset() {
-	// Reset memory x[n] and y[n] buffers
-	_xMem.resize(_order+1, 0.0);
-	_yMem.resize(_order+1, 0.0);
+	// Mise à zéro des états (z1, z2) de chaque section
+	_state.assign(2 * _sections.size(), 0.0);
 }
 
-void IIRFilter::printCoefficients() {
-	std::cout << "a coefficients: ";
-	for (const auto& coeff : _a) {
-		std::cout << coeff << " ";
+void IIRFilter::restoreState(const std::vector<double> &state) {
+	if (state.size() != stateSize()) {
+		throw std::invalid_argument("Filter state size does not match the number of sections");
 	}
-	std::cout << std::endl;
+	_state = state;
+}
+
+std::vector<double> IIRFilter::steadyState(double level) const {
+	std::vector<double> state(stateSize(), 0.0);
+
+	// En régime permanent, une section recevant x constant produit y = G.x avec
+	// G = (b0 + b1 + b2) / (1 + a1 + a2), et ses états valent :
+	//   z1 = y - b0.x ; z2 = b2.x - a2.y
+	double x = level;
+	for (size_t s = 0; s < _sections.size(); s++) {
+		const Biquad &q = _sections[s];
+		double y = x * (q.b0 + q.b1 + q.b2) / (1.0 + q.a1 + q.a2);
+		state[2 * s]     = y - q.b0 * x;
+		state[2 * s + 1] = q.b2 * x - q.a2 * y;
+		x = y;
+	}
+	return state;
+}
 
-	std::cout << "b coefficients: ";
-	for (const auto& coeff : _b) {
-		std::cout << coeff << " ";
+void IIRFilter::setInitialState(double level) {
+	if (!_isSetup) {
+		throw std::invalid_argument("Filter is not set up");
 	}
-	std::cout << std::endl;
+	_state = steadyState(level);
 }
 
+void IIRFilter::printCoefficients() {
+	for (size_t s = 0; s < _sections.size(); s++) {
+		const Biquad &q = _sections[s];
+		std::cout << "section " << s << ": ";
+		std::cout << "b = {" << q.b0 << " " << q.b1 << " " << q.b2 << "} ";
+		std::cout << "a = {1 " << q.a1 << " " << q.a2 << "}";
+		std::cout << std::endl;
+	}
+}
 
 /* -------------------------------------------------------------------------- */
-/* Méthode 1 */
 
 void IIRFilter::setup() {
 	if (!_isSetup) {
 
 		switch (_analogFilter) {
-			case AnalogFilter::BESSEL:
-				break;
 			case AnalogFilter::BUTTERWORTH:
 				ButterworthCoefficients();
 				break;
+			case AnalogFilter::BESSEL:
 			case AnalogFilter::CHEBYSHEV1:
-				break;
 			case AnalogFilter::CHEBYSHEV2:
-				break;
 			case AnalogFilter::ELLIPTIC:
-				break;
+				throw std::invalid_argument("Analog filter type not implemented");
 			default:
 				throw std::invalid_argument("Unknown analog filter type");
 		}
 
+		reset();
 		_isSetup = true;
 	}
 }
 
+void IIRFilter::setup(const std::vector<Biquad> &sections) {
+	if (sections.empty()) {
+		throw std::invalid_argument("Filter needs at least one section");
+	}
+	_sections = sections;
+	_z.clear();
+	_p.clear();
+	_k = 1.0;
+	reset();
+	_isSetup = true;
+}
+
+double IIRFilter::getSamplingFrequency() const {
+	return (_fs > 0.0) ? _fs : SAMPLING_FREQUENCY;
+}
+
 Signal IIRFilter::apply(const Signal &input) {
 	if (_isSetup == false) {
 		throw std::invalid_argument("Filter is not set up");
@@ -91,385 +137,576 @@ Signal IIRFilter::apply(const Signal &input) {
 
 	Signal output(input.size());
 	reset();
-	for (size_t i = 0; i < input.size(); i++) {
-		output[i] = _b[0] * input[i];
-		for (size_t j = 1; j < 3*static_cast<size_t>(_order); j++) {
-			if (i >= j) {
-				output[i] += (_b[j] * input[i - j]) - (_a[j] * output[i - j]);
-			}
-		}
-	}
-	
-	_isSetup = true;
+	process(input.data(), output.data(), input.size());
+	return output;
+}
+
+Signal IIRFilter::process(const Signal &input) {
+	Signal output(input.size());
+	process(input.data(), output.data(), input.size());
 	return output;
 }
 
 double IIRFilter::apply(double x) {
-	if (_isSetup) {
-		_xMem[0] = x;
-		double y = 0.0;
-		for (int i = 0; i <= _order; ++i) {
-			y += _b[i] * _xMem[i];
-			if (i > 0) {
-				y -= _a[i] * _yMem[i];
-			}
-		}
-		for (int i = _order; i > 0; --i) {
-			_xMem[i] = _xMem[i - 1];
-			_yMem[i] = _yMem[i - 1];
-		}
-		_yMem[0] = y;
-		return y;
-	} else {
+	if (!_isSetup) {
 		return x;
 	}
+
+	for (size_t s = 0; s < _sections.size(); s++) {
+		const Biquad &q = _sections[s];
+		double &z1 = _state[2 * s];
+		double &z2 = _state[2 * s + 1];
+		double y = q.b0 * x + z1;
+		z1 = flushDenormal(q.b1 * x - q.a1 * y + z2);
+		z2 = flushDenormal(q.b2 * x - q.a2 * y);
+		x = y;
+	}
+	return x;
 }
 
-Spectrum IIRFilter::frequency_response(size_t num_points) {
+void IIRFilter::process(const double *input, double *output, size_t n) {
 	if (!_isSetup) {
 		throw std::invalid_argument("Filter is not set up");
 	}
 
-	Spectrum response(num_points);
-	for (size_t i = 0; i < num_points; ++i) {
-		double omega = 2.0 * M_PI * static_cast<double>(i) / num_points;
-		std::complex<double> numerator(0.0, 0.0);
-		std::complex<double> denominator(0.0, 0.0);
+	if (input != output) {
+		std::copy(input, input + n, output);
+	}
 
-		for (size_t j = 0; j < _b.size(); ++j) {
-			numerator += _b[j] * std::exp(std::complex<double>(0.0, -omega * j));
-		}
+	DenormalGuard guard;
 
-		for (size_t j = 0; j < _a.size(); ++j) {
-			denominator += _a[j] * std::exp(std::complex<double>(0.0, -omega * j));
+	// Les sections sont appliquées l'une après l'autre sur tout le bloc :
+	// l'état de la section reste dans les registres pendant la boucle.
+	for (size_t s = 0; s < _sections.size(); s++) {
+		const Biquad q = _sections[s];
+		double z1 = _state[2 * s];
+		double z2 = _state[2 * s + 1];
+		for (size_t i = 0; i < n; i++) {
+			double x = output[i];
+			double y = q.b0 * x + z1;
+			z1 = q.b1 * x - q.a1 * y + z2;
+			z2 = q.b2 * x - q.a2 * y;
+			output[i] = y;
 		}
-
-		response[i] = numerator / denominator;
+		_state[2 * s]     = flushDenormal(z1);
+		_state[2 * s + 1] = flushDenormal(z2);
 	}
+}
 
-	return response;
+void IIRFilter::processBackward(double *data, size_t n) {
+	DenormalGuard guard;
+
+	for (size_t s = 0; s < _sections.size(); s++) {
+		const Biquad q = _sections[s];
+		double z1 = _state[2 * s];
+		double z2 = _state[2 * s + 1];
+		for (size_t i = n; i-- > 0;) {
+			double x = data[i];
+			double y = q.b0 * x + z1;
+			z1 = q.b1 * x - q.a1 * y + z2;
+			z2 = q.b2 * x - q.a2 * y;
+			data[i] = y;
+		}
+		_state[2 * s]     = flushDenormal(z1);
+		_state[2 * s + 1] = flushDenormal(z2);
+	}
 }
 
-void IIRFilter::ButterworthCoefficients()
-{
-	double wc1 = 2 * M_PI * _fc1 / SAMPLING_FREQUENCY;
-	double wc2 = 2 * M_PI * _fc2 / SAMPLING_FREQUENCY;
-	double B, W0;
+Signal IIRFilter::filtfilt(const Signal &input, int padlen) {
+	Signal output(input.size());
+	filtfilt(input.data(), output.data(), input.size(), padlen);
+	return output;
+}
 
-	if (_gabarit == FilterGabarit::BAND_PASS || _gabarit == FilterGabarit::BAND_STOP) {
-		B = wc2 - wc1;
-		W0 = sqrt(wc1 * wc2);
+void IIRFilter::filtfilt(const double *input, double *output, size_t n, int padlen) {
+	if (!_isSetup) {
+		throw std::invalid_argument("Filter is not set up");
+	}
+	if (n == 0) {
+		return;
 	}
 
-	// Variables intermédiaires pour les coefficients
-	double a0, a1, a2, b0, b1, b2;
-	double a0_num, a1_num, a2_num;
-
-	_a.resize(3 * _order);
-	_b.resize(3 * _order);
+	size_t pad = (padlen < 0) ? 3 * (2 * _sections.size() + 1) : static_cast<size_t>(padlen);
+	if (pad >= n) {
+		pad = n - 1;
+	}
 
-	bool stable = true;
+	// Prolongements impairs : 2.x[0] - x[pad..1] avant le bloc, 2.x[n-1] - x[n-2..n-1-pad] après
+	std::vector<double> left(pad), right(pad);
+	for (size_t i = 0; i < pad; i++) {
+		left[i]  = 2.0 * input[0] - input[pad - i];
+		right[i] = 2.0 * input[n - 1] - input[n - 2 - i];
+	}
 
-	for (int i = 0; i < _order; i++) {
-		double theta = M_PI * (2.0 * i + 1.0) / (2.0 * _order);
-		double pole_re = -sin(theta);
-		double pole_im = cos(theta);
-
-		if (_gabarit == FilterGabarit::LOW_PASS) { // Passe-bas
-			double k = tan(wc1 / 2.0);
-			a0 = 1.0 + sqrt(2.0) * k + k * k;
-			a1 = 2.0 * (k * k - 1.0);
-			a2 = 1.0 - sqrt(2.0) * k + k * k;
-			b0 = k * k;
-			b1 = 2.0 * b0;
-			b2 = b0;
-		} else if (_gabarit == FilterGabarit::HIGH_PASS) { // Passe-haut
-			double k = tan(wc1 / 2.0);
-			a0 = 1.0 + sqrt(2.0) * k + k * k;
-			a1 = 2.0 * (k * k - 1.0);
-			a2 = 1.0 - sqrt(2.0) * k + k * k;
-			b0 = 1.0;
-			b1 = -2.0;
-			b2 = 1.0;
-		} else if (_gabarit == FilterGabarit::BAND_PASS) { // Passe-bande
-			double k1 = 2 * tan(B / 2.0);
-			double k2 = W0 * W0;
-			a0 = k2 + k1 * pole_re + pole_re * pole_re + pole_im * pole_im;
-			a1 = 2.0 * (pole_re * pole_re + pole_im * pole_im - k2);
-			a2 = k2 - k1 * pole_re + pole_re * pole_re + pole_im * pole_im;
-			b0 = k1;
-			b1 = 0.0;
-			b2 = -k1;
-		} else if (_gabarit == FilterGabarit::BAND_STOP) { // Coupe-bande
-			double k1 = 2 * tan(B / 2.0);
-			double k2 = W0 * W0;
-			a0 = 1.0 + k1 * pole_re + k2;
-			a1 = 2.0 * (k2 - 1.0);
-			a2 = 1.0 - k1 * pole_re + k2;
-			b0 = 1.0;
-			b1 = -2.0 * (1.0 - k2);
-			b2 = 1.0;
-		}
+	// Passe avant, démarrant dans le régime permanent du premier échantillon prolongé
+	_state = steadyState((pad > 0) ? left[0] : input[0]);
+	process(left.data(), left.data(), pad);
+	process(input, output, n);
+	process(right.data(), right.data(), pad);
 
-		// Vérifier la stabilité (pour les types de filtre autres que passe-bas et passe-haut)
-		if (_gabarit == FilterGabarit::BAND_PASS || _gabarit == FilterGabarit::BAND_STOP) {
-			double zero_re = -cos(theta);
-			double zero_im = sin(theta);
-			double zero_radius = sqrt(zero_re * zero_re + zero_im * zero_im);
-			if (zero_radius >= 1.0) {
-				stable = false;
-				break; // Sortir de la boucle si le filtre est instable
-			}
-		}
+	// Passe arrière, démarrant dans le régime permanent du dernier échantillon filtré
+	_state = steadyState((pad > 0) ? right[pad - 1] : output[n - 1]);
+	processBackward(right.data(), pad);
+	processBackward(output, n);
 
-		// Normalisation des coefficients
-		a0_num = a0;
-		a1_num = a1 / a0_num;
-		a2_num = a2 / a0_num;
+	reset();
+}
 
-		_b[3 * i] = b0 / a0_num;
-		_b[3 * i + 1] = b1 / a0_num;
-		_b[3 * i + 2] = b2 / a0_num;
+size_t IIRFilter::transientLength(size_t length, double tolerance, bool zero_phase) const {
+	if (!_isSetup) {
+		throw std::invalid_argument("Filter is not set up");
+	}
 
-		_a[3 * i] = 1.0;
-		_a[3 * i + 1] = a1_num;
-		_a[3 * i + 2] = a2_num;
+	// Réponse à une entrée nulle depuis le régime permanent d'un niveau unitaire
+	IIRFilter filter(*this);
+	std::vector<double> error(length, 0.0);
+	filter._state = steadyState(1.0);
+	filter.process(error.data(), error.data(), length);
+	if (zero_phase && length > 0) {
+		filter._state = steadyState(error[length - 1]);
+		filter.processBackward(error.data(), length);
 	}
 
-	if (!stable) {
-		throw std::invalid_argument("Le filtre est instable pour les paramètres donnés");
+	for (size_t i = length; i-- > 0;) {
+		if (std::fabs(error[i]) > tolerance) {
+			return i + 1;
+		}
 	}
+	return 0;
 }
 
+// Longueur minimale d'un morceau pour que le filtrage parallèle soit rentable
+static const size_t PARALLEL_MIN_CHUNK = 16384;
+
+// Filtrage en place par une section, à partir de l'état (z1, z2) donné
+static void filterSection(const Biquad &q, double *data, size_t n, double *state) {
+	DenormalGuard guard;
+	double z1 = state[0];
+	double z2 = state[1];
+	for (size_t i = 0; i < n; i++) {
+		double x = data[i];
+		double y = q.b0 * x + z1;
+		z1 = q.b1 * x - q.a1 * y + z2;
+		z2 = q.b2 * x - q.a2 * y;
+		data[i] = y;
+	}
+	state[0] = flushDenormal(z1);
+	state[1] = flushDenormal(z2);
+}
 
-
-/* -------------------------------------------------------------------------- */
-/* Méthode 2 */
-
-/*void ButterworthAnalogPrototype(int N, std::vector<std::complex<double>> &z, std::vector<std::complex<double>> &p, double &k) {
-	p.clear();
-	for (int i = 0; i < N; ++i) {
-		double theta = M_PI * (2 * i + 1) / (2 * N);
-		std::complex<double> pole = std::polar(1.0, theta);
-		p.push_back(pole);
-	}
-	k = 1;
+// Matrice de transition d'état d'une section sur length échantillons d'entrée nulle.
+// Avec A = [-a1 1; -a2 0], Cayley-Hamilton donne A^n = s(n).A - a2.s(n-1).I, où
+// s(n+1) = -a1.s(n) - a2.s(n-1), s(0) = 0, s(1) = 1. Cette récurrence scalaire suit les
+// mêmes arrondis que le filtre ; l'exponentiation rapide perd au contraire toute précision
+// lorsque les pôles sont proches du cercle unité et proches l'un de l'autre.
+static void sectionTransition(const Biquad &q, size_t length, std::array<double, 4> *transition) {
+	double previous = 0.0;
+	double current = 1.0;
+	if (length == 0) {
+		*transition = {1.0, 0.0, 0.0, 1.0};
+		return;
+	}
+	for (size_t n = 1; n < length; n++) {
+		double next = -q.a1 * current - q.a2 * previous;
+		previous = current;
+		current = next;
+	}
+	*transition = {
+		-q.a1 * current - q.a2 * previous, current,
+		-q.a2 * current, -q.a2 * previous};
 }
 
-void TransformLowpassToLowpass(std::vector<std::complex<double>> &zeros, std::vector<std::complex<double>> &poles, double &k, double warped) {
-	for (std::complex<double> &z : zeros) {
-		z *= warped;
-	}
-	for (std::complex<double> &p : poles) {
-		p *= warped;
+// Ajout de la réponse libre d'une section à partir de l'état donné, jusqu'à son extinction.
+// L'état restant en fin de bloc est laissé dans state.
+static void addZeroInputResponse(const Biquad &q, double *data, size_t n, double *state) {
+	double z1 = state[0];
+	double z2 = state[1];
+	// en dessous de ce seuil, la réponse libre n'a plus d'effet sur la sortie
+	const double threshold = 1e-20 * std::max(std::fabs(z1), std::fabs(z2));
+	if (threshold == 0.0) {
+		return;
+	}
+
+	DenormalGuard guard;
+	for (size_t i = 0; i < n; i++) {
+		double y = z1;
+		z1 = z2 - q.a1 * y;
+		z2 = -q.a2 * y;
+		data[i] += y;
+		if ((i & 63) == 63 && std::max(std::fabs(z1), std::fabs(z2)) < threshold) {
+			z1 = 0.0;
+			z2 = 0.0;
+			break;
+		}
 	}
-	int degree = poles.size() - zeros.size();
-	k *= pow(warped, degree);
+	state[0] = z1;
+	state[1] = z2;
 }
 
-void TransformLowpassToHighpass(std::vector<std::complex<double>> &zeros, std::vector<std::complex<double>> &poles, double &k, double warped) {
-	std::complex<double> mulZ = 1.0;
-	for (std::complex<double> &z : zeros) {
-		mulZ *= -z;
-		z = warped / z;
-	}
-	std::complex<double> mulP = 1.0;
-	for (std::complex<double> &p : poles) {
-		mulP *= -p;
-		p = warped / p;
+Signal IIRFilter::applyParallel(const Signal &input, unsigned threads) {
+	if (_isSetup == false) {
+		throw std::invalid_argument("Filter is not set up");
 	}
-	//int degree = poles.size() - zeros.size();
-	k *= std::real(mulZ / mulP);
-}
 
-void TransformLowpassToBandpass(std::vector<std::complex<double>> &zeros, std::vector<std::complex<double>> &poles, double &k, double warped1, double warped2) {
-	double bw = warped2 - warped1;
-	double wo = sqrt(warped1 * warped2);
-	int degree = poles.size() - zeros.size();
+	Signal output(input.size());
+	reset();
+	processParallel(input.data(), output.data(), input.size(), threads);
+	return output;
+}
 
-	std::vector<std::complex<double>> z_bp, p_bp;
-	for (const auto &z : zeros) {
-		z_bp.push_back(z * bw / 2.0);
-	}
-	for (const auto &p : poles) {
-		p_bp.push_back(p * bw / 2.0);
+void IIRFilter::processParallel(const double *input, double *output, size_t n, unsigned threads) {
+	if (!_isSetup) {
+		throw std::invalid_argument("Filter is not set up");
 	}
 
-	std::vector<std::complex<double>> z_final, p_final;
-	for (const auto &z : z_bp) {
-		std::complex<double> sqrt_term = std::sqrt(z * z - wo * wo);
-		z_final.push_back(z + sqrt_term);
-		z_final.push_back(z - sqrt_term);
+	if (threads == 0) {
+		threads = std::max(1u, std::thread::hardware_concurrency());
 	}
-	for (const auto &p : p_bp) {
-		std::complex<double> sqrt_term = std::sqrt(p * p - wo * wo);
-		p_final.push_back(p + sqrt_term);
-		p_final.push_back(p - sqrt_term);
+	const size_t chunks = std::min<size_t>(threads, n / PARALLEL_MIN_CHUNK);
+	if (chunks < 2) {
+		process(input, output, n);
+		return;
 	}
 
-	for (int i = 0; i < degree; ++i) {
-		z_final.push_back(0.0);
+	if (input != output) {
+		std::copy(input, input + n, output);
 	}
 
-	k *= pow(bw, degree);
-	zeros = std::move(z_final);
-	poles = std::move(p_final);
-}
+	const size_t length = (n + chunks - 1) / chunks;
+	std::vector<double> states(2 * chunks);
+	std::vector<double> carries(2 * chunks);
 
+	// Comme process(), les sections sont appliquées l'une après l'autre sur tout le bloc.
+	// La propagation d'état se fait ainsi sur des matrices 2x2, bien conditionnées même
+	// lorsque les pôles de la cascade sont très proches les uns des autres.
+	for (size_t s = 0; s < _sections.size(); s++) {
+		const Biquad q = _sections[s];
 
-void TransformLowpassToBandStop(std::vector<std::complex<double>> &zeros, std::vector<std::complex<double>> &poles, double &k, double warped1, double warped2) {
-	double bw = warped2 - warped1;
-	double wo = sqrt(warped1 * warped2);
-	int degree = poles.size() - zeros.size();
+		// 1) chaque morceau est filtré indépendamment, le premier à partir de l'état courant,
+		//    pendant que la matrice de transition d'un morceau est calculée
+		std::fill(states.begin(), states.end(), 0.0);
+		states[0] = _state[2 * s];
+		states[1] = _state[2 * s + 1];
+		std::array<double, 4> A;
+		{
+			std::vector<std::thread> workers;
+			workers.emplace_back(sectionTransition, std::cref(q), length, &A);
+			for (size_t c = 0; c < chunks; c++) {
+				size_t begin = c * length;
+				size_t count = std::min(length, n - begin);
+				workers.emplace_back(filterSection, std::cref(q), output + begin, count, states.data() + 2 * c);
+			}
+			for (std::thread &worker : workers) {
+				worker.join();
+			}
+		}
 
-	std::vector<std::complex<double>> z_hp, p_hp;
-	for (const auto &z : zeros) {
-		z_hp.push_back((bw / 2.0) / z);
-	}
-	for (const auto &p : poles) {
-		p_hp.push_back((bw / 2.0) / p);
+		// 2) propagation des états d'entrée : z(c+1) = A^L.z(c) + état final du morceau c
+		std::fill(carries.begin(), carries.end(), 0.0);
+		for (size_t c = 1; c < chunks; c++) {
+			const double *previous = carries.data() + 2 * (c - 1);
+			const double *end = states.data() + 2 * (c - 1);
+			carries[2 * c]     = end[0] + A[0] * previous[0] + A[1] * previous[1];
+			carries[2 * c + 1] = end[1] + A[2] * previous[0] + A[3] * previous[1];
+		}
+
+		// 3) correction : réponse libre due à l'état d'entrée de chaque morceau
+		{
+			std::vector<std::thread> workers;
+			for (size_t c = 1; c < chunks; c++) {
+				size_t begin = c * length;
+				size_t count = std::min(length, n - begin);
+				workers.emplace_back(addZeroInputResponse, std::cref(q), output + begin, count, carries.data() + 2 * c);
+			}
+			for (std::thread &worker : workers) {
+				worker.join();
+			}
+		}
+
+		// état final : état du dernier morceau et reste de sa réponse libre
+		const size_t last = chunks - 1;
+		_state[2 * s]     = flushDenormal(states[2 * last] + carries[2 * last]);
+		_state[2 * s + 1] = flushDenormal(states[2 * last + 1] + carries[2 * last + 1]);
 	}
+}
 
-	std::vector<std::complex<double>> z_final, p_final;
-	for (const auto &z : z_hp) {
-		std::complex<double> sqrt_term = std::sqrt(z * z - wo * wo);
-		z_final.push_back(z + sqrt_term);
-		z_final.push_back(z - sqrt_term);
+void IIRFilter::evaluateResponse(const double *cosw, const double *sinw, size_t n, complexd *response) const {
+	// Calcul en réel sur des tableaux séparés (partie réelle / imaginaire) pour permettre
+	// la vectorisation : une passe par section, comme pour le filtrage.
+	std::vector<double> hr(n, 1.0), hi(n, 0.0);
+	double *__restrict pr = hr.data();
+	double *__restrict pi = hi.data();
+
+	for (const Biquad &q : _sections) {
+		for (size_t i = 0; i < n; i++) {
+			// z^-1 = cos(w) - j.sin(w) ; z^-2 = cos(2w) - j.sin(2w)
+			double c1 = cosw[i], s1 = sinw[i];
+			double c2 = c1 * c1 - s1 * s1, s2 = 2.0 * c1 * s1;
+
+			double nr = q.b0 + q.b1 * c1 + q.b2 * c2;
+			double ni = -(q.b1 * s1 + q.b2 * s2);
+			double dr = 1.0 + q.a1 * c1 + q.a2 * c2;
+			double di = -(q.a1 * s1 + q.a2 * s2);
+
+			// H *= N / D
+			double inv = 1.0 / (dr * dr + di * di);
+			double qr = (nr * dr + ni * di) * inv;
+			double qi = (ni * dr - nr * di) * inv;
+			double r = pr[i] * qr - pi[i] * qi;
+			pi[i] = pr[i] * qi + pi[i] * qr;
+			pr[i] = r;
+		}
 	}
-	for (const auto &p : p_hp) {
-		std::complex<double> sqrt_term = std::sqrt(p * p - wo * wo);
-		p_final.push_back(p + sqrt_term);
-		p_final.push_back(p - sqrt_term);
+
+	for (size_t i = 0; i < n; i++) {
+		response[i] = complexd(pr[i], pi[i]);
 	}
+}
 
-	for (int i = 0; i < degree; ++i) {
-		z_final.push_back(std::complex<double>(0.0, wo));
-		z_final.push_back(std::complex<double>(0.0, -wo));
+Spectrum IIRFilter::frequency_response(size_t num_points) const {
+	if (!_isSetup) {
+		throw std::invalid_argument("Filter is not set up");
 	}
 
-	k *= std::real(std::accumulate(poles.begin(), poles.end(), std::complex<double>(1.0), 
-					  [=](const std::complex<double> &accum, const std::complex<double> &pole) { return accum * (-pole); }) /
-				   std::accumulate(zeros.begin(), zeros.end(), std::complex<double>(1.0), 
-					  [=](const std::complex<double> &accum, const std::complex<double> &zero) { return accum * (-zero); }));
+	Spectrum response(num_points);
+	if (num_points == 0) {
+		return response;
+	}
+
+	// Grille uniforme : exp(j.w) obtenu par rotations successives d'un pas fixe,
+	// recalculé exactement tous les 256 points pour borner l'erreur d'arrondi.
+	std::vector<double> cosw(num_points), sinw(num_points);
+	const double step = 2.0 * M_PI / num_points;
+	const complexd rotator = std::polar(1.0, step);
+	complexd z(1.0, 0.0);
+	for (size_t i = 0; i < num_points; i++) {
+		if ((i & 255) == 0) {
+			z = std::polar(1.0, step * static_cast<double>(i));
+		}
+		cosw[i] = z.real();
+		sinw[i] = z.imag();
+		z *= rotator;
+	}
 
-	zeros = std::move(z_final);
-	poles = std::move(p_final);
+	evaluateResponse(cosw.data(), sinw.data(), num_points, response.data());
+	return response;
 }
 
-void IIRBilinearTransformation(std::vector<std::complex<double>> &zeros, std::vector<std::complex<double>> &poles, double &k, double fs) {
-	int degree = poles.size() - zeros.size();
-	double fs2 = 2.0 * fs;
+Spectrum IIRFilter::frequency_response(const std::vector<double> &frequencies) const {
+	if (!_isSetup) {
+		throw std::invalid_argument("Filter is not set up");
+	}
 
-	std::vector<std::complex<double>> z_transformed, p_transformed;
-	std::complex<double> mulZ = 1.0;
-	for (const auto &z : zeros) {
-		mulZ *= (std::complex<double>(fs2) - z);
-		z_transformed.push_back((fs2 + z) / (fs2 - z));
+	const size_t n = frequencies.size();
+	Spectrum response(n);
+	std::vector<double> cosw(n), sinw(n);
+	const double scale = 2.0 * M_PI / getSamplingFrequency();
+	for (size_t i = 0; i < n; i++) {
+		double omega = scale * frequencies[i];
+		cosw[i] = std::cos(omega);
+		sinw[i] = std::sin(omega);
 	}
-	std::complex<double> mulP = 1.0;
-	for (const auto &p : poles) {
-		mulP *= (std::complex<double>(fs2) - p);
-		p_transformed.push_back((fs2 + p) / (fs2 - p));
+
+	evaluateResponse(cosw.data(), sinw.data(), n, response.data());
+	return response;
+}
+
+void IIRFilter::ButterworthCoefficients()
+{
+	const double fs = getSamplingFrequency();
+	if (_fc1 >= fs / 2.0 || ((_gabarit == FilterGabarit::BAND_PASS || _gabarit == FilterGabarit::BAND_STOP) && _fc2 >= fs / 2.0)) {
+		throw std::invalid_argument("Les fréquences de coupure doivent être inférieures à la moitié de la fréquence d'échantillonnage");
 	}
-	for (int i = 0; i < degree; ++i) {
-		z_transformed.push_back(std::complex<double>(-1.0, 0.0));
+
+	// Prototype analogique de Butterworth : N pôles sur le demi-cercle gauche
+	_z.clear();
+	_p.clear();
+	_k = 1.0;
+	for (int i = 0; i < _order; i++) {
+		double theta = M_PI * (2.0 * i + _order + 1.0) / (2.0 * _order);
+		_p.push_back(std::polar(1.0, theta));
 	}
 
-	k *= std::real(mulZ / mulP);
-	zeros = std::move(z_transformed);
-	poles = std::move(p_transformed);
-}
+	// Prédistorsion des fréquences de coupure pour la transformation bilinéaire
+	double fs2 = 2.0 * fs;
+	double warped1 = fs2 * tan(M_PI * _fc1 / fs);
+	double warped2 = fs2 * tan(M_PI * _fc2 / fs);
+	double omegaRef = 0.0; // pulsation numérique de normalisation des sections
+
+	// Transformation du prototype passe-bas vers le gabarit demandé
+	std::vector<complexd> z, p;
+	complexd prodP(1.0, 0.0);
+	for (const complexd &pole : _p) prodP *= -pole;
+
+	if (_gabarit == FilterGabarit::LOW_PASS) { // Passe-bas
+		for (const complexd &pole : _p) p.push_back(pole * warped1);
+		_k *= std::pow(warped1, _order);
+		omegaRef = 0.0;
+	} else if (_gabarit == FilterGabarit::HIGH_PASS) { // Passe-haut
+		for (const complexd &pole : _p) {
+			p.push_back(warped1 / pole);
+			z.push_back(0.0);
+		}
+		_k *= std::real(1.0 / prodP);
+		omegaRef = M_PI;
+	} else if (_gabarit == FilterGabarit::BAND_PASS) { // Passe-bande
+		double bw = warped2 - warped1;
+		double w0 = sqrt(warped1 * warped2);
+		for (const complexd &pole : _p) {
+			complexd pb = pole * bw / 2.0;
+			complexd d = std::sqrt(pb * pb - w0 * w0);
+			p.push_back(pb + d);
+			p.push_back(pb - d);
+			z.push_back(0.0);
+		}
+		_k *= std::pow(bw, _order);
+		omegaRef = 2.0 * atan(w0 / fs2);
+	} else if (_gabarit == FilterGabarit::BAND_STOP) { // Coupe-bande
+		double bw = warped2 - warped1;
+		double w0 = sqrt(warped1 * warped2);
+		for (const complexd &pole : _p) {
+			complexd ph = (bw / 2.0) / pole;
+			complexd d = std::sqrt(ph * ph - w0 * w0);
+			p.push_back(ph + d);
+			p.push_back(ph - d);
+			z.push_back(complexd(0.0, w0));
+			z.push_back(complexd(0.0, -w0));
+		}
+		_k *= std::real(1.0 / prodP);
+		omegaRef = 0.0;
+	}
 
+	// Transformation bilinéaire : s -> z = (2fs + s) / (2fs - s)
+	complexd mulZ(1.0, 0.0), mulP(1.0, 0.0);
+	_z.clear();
+	_p.clear();
+	for (const complexd &zero : z) {
+		mulZ *= (fs2 - zero);
+		_z.push_back((fs2 + zero) / (fs2 - zero));
+	}
+	for (const complexd &pole : p) {
+		mulP *= (fs2 - pole);
+		_p.push_back((fs2 + pole) / (fs2 - pole));
+	}
+	// les zéros à l'infini sont ramenés en z = -1
+	while (_z.size() < _p.size()) {
+		_z.push_back(-1.0);
+	}
+	_k *= std::real(mulZ / mulP);
 
-void poly(const std::vector<std::complex<double>> &roots, std::vector<double> &coeffs) {
-	coeffs[0] = 1.0;
-	for (const auto &root : roots) {
-		std::vector<double> new_coeffs(coeffs.size() + 1);
-		for (size_t i = 0; i < coeffs.size(); ++i) {
-			new_coeffs[i] -= root.real() * coeffs[i];
-			new_coeffs[i + 1] += coeffs[i];
+	// Vérifier la stabilité : tous les pôles doivent être dans le cercle unité
+	for (const complexd &pole : _p) {
+		if (std::abs(pole) >= 1.0) {
+			throw std::invalid_argument("Le filtre est instable pour les paramètres donnés");
 		}
-		coeffs = std::move(new_coeffs);
 	}
+
+	zpkToSections(omegaRef);
 }
 
-void PolynomialTransfer(const std::vector<std::complex<double>> &zeros, const std::vector<std::complex<double>> &poles, double k, std::vector<double> &b, std::vector<double> &a) {
-	poly(zeros, b);
-	for (auto &coeff : b) {
-		coeff *= k;
-	}
-	poly(poles, a);
+void IIRFilter::zpkToSections(double omegaRef)
+{
+	const double eps = 1e-12;
 
-	auto are_conjugates = [](const std::vector<std::complex<double>> &roots) {
-		std::vector<std::complex<double>> pos_roots, neg_roots;
-		for (const auto &root : roots) {
-			if (root.imag() > 0) pos_roots.push_back(root);
-			else if (root.imag() < 0) neg_roots.push_back(std::conj(root));
+	// Séparer les racines complexes (une seule par paire conjuguée) et réelles
+	auto split = [eps](const std::vector<complexd> &roots, std::vector<complexd> &cplx, std::vector<double> &real) {
+		for (const complexd &r : roots) {
+			if (r.imag() > eps) cplx.push_back(r);
+			else if (std::abs(r.imag()) <= eps) real.push_back(r.real());
 		}
-		if (pos_roots.size() != neg_roots.size()) return false;
-		std::sort(pos_roots.begin(), pos_roots.end(), [](const std::complex<double> &a, const std::complex<double> &b) { return std::arg(a) < std::arg(b); });
-		std::sort(neg_roots.begin(), neg_roots.end(), [](const std::complex<double> &a, const std::complex<double> &b) { return std::arg(a) < std::arg(b); });
-		return std::equal(pos_roots.begin(), pos_roots.end(), neg_roots.begin());
 	};
 
-	if (are_conjugates(zeros)) {
-		for (auto &coeff : b) coeff = std::real(coeff);
-	}
-	if (are_conjugates(poles)) {
-		for (auto &coeff : a) coeff = std::real(coeff);
+	std::vector<complexd> pc, zc;
+	std::vector<double> pr, zr;
+	split(_p, pc, pr);
+	split(_z, zc, zr);
+
+	// Les sections les plus résonantes (pôles proches du cercle unité) sont placées en dernier
+	std::sort(pc.begin(), pc.end(), [](const complexd &a, const complexd &b) { return std::abs(a) < std::abs(b); });
+	std::sort(zr.begin(), zr.end());
+
+	// Polynômes du second ordre des pôles : [1, c1, c2]
+	std::vector<std::pair<double, double>> dens;
+	for (const complexd &pole : pc) {
+		dens.push_back({-2.0 * pole.real(), std::norm(pole)});
+	}
+	for (size_t i = 0; i < pr.size(); i += 2) {
+		if (i + 1 < pr.size()) dens.push_back({-(pr[i] + pr[i + 1]), pr[i] * pr[i + 1]});
+		else                   dens.push_back({-pr[i], 0.0});
+	}
+
+	// Polynômes du second ordre des zéros, en associant les zéros réels
+	// extrêmes entre eux (ex. passe-bande : (1 - z^-1)(1 + z^-1))
+	std::vector<std::array<double, 3>> nums;
+	for (const complexd &zero : zc) {
+		nums.push_back({1.0, -2.0 * zero.real(), std::norm(zero)});
+	}
+	size_t lo = 0, hi = zr.size();
+	while (hi - lo >= 2) {
+		double z1 = zr[lo++], z2 = zr[--hi];
+		nums.push_back({1.0, -(z1 + z2), z1 * z2});
+	}
+	if (hi - lo == 1) {
+		nums.push_back({1.0, -zr[lo], 0.0});
+	}
+	while (nums.size() < dens.size()) {
+		nums.push_back({1.0, 0.0, 0.0});
+	}
+
+	// Normalisation de chaque section à un gain unitaire à omegaRef
+	complexd e1 = std::polar(1.0, -omegaRef);
+	complexd e2 = e1 * e1;
+	complexd gain(1.0, 0.0);
+	_sections.clear();
+	for (size_t s = 0; s < dens.size(); s++) {
+		Biquad q;
+		q.a1 = dens[s].first;
+		q.a2 = dens[s].second;
+		complexd h = (nums[s][0] + nums[s][1] * e1 + nums[s][2] * e2) / (1.0 + q.a1 * e1 + q.a2 * e2);
+		double g = (std::abs(h) > eps) ? 1.0 / std::abs(h) : 1.0;
+		q.b0 = g * nums[s][0];
+		q.b1 = g * nums[s][1];
+		q.b2 = g * nums[s][2];
+		gain *= h * g;
+		_sections.push_back(q);
+	}
+
+	// Le gain restant du filtre (k) est reporté sur la dernière section
+	complexd h(1.0, 0.0);
+	{
+		complexd num(1.0, 0.0), den(1.0, 0.0);
+		for (const complexd &zero : _z) num *= (1.0 - zero * e1);
+		for (const complexd &pole : _p) den *= (1.0 - pole * e1);
+		h = _k * num / den;
+	}
+	if (!_sections.empty() && std::abs(gain) > eps) {
+		double g = std::real(h / gain);
+		_sections.back().b0 *= g;
+		_sections.back().b1 *= g;
+		_sections.back().b2 *= g;
 	}
 }
 
-void IIRFilter::setup2() {
-	if (!_isSetup) {
-		// Reset coefficient buffers
-		_a.resize(_order+1, 0.0);
-		_b.resize(_order+1, 0.0);
-		// Reset zeros, poles and gian
-		_z.clear();
-		_p.clear();
-		_k = 0;
-
-		switch (_analogFilter) {
-			case AnalogFilter::BESSEL:
-				//BesselAnalogPrototype(_order, _z, _p, _k);
-				break;
-			case AnalogFilter::BUTTERWORTH:
-				ButterworthAnalogPrototype(_order, _z, _p, _k);
-				break;
-			case AnalogFilter::CHEBYSHEV1:
-				//Chebyshev1AnalogPrototype(_order, _z, _p, _k);
-				break;
-			case AnalogFilter::CHEBYSHEV2:
-				//Chebyshev2AnalogPrototype(_order, _z, _p, _k);
-				break;
-			case AnalogFilter::ELLIPTIC:
-				//EllipticAnalogPrototype(_order, _z, _p, _k);
-				break;
-			default:
-				throw std::invalid_argument("Unknown analog filter type");
-		}
+/* -------------------------------------------------------------------------- */
 
-		double fs = 2.0;
-		double warped1 = 2.0 * fs* tan(M_PI * _fc1 / fs);
-		double warped2 = 2.0 * fs* tan(M_PI * _fc2 / fs);
-
-		if (_gabarit == FilterGabarit::LOW_PASS) {
-			TransformLowpassToLowpass(_z, _p, _k, warped1);
-		} else if (_gabarit == FilterGabarit::HIGH_PASS) {
-			TransformLowpassToHighpass(_z, _p, _k, warped1);
-		} else if (_gabarit == FilterGabarit::LOW_PASS) {
-			TransformLowpassToBandpass(_z, _p, _k, warped1, warped2);
-		} else if (_gabarit == FilterGabarit::HIGH_PASS) {
-			TransformLowpassToBandStop(_z, _p, _k, warped1, warped2);
-		}
+const std::vector<Biquad> &FilterDesignCache::get(int order, double fc1, double fc2, double fs, FilterGabarit gabarit, AnalogFilter analogFilter) {
+	if (fs <= 0.0) {
+		fs = SAMPLING_FREQUENCY;
+	}
 
-		IIRBilinearTransformation(_z, _p, _k, fs);
-		PolynomialTransfer(_z, _p, _k, _a, _b);
+	Key key(order, fc1, fc2, fs, gabarit, analogFilter);
+	auto it = _designs.find(key);
+	if (it != _designs.end()) {
+		return it->second;
+	}
 
-		_isSetup = true;
+	IIRFilter filter;
+	if (!filter.set(order, fc1, fc2, gabarit, analogFilter, 0, 0, fs)) {
+		throw std::invalid_argument("Invalid filter design parameters");
 	}
-}*/
+	filter.setup();
+	return _designs.emplace(key, filter.getSections()).first->second;
+}
 
 
 
@@ -487,7 +724,7 @@ bool AveragingFilter::set(int order) {
 }
 
 void AveragingFilter::reset() {
-    _memory.resize(_order, 0.0);
+    _memory.assign(_order, 0.0);
 	_index = 0;
 	_sum = 0.0;
 	_memory_is_full = false;
@@ -519,7 +756,7 @@ double AveragingFilter::apply(double x) {
 	_sum -= _memory[_index];
 	_memory[_index] = x;
 	_sum += x;
-	if (_index < _order - 1) {
+	if (_index + 1 < static_cast<size_t>(_order)) {
 		_index++;
 	} else {
 		if (!_memory_is_full) _memory_is_full = true;
@@ -6,6 +6,8 @@
 #include <cmath>
 #include <stdexcept>
 #include <iostream>
+#include <map>
+#include <tuple>
 #include "Signal.hpp"
 #include "Spectrum.hpp"
 
@@ -24,45 +26,195 @@ enum class AnalogFilter {
 	ELLIPTIC,	// IIR Cauer/Elliptic filter design
 };
 
+/**
+ * @brief Section du second ordre (biquad) normalisée (a0 = 1)
+ * @details H(z) = (b0 + b1 z^-1 + b2 z^-2) / (1 + a1 z^-1 + a2 z^-2)
+ */
+struct Biquad {
+	double b0, b1, b2;
+	double a1, a2;
+};
+
+/**
+ * @brief Filtre IIR réalisé en cascade de sections du second ordre (SOS)
+ * @details Chaque section est calculée en forme directe II transposée,
+ *          avec deux variables d'état (z1, z2) par section.
+ */
 class IIRFilter {
 public:
 	IIRFilter();
 	~IIRFilter();
 
-	// paramétrage du filtre
-	bool set(int order, double fc1, double fc2, FilterGabarit gabarit, AnalogFilter analogFilter, double rp = 0, double rs = 0);
-	
+	// paramétrage du filtre (fs = 0 : fréquence d'échantillonnage courante SAMPLING_FREQUENCY au moment du setup)
+	bool set(int order, double fc1, double fc2, FilterGabarit gabarit, AnalogFilter analogFilter, double rp = 0, double rs = 0, double fs = 0);
+
 	/**
 	 * @brief Check if the filter is setup
 	 * @return True if the filter is setup
 	 */
 	bool isSetup() const { return _isSetup; }
 
-	// réinitialisation du filtre
+	// réinitialisation du filtre (mise à zéro des états)
 	void reset();
 
+	/**
+	 * @brief Sauvegarder l'état courant du filtre
+	 * @return États (z1, z2) de chaque section
+	 */
+	std::vector<double> saveState() const { return _state; }
+
+	/**
+	 * @brief Restaurer un état sauvegardé avec saveState()
+	 * @param[in] state États (z1, z2) de chaque section
+	 */
+	void restoreState(const std::vector<double> &state);
+
+	/**
+	 * @brief Calculer l'état du régime permanent pour une entrée constante (équivalent de lfilter_zi)
+	 * @param[in] level Niveau continu de l'entrée
+	 * @return États (z1, z2) de chaque section
+	 */
+	std::vector<double> steadyState(double level = 1.0) const;
+
+	/**
+	 * @brief Placer le filtre dans le régime permanent d'une entrée constante
+	 * @param[in] level Niveau continu de l'entrée
+	 * @details Supprime le régime transitoire lorsque le début du signal est proche de ce niveau.
+	 */
+	void setInitialState(double level);
+
 	// Méthode pour afficher les coefficients du filtre (à des fins de débogage)
 	void printCoefficients();
 
-	/* ----- Méthode 1 ----- */
-
-	// calcul des coefficients
+	// calcul des sections du filtre
 	void setup();
-	
+
+	/**
+	 * @brief Utiliser des sections déjà calculées (cache de conception, plan de balayage)
+	 * @param[in] sections Sections du second ordre du filtre
+	 */
+	void setup(const std::vector<Biquad> &sections);
+
+	/**
+	 * @brief Filtrer un signal complet à partir d'un état nul
+	 * @param[in] input Signal d'entrée
+	 * @return Signal filtré
+	 */
 	Signal apply(const Signal &input);
 
 	// calcul de y(n) par application de l‘équation aux différences
-	double apply(double y);
+	double apply(double x);
+
+	/**
+	 * @brief Filtrer un signal en continuité du bloc précédent (mode flux)
+	 * @param[in] input Signal d'entrée
+	 * @return Signal filtré
+	 * @details L'état n'est pas réinitialisé : des acquisitions contiguës sont
+	 *          filtrées comme un seul signal. Utiliser reset() ou setInitialState()
+	 *          pour démarrer un nouveau flux.
+	 */
+	Signal process(const Signal &input);
+
+	/**
+	 * @brief Filtrer un bloc d'échantillons en conservant l'état entre les appels
+	 * @param[in] input Échantillons d'entrée
+	 * @param[out] output Échantillons de sortie (peut être égal à input)
+	 * @param[in] n Nombre d'échantillons
+	 */
+	void process(const double *input, double *output, size_t n);
+
+	/**
+	 * @brief Filtrer un long enregistrement sur plusieurs cœurs, à partir d'un état nul
+	 * @param[in] input Signal d'entrée
+	 * @param[in] threads Nombre de fils d'exécution (0 : nombre de cœurs)
+	 * @return Signal filtré, égal à celui de apply() aux erreurs d'arrondi près
+	 */
+	Signal applyParallel(const Signal &input, unsigned threads = 0);
+
+	/**
+	 * @brief Filtrer un bloc sur plusieurs cœurs en conservant l'état entre les appels
+	 * @param[in] input Échantillons d'entrée
+	 * @param[out] output Échantillons de sortie (peut être égal à input)
+	 * @param[in] n Nombre d'échantillons
+	 * @param[in] threads Nombre de fils d'exécution (0 : nombre de cœurs)
+	 * @details Pour chaque section, le bloc est découpé en morceaux filtrés en parallèle à
+	 *          partir d'un état nul. Les états d'entrée des morceaux sont ensuite propagés
+	 *          d'un morceau au suivant par la matrice de transition d'état A^L de la section,
+	 *          puis la réponse libre due à ces états est ajoutée en parallèle à chaque morceau
+	 *          (jusqu'à son extinction). Les blocs trop courts sont filtrés séquentiellement.
+	 */
+	void processParallel(const double *input, double *output, size_t n, unsigned threads = 0);
+
+	/**
+	 * @brief Filtrer un signal sans déphasage (passes avant puis arrière, équivalent de filtfilt)
+	 * @param[in] input Signal d'entrée
+	 * @param[in] padlen Longueur des prolongements impairs aux extrémités (-1 : 3.(2.sections + 1))
+	 * @return Signal filtré, de module |H|² et de phase nulle
+	 */
+	Signal filtfilt(const Signal &input, int padlen = -1);
+
+	/**
+	 * @brief Filtrer un bloc sans déphasage
+	 * @param[in] input Échantillons d'entrée
+	 * @param[out] output Échantillons de sortie (peut être égal à input)
+	 * @param[in] n Nombre d'échantillons
+	 * @param[in] padlen Longueur des prolongements impairs aux extrémités (-1 : 3.(2.sections + 1))
+	 * @details Le signal est prolongé par symétrie impaire et chaque passe démarre dans le
+	 *          régime permanent de son premier échantillon, ce qui réduit les transitoires
+	 *          aux extrémités. Seuls les prolongements sont alloués. L'état est remis à zéro.
+	 */
+	void filtfilt(const double *input, double *output, size_t n, int padlen = -1);
+
+	/**
+	 * @brief Durée du régime transitoire consécutif à un écart de niveau initial unitaire
+	 * @param[in] length Nombre d'échantillons simulés
+	 * @param[in] tolerance Écart résiduel toléré
+	 * @param[in] zero_phase Transitoire du filtrage sans déphasage (filtfilt)
+	 * @return Indice du premier échantillon dont l'écart reste inférieur à la tolérance (length si jamais atteint)
+	 */
+	size_t transientLength(size_t length, double tolerance = 1e-3, bool zero_phase = false) const;
 
-	Spectrum frequency_response(size_t num_points);
+	/**
+	 * @brief Taille de l'état du filtre (z1, z2 de chaque section)
+	 */
+	size_t stateSize() const { return 2 * _sections.size(); }
 
-	/* ----- Méthode 2 ----- */
+	/**
+	 * @brief Sections du second ordre du filtre
+	 */
+	const std::vector<Biquad> &getSections() const { return _sections; }
 
-	// calcul des coefficients
-	//void setup2();
+	/**
+	 * @brief Fréquence d'échantillonnage utilisée pour la conception du filtre
+	 */
+	double getSamplingFrequency() const;
+
+	/**
+	 * @brief Réponse en fréquence sur une grille uniforme de [0, fs[
+	 * @param[in] num_points Nombre de points, le point i correspond à i.fs/num_points
+	 * @return Réponse complexe H(f)
+	 */
+	Spectrum frequency_response(size_t num_points) const;
+
+	/**
+	 * @brief Réponse en fréquence sur une liste de fréquences quelconque (par exemple logarithmique)
+	 * @param[in] frequencies Fréquences en Hz
+	 * @return Réponse complexe H(f) pour chaque fréquence
+	 */
+	Spectrum frequency_response(const std::vector<double> &frequencies) const;
 
 private:
-	void ButterworthCoefficients(); /* < Méthode 1 */
+	void ButterworthCoefficients();
+
+	// regroupement des pôles et zéros numériques en sections du second ordre,
+	// chaque section étant normalisée à un gain unitaire à la pulsation omegaRef
+	void zpkToSections(double omegaRef);
+
+	// filtrage en place du dernier au premier échantillon, en conservant l'état
+	void processBackward(double *data, size_t n);
+
+	// évaluation des sections aux points z = exp(j.w), donnés par cos(w) et sin(w)
+	void evaluateResponse(const double *cosw, const double *sinw, size_t n, complexd *response) const;
 
 	bool _isSetup;
 
@@ -70,34 +222,40 @@ private:
 	double _fc1, _fc2;
 	double _rp; // passband ripple
 	double _rs; // stopband attenuation
+	double _fs; // fréquence d'échantillonnage (0 : SAMPLING_FREQUENCY)
 	FilterGabarit _gabarit;
 	AnalogFilter _analogFilter;
 
-	std::vector<double> _a, _b;
+	std::vector<Biquad> _sections;
 	std::vector<std::complex<double>> _z, _p;
 	double _k; // gain
-	std::vector<double> _xMem, _yMem;
+	std::vector<double> _state; // (z1, z2) de chaque section
 };
 
+/**
+ * @brief Cache des sections de filtres IIR déjà calculées
+ * @details Les conceptions sont mémorisées par (ordre, fc1, fc2, fs, gabarit, type),
+ *          un même filtre n'est calculé qu'une seule fois.
+ */
+class FilterDesignCache {
+public:
+	/**
+	 * @brief Obtenir les sections d'un filtre, calculées lors du premier appel
+	 * @param[in] fs Fréquence d'échantillonnage (0 : SAMPLING_FREQUENCY)
+	 * @return Sections du second ordre du filtre
+	 */
+	const std::vector<Biquad> &get(int order, double fc1, double fc2, double fs, FilterGabarit gabarit, AnalogFilter analogFilter);
 
-/* ------------------------------------------------------------------------ */
-/* Méthode 2 */
-
-// Return (z,p,k) for analog prototype of Nth-order Butterworth filter
-/*void ButterworthAnalogPrototype(int N, std::vector<std::complex<double>> &z, std::vector<std::complex<double>> &p, double &k);
-
-void TransformLowpassToLowpass(std::vector<std::complex<double>> &z, std::vector<std::complex<double>> &p, double &k, double warped);
-
-void TransformLowpassToHighpass(std::vector<std::complex<double>> &z, std::vector<std::complex<double>> &p, double &k, double warped);
-
-void TransformLowpassToBandpass(std::vector<std::complex<double>> &z, std::vector<std::complex<double>> &p, double &k, double warped1, double warped2);
-
-void TransformLowpassToBandStop(std::vector<std::complex<double>> &z, std::vector<std::complex<double>> &p, double &k, double warped1, double warped2);
+	// nombre de filtres mémorisés
+	size_t size() const { return _designs.size(); }
 
-void IIRBilinearTransformation(std::vector<std::complex<double>> &z, std::vector<std::complex<double>> &p, double &k, double fs);
+	// vider le cache
+	void clear() { _designs.clear(); }
 
-void PolynomialTransfer(const std::vector<std::complex<double>> &z, const std::vector<std::complex<double>> &p, double k, std::vector<double> &a, std::vector<double> &b);
-*/
+private:
+	using Key = std::tuple<int, double, double, double, FilterGabarit, AnalogFilter>;
+	std::map<Key, std::vector<Biquad>> _designs;
+};
 
 
 
@@ -133,7 +291,7 @@ private:
     int    _order;
     size_t _index;
     double _sum;
-	double _memory_is_full; // indique si toutes les données ont été accumulé en fonction de l'ordre
+	bool   _memory_is_full; // indique si toutes les données ont été accumulé en fonction de l'ordre
     std::vector<double> _memory;
 };
 
@@ -0,0 +1,105 @@
+#ifndef __FILTERBANK_HPP
+#define __FILTERBANK_HPP
+
+#include <vector>
+#include <array>
+#include <stdexcept>
+#include "Filter.hpp"
+#include "Denormal.hpp"
+
+/**
+ * @brief Bank of N identical IIR filters running on interleaved streams
+ * @tparam N Number of streams, known at compile time
+ * @details One set of second order sections is shared by N independent states.
+ *          The samples are interleaved (data[i*N + c]), so that the N streams of a
+ *          sample are filtered together: the loop on the streams has a fixed length
+ *          and is unrolled into SIMD lanes, and the coefficients of a section are
+ *          loaded once for all the streams. The state is kept between calls.
+ */
+template <size_t N>
+class FilterBank {
+public:
+	static_assert(N > 0, "A filter bank needs at least one stream");
+
+	static constexpr size_t channels = N;
+
+	FilterBank() : _isSetup(false) {}
+
+	/**
+	 * @brief Use the sections of a filter already set up
+	 */
+	void setup(const IIRFilter &filter) {
+		setup(filter.getSections());
+	}
+
+	/**
+	 * @brief Use second order sections already designed
+	 * @param sections Second order sections shared by the streams
+	 */
+	void setup(const std::vector<Biquad> &sections) {
+		if (sections.empty()) {
+			throw std::invalid_argument("The filter bank needs at least one section");
+		}
+		_sections = sections;
+		_state.assign(2 * _sections.size(), std::array<double, N>{});
+		_isSetup = true;
+	}
+
+	/**
+	 * @brief Check if the filter bank is setup
+	 */
+	bool isSetup() const { return _isSetup; }
+
+	/**
+	 * @brief Reset the state of every stream
+	 */
+	void reset() {
+		for (std::array<double, N> &z : _state) {
+			z.fill(0.0);
+		}
+	}
+
+	/**
+	 * @brief Filter in place a block of interleaved samples, following the previous one
+	 * @param[in,out] data Interleaved samples (data[i*N + c])
+	 * @param[in] frames Number of samples per stream
+	 */
+	void process(double *data, size_t frames) {
+		if (!_isSetup) {
+			throw std::invalid_argument("Filter bank is not set up");
+		}
+
+		DenormalGuard guard;
+
+		for (size_t s = 0; s < _sections.size(); s++) {
+			const Biquad q = _sections[s];
+			std::array<double, N> z1 = _state[2 * s];
+			std::array<double, N> z2 = _state[2 * s + 1];
+			double *__restrict x = data;
+			for (size_t i = 0; i < frames; i++, x += N) {
+				for (size_t c = 0; c < N; c++) {
+					double y = q.b0 * x[c] + z1[c];
+					z1[c] = q.b1 * x[c] - q.a1 * y + z2[c];
+					z2[c] = q.b2 * x[c] - q.a2 * y;
+					x[c] = y;
+				}
+			}
+			for (size_t c = 0; c < N; c++) {
+				_state[2 * s][c]     = flushDenormal(z1[c]);
+				_state[2 * s + 1][c] = flushDenormal(z2[c]);
+			}
+		}
+	}
+
+	/**
+	 * @brief Second order sections shared by the streams
+	 */
+	const std::vector<Biquad> &getSections() const { return _sections; }
+
+private:
+	bool _isSetup;
+	std::vector<Biquad> _sections;
+	std::vector<std::array<double, N>> _state; // _state[2*s] = z1, _state[2*s + 1] = z2
+};
+
+#endif // __FILTERBANK_HPP
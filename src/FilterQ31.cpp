@@ -0,0 +1,353 @@
+#include "FilterQ31.hpp"
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+#include <iostream>
+#include "Noise.hpp"
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+static const double Q31_SCALE = 2147483648.0; // 2^31
+
+static inline int32_t saturate32(int64_t value) {
+	if (value > std::numeric_limits<int32_t>::max()) return std::numeric_limits<int32_t>::max();
+	if (value < std::numeric_limits<int32_t>::min()) return std::numeric_limits<int32_t>::min();
+	return static_cast<int32_t>(value);
+}
+
+// Q31 -> 16 bits, arrondi au plus proche et saturé (équivalent de vqrshrn_n_s32(x, 16))
+static inline int16_t narrowQ31(int32_t value) {
+	int64_t y = (static_cast<int64_t>(value) + (1 << 15)) >> 16;
+	if (y > std::numeric_limits<int16_t>::max()) return std::numeric_limits<int16_t>::max();
+	if (y < std::numeric_limits<int16_t>::min()) return std::numeric_limits<int16_t>::min();
+	return static_cast<int16_t>(y);
+}
+
+int32_t IIRFilterQ31::toQ31(double value) {
+	return saturate32(std::llround(value * Q31_SCALE));
+}
+
+double IIRFilterQ31::fromQ31(int32_t value) {
+	return static_cast<double>(value) / Q31_SCALE;
+}
+
+IIRFilterQ31::IIRFilterQ31() : _isSetup(false), _coefficientBits(30), _rounding(FixedPointRounding::NEAREST), _saturation(true), _shift(0), _channels(1) {}
+
+bool IIRFilterQ31::set(const IIRFilter &filter, int coefficient_bits, FixedPointRounding rounding, bool saturation) {
+	if (!filter.isSetup()) {
+		std::cerr << "The floating point filter must be set up before its quantization" << std::endl;
+		return false;
+	}
+	// 30 bits au plus : les cinq produits 32 x 30 bits tiennent dans l'accumulateur de 64 bits
+	if (coefficient_bits < 8 || coefficient_bits > 30) {
+		std::cerr << "Coefficient width must be between 8 and 30 bits" << std::endl;
+		return false;
+	}
+
+	_design = filter.getSections();
+	_coefficientBits = coefficient_bits;
+	_rounding = rounding;
+	_saturation = saturation;
+	_isSetup = false;
+	return true;
+}
+
+void IIRFilterQ31::setup() {
+	if (_isSetup) {
+		return;
+	}
+	if (_design.empty()) {
+		throw std::invalid_argument("No filter to quantize");
+	}
+
+	// Bits entiers nécessaires au plus grand coefficient (|a1| < 2 pour une section stable)
+	double largest = 0.0;
+	for (const Biquad &q : _design) {
+		largest = std::max({largest, std::fabs(q.b0), std::fabs(q.b1), std::fabs(q.b2), std::fabs(q.a1), std::fabs(q.a2)});
+	}
+	int integerBits = 1;
+	while (std::ldexp(1.0, integerBits) <= largest) {
+		integerBits++;
+	}
+	_shift = _coefficientBits - 1 - integerBits;
+	if (_shift < 1) {
+		throw std::invalid_argument("Coefficients are too large for the requested width");
+	}
+
+	const double scale = std::ldexp(1.0, _shift);
+	const int64_t limit = (int64_t(1) << (_coefficientBits - 1)) - 1;
+	auto quantize = [&](double c) {
+		int64_t v = std::llround(c * scale);
+		return static_cast<int32_t>(std::clamp<int64_t>(v, -limit - 1, limit));
+	};
+
+	_sections.clear();
+	for (const Biquad &q : _design) {
+		_sections.push_back({quantize(q.b0), quantize(q.b1), quantize(q.b2), quantize(q.a1), quantize(q.a2)});
+	}
+
+	_channels = 1;
+	reset();
+	_isSetup = true;
+}
+
+void IIRFilterQ31::resizeState(size_t channels) {
+	if (channels != _channels || _state.size() != 4 * _sections.size() * channels) {
+		_channels = channels;
+		_state.assign(4 * _sections.size() * channels, 0);
+	}
+}
+
+void IIRFilterQ31::reset() {
+	_state.assign(4 * _sections.size() * _channels, 0);
+}
+
+std::vector<Biquad> IIRFilterQ31::getQuantizedSections() const {
+	const double scale = std::ldexp(1.0, -_shift);
+	std::vector<Biquad> sections;
+	for (const BiquadQ31 &q : _sections) {
+		sections.push_back({q.b0 * scale, q.b1 * scale, q.b2 * scale, q.a1 * scale, q.a2 * scale});
+	}
+	return sections;
+}
+
+inline int32_t IIRFilterQ31::step(const BiquadQ31 &q, int32_t x, int32_t *state) const {
+	// state = {x1, x2, y1, y2}, séparés de _channels éléments
+	const size_t C = _channels;
+	int64_t acc = static_cast<int64_t>(q.b0) * x
+	            + static_cast<int64_t>(q.b1) * state[0]
+	            + static_cast<int64_t>(q.b2) * state[C]
+	            - static_cast<int64_t>(q.a1) * state[2 * C]
+	            - static_cast<int64_t>(q.a2) * state[3 * C];
+	if (_rounding == FixedPointRounding::NEAREST) {
+		acc += int64_t(1) << (_shift - 1);
+	}
+	acc >>= _shift;
+	int32_t y = _saturation ? saturate32(acc) : static_cast<int32_t>(static_cast<uint32_t>(acc));
+
+	state[C] = state[0];
+	state[0] = x;
+	state[3 * C] = state[2 * C];
+	state[2 * C] = y;
+	return y;
+}
+
+int32_t IIRFilterQ31::apply(int32_t x) {
+	if (!_isSetup) {
+		throw std::invalid_argument("Filter is not set up");
+	}
+	resizeState(1);
+	for (size_t s = 0; s < _sections.size(); s++) {
+		x = step(_sections[s], x, &_state[4 * s]);
+	}
+	return x;
+}
+
+void IIRFilterQ31::process(const int32_t *input, int32_t *output, size_t n) {
+	if (!_isSetup) {
+		throw std::invalid_argument("Filter is not set up");
+	}
+	resizeState(1);
+
+	if (input != output) {
+		std::copy(input, input + n, output);
+	}
+	for (size_t s = 0; s < _sections.size(); s++) {
+		const BiquadQ31 q = _sections[s];
+		int32_t *state = &_state[4 * s];
+		for (size_t i = 0; i < n; i++) {
+			output[i] = step(q, output[i], state);
+		}
+	}
+}
+
+void IIRFilterQ31::process(const int16_t *input, int16_t *output, size_t frames, size_t channels) {
+	if (!_isSetup) {
+		throw std::invalid_argument("Filter is not set up");
+	}
+	if (channels == 0) {
+		return;
+	}
+	resizeState(channels);
+
+	const size_t n = frames * channels;
+	_buffer.resize(n);
+	int32_t *data = _buffer.data();
+
+	// 16 bits -> Q31
+	size_t i = 0;
+#if defined(__ARM_NEON)
+	for (; i + 4 <= n; i += 4) {
+		vst1q_s32(data + i, vshll_n_s16(vld1_s16(input + i), 16));
+	}
+#endif
+	for (; i < n; i++) {
+		data[i] = static_cast<int32_t>(input[i]) * 65536;
+	}
+
+	for (size_t s = 0; s < _sections.size(); s++) {
+		const BiquadQ31 q = _sections[s];
+		int32_t *state = &_state[4 * s * channels];
+		size_t c = 0;
+#if defined(__ARM_NEON)
+		// Deux voies à la fois : produits 32 x 32 -> 64 bits, décalage arrondi ou non,
+		// puis réduction saturée (ou non) vers 32 bits
+		const int64x2_t shift = vdupq_n_s64(-_shift);
+		for (; c + 2 <= channels; c += 2) {
+			int32x2_t x1 = vld1_s32(state + c);
+			int32x2_t x2 = vld1_s32(state + channels + c);
+			int32x2_t y1 = vld1_s32(state + 2 * channels + c);
+			int32x2_t y2 = vld1_s32(state + 3 * channels + c);
+			for (size_t k = 0; k < frames; k++) {
+				int32_t *sample = data + k * channels + c;
+				int32x2_t x = vld1_s32(sample);
+				int64x2_t acc = vmull_n_s32(x, q.b0);
+				acc = vmlal_n_s32(acc, x1, q.b1);
+				acc = vmlal_n_s32(acc, x2, q.b2);
+				acc = vmlsl_n_s32(acc, y1, q.a1);
+				acc = vmlsl_n_s32(acc, y2, q.a2);
+				acc = (_rounding == FixedPointRounding::NEAREST) ? vrshlq_s64(acc, shift) : vshlq_s64(acc, shift);
+				int32x2_t y = _saturation ? vqmovn_s64(acc) : vmovn_s64(acc);
+				x2 = x1;
+				x1 = x;
+				y2 = y1;
+				y1 = y;
+				vst1_s32(sample, y);
+			}
+			vst1_s32(state + c, x1);
+			vst1_s32(state + channels + c, x2);
+			vst1_s32(state + 2 * channels + c, y1);
+			vst1_s32(state + 3 * channels + c, y2);
+		}
+#endif
+		for (; c < channels; c++) {
+			for (size_t k = 0; k < frames; k++) {
+				int32_t &sample = data[k * channels + c];
+				sample = step(q, sample, state + c);
+			}
+		}
+	}
+
+	// Q31 -> 16 bits, arrondi et saturé
+	i = 0;
+#if defined(__ARM_NEON)
+	for (; i + 4 <= n; i += 4) {
+		vst1_s16(output + i, vqrshrn_n_s32(vld1q_s32(data + i), 16));
+	}
+#endif
+	for (; i < n; i++) {
+		output[i] = narrowQ31(data[i]);
+	}
+}
+
+Signal IIRFilterQ31::apply(const Signal &input) {
+	if (!_isSetup) {
+		throw std::invalid_argument("Filter is not set up");
+	}
+
+	std::vector<int32_t> data(input.size());
+	for (size_t i = 0; i < input.size(); i++) {
+		data[i] = toQ31(input[i]);
+	}
+	_channels = 1;
+	reset();
+	process(data.data(), data.data(), data.size());
+
+	Signal output(input.size());
+	for (size_t i = 0; i < input.size(); i++) {
+		output[i] = fromQ31(data[i]);
+	}
+	return output;
+}
+
+/* -------------------------------------------------------------------------- */
+
+// plus grand module des racines de z^2 + a1.z + a2
+static double poleRadius(double a1, double a2) {
+	double discriminant = a1 * a1 - 4.0 * a2;
+	if (discriminant < 0.0) {
+		return std::sqrt(a2);
+	}
+	double root = std::sqrt(discriminant);
+	return std::max(std::fabs(-a1 + root), std::fabs(-a1 - root)) / 2.0;
+}
+
+QuantizationReport quantizeFilter(const IIRFilter &filter, IIRFilterQ31 &quantized, int coefficient_bits, FixedPointRounding rounding, size_t num_points, size_t test_length) {
+	if (!quantized.set(filter, coefficient_bits, rounding)) {
+		throw std::invalid_argument("Unable to quantize the filter");
+	}
+	quantized.setup();
+
+	QuantizationReport report{};
+	report.coefficientBits = coefficient_bits;
+	report.shift = quantized.getShift();
+	report.stable = true;
+
+	// Coefficients et pôles
+	const std::vector<Biquad> &design = filter.getSections();
+	std::vector<Biquad> sections = quantized.getQuantizedSections();
+	for (size_t s = 0; s < design.size(); s++) {
+		const Biquad &a = design[s];
+		const Biquad &b = sections[s];
+		report.maxCoefficientError = std::max({report.maxCoefficientError,
+			std::fabs(a.b0 - b.b0), std::fabs(a.b1 - b.b1), std::fabs(a.b2 - b.b2),
+			std::fabs(a.a1 - b.a1), std::fabs(a.a2 - b.a2)});
+		double radius = poleRadius(b.a1, b.a2);
+		report.maxPoleRadius = std::max(report.maxPoleRadius, radius);
+		if (radius >= 1.0) {
+			report.stable = false;
+		}
+	}
+
+	// Réponse en fréquence des coefficients quantifiés
+	IIRFilter equivalent;
+	equivalent.setup(sections);
+	Spectrum reference = filter.frequency_response(num_points);
+	Spectrum response = equivalent.frequency_response(num_points);
+	for (size_t i = 0; i < num_points / 2; i++) {
+		report.maxResponseError = std::max(report.maxResponseError, std::abs(response[i] - reference[i]));
+		double magnitude = std::abs(reference[i]);
+		if (magnitude > 1e-3) {
+			double db = 20.0 * std::log10(std::max(std::abs(response[i]), 1e-15) / magnitude);
+			report.maxResponseErrorDb = std::max(report.maxResponseErrorDb, std::fabs(db));
+		}
+	}
+
+	// Erreur en sortie sur un bruit blanc à mi-échelle, arrondi compris
+	if (test_length > 0 && report.stable) {
+		WhiteNoise noise;
+		noise.setGain(0.5);
+		Signal input = noise.apply(Signal(test_length));
+		for (double &x : input) {
+			x = IIRFilterQ31::fromQ31(IIRFilterQ31::toQ31(x));
+		}
+		IIRFilter floating;
+		floating.setup(design);
+		Signal expected = floating.apply(input);
+		Signal output = quantized.apply(input);
+		double sum = 0.0;
+		for (size_t i = 0; i < test_length; i++) {
+			double error = std::fabs(output[i] - expected[i]) * 32768.0;
+			report.maxOutputError = std::max(report.maxOutputError, error);
+			sum += error * error;
+		}
+		report.rmsOutputError = std::sqrt(sum / test_length);
+		quantized.reset();
+	}
+
+	return report;
+}
+
+void printQuantizationReport(const QuantizationReport &report) {
+	std::cout << "Quantization on " << report.coefficientBits << " bits (shift " << report.shift << ")" << std::endl;
+	std::cout << "  max coefficient error : " << report.maxCoefficientError << std::endl;
+	std::cout << "  max response error    : " << report.maxResponseError << " (" << report.maxResponseErrorDb << " dB)" << std::endl;
+	std::cout << "  max pole radius       : " << report.maxPoleRadius << (report.stable ? "" : " UNSTABLE") << std::endl;
+	if (report.stable) {
+		std::cout << "  output error (16 bits): max " << report.maxOutputError << " LSB, rms " << report.rmsOutputError << " LSB" << std::endl;
+	} else {
+		std::cout << "  output error (16 bits): not measured, the quantized filter is unstable" << std::endl;
+	}
+}
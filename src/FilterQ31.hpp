@@ -0,0 +1,166 @@
+#ifndef __FILTERQ31_HPP
+#define __FILTERQ31_HPP
+
+#include <vector>
+#include <cstdint>
+#include "Signal.hpp"
+#include "Filter.hpp"
+
+/**
+ * @brief Rounding applied when the accumulator is shifted back to the signal format
+ */
+enum class FixedPointRounding {
+	TRUNCATE, // arithmetic shift (round toward minus infinity), as a plain shift in the FPGA
+	NEAREST,  // round half up
+};
+
+/**
+ * @brief Second order section with integer coefficients
+ * @details Coefficients are scaled by 2^shift, the shift being common to the whole cascade.
+ */
+struct BiquadQ31 {
+	int32_t b0, b1, b2;
+	int32_t a1, a2;
+};
+
+/**
+ * @brief Fixed point biquad cascade in direct form I
+ * @details Signals are Q31 (int32_t, full scale = 1.0). Each section accumulates its
+ *          five products on 64 bits, then shifts the accumulator back to Q31 with the
+ *          chosen rounding, and saturates (or wraps) to 32 bits. The arithmetic only
+ *          uses integer operations, so that the result can be matched bit for bit by
+ *          an implementation in the FPGA fabric.
+ */
+class IIRFilterQ31 {
+public:
+	IIRFilterQ31();
+
+	/**
+	 * @brief Set the floating point design to quantize
+	 * @param[in] filter Floating point filter (must be set up)
+	 * @param[in] coefficient_bits Width of the coefficients, sign included (8 to 30)
+	 * @param[in] rounding Rounding of the accumulator
+	 * @param[in] saturation True to saturate the outputs of the sections, false to wrap
+	 * @return true if the parameters are valid, false otherwise
+	 */
+	bool set(const IIRFilter &filter, int coefficient_bits = 30, FixedPointRounding rounding = FixedPointRounding::NEAREST, bool saturation = true);
+
+	/**
+	 * @brief Quantize the coefficients
+	 */
+	void setup();
+
+	/**
+	 * @brief Check if the filter is setup
+	 */
+	bool isSetup() const { return _isSetup; }
+
+	/**
+	 * @brief Reset the state of the sections
+	 */
+	void reset();
+
+	/**
+	 * @brief Filter one Q31 sample
+	 */
+	int32_t apply(int32_t x);
+
+	/**
+	 * @brief Filter a block of Q31 samples, keeping the state between calls
+	 * @param[in] input Input samples
+	 * @param[out] output Output samples (may be equal to input)
+	 * @param[in] n Number of samples
+	 */
+	void process(const int32_t *input, int32_t *output, size_t n);
+
+	/**
+	 * @brief Filter raw ADC frames, keeping the state between calls
+	 * @param[in] input Interleaved 16 bits samples (input[i*channels + c])
+	 * @param[out] output Interleaved 16 bits samples, rounded and saturated
+	 * @param[in] frames Number of samples per channel
+	 * @param[in] channels Number of interleaved channels, each one with its own state
+	 * @details Two channels (the two ADC of the board) are filtered together with NEON
+	 *          64 bits multiply-accumulate and saturating narrowing when it is available.
+	 */
+	void process(const int16_t *input, int16_t *output, size_t frames, size_t channels = 1);
+
+	/**
+	 * @brief Filter a floating point signal through the fixed point path (from a null state)
+	 * @param[in] input Signal in [-1, 1[, saturated otherwise
+	 * @return Filtered signal
+	 */
+	Signal apply(const Signal &input);
+
+	/**
+	 * @brief Quantized sections
+	 */
+	const std::vector<BiquadQ31> &getSections() const { return _sections; }
+
+	/**
+	 * @brief Quantized sections converted back to floating point
+	 */
+	std::vector<Biquad> getQuantizedSections() const;
+
+	/**
+	 * @brief Number of fractional bits of the coefficients
+	 */
+	int getShift() const { return _shift; }
+
+	int getCoefficientBits() const { return _coefficientBits; }
+
+	static int32_t toQ31(double value);
+	static double fromQ31(int32_t value);
+
+private:
+	// filtering of one section on one sample, with the state (x1, x2, y1, y2)
+	inline int32_t step(const BiquadQ31 &q, int32_t x, int32_t *state) const;
+
+	// state of the channels: _state[(4*s + k)*channels + c], k = x1, x2, y1, y2
+	void resizeState(size_t channels);
+
+	bool _isSetup;
+	std::vector<Biquad> _design;
+	int _coefficientBits;
+	FixedPointRounding _rounding;
+	bool _saturation;
+
+	std::vector<BiquadQ31> _sections;
+	int _shift;
+	size_t _channels;
+	std::vector<int32_t> _state;
+	std::vector<int32_t> _buffer; // Q31 conversion of the ADC frames
+};
+
+/**
+ * @brief Errors introduced by the quantization of a filter
+ */
+struct QuantizationReport {
+	int coefficientBits;
+	int shift;
+	double maxCoefficientError;   // largest |coefficient - quantized coefficient|
+	double maxResponseError;      // largest |H(f) - Hq(f)| on the frequency grid
+	double maxResponseErrorDb;    // largest |20.log10(|Hq(f)| / |H(f)|)| where |H(f)| > -60 dB
+	double maxPoleRadius;         // largest pole radius of the quantized sections
+	bool stable;                  // true if every quantized pole is inside the unit circle
+	double maxOutputError;        // largest output error on a test signal, in LSB of a 16 bits output
+	double rmsOutputError;        // RMS output error on the same signal, in LSB of a 16 bits output
+};
+
+/**
+ * @brief Quantize a floating point design and measure the worst-case errors
+ * @param[in] filter Floating point filter (must be set up)
+ * @param[out] quantized Fixed point filter, set up with the given parameters
+ * @param[in] coefficient_bits Width of the coefficients, sign included
+ * @param[in] rounding Rounding of the accumulator
+ * @param[in] num_points Number of points of the frequency grid
+ * @param[in] test_length Length of the test signal (white noise at half full scale)
+ * @return Report of the errors
+ */
+QuantizationReport quantizeFilter(const IIRFilter &filter, IIRFilterQ31 &quantized, int coefficient_bits = 30, FixedPointRounding rounding = FixedPointRounding::NEAREST, size_t num_points = 4096, size_t test_length = 65536);
+
+/**
+ * @brief Print a quantization report
+ */
+void printQuantizationReport(const QuantizationReport &report);
+
+#endif // __FILTERQ31_HPP
@@ -0,0 +1,126 @@
+#include "LockIn.hpp"
+#include <cmath>
+#include <stdexcept>
+#include <iostream>
+#include "globals.hpp"
+
+LockIn::LockIn() :
+	_isSetup(false), _referenceFrequency(0.0), _bandwidth(0.0), _outputRate(0.0), _order(4),
+	_samplingFrequency(0.0), _fs(0.0), _phasor(1.0), _rotation(1.0), _samples(0), _outputIndex(0),
+	_last{0.0, 0.0, 0.0, 0.0, 0.0}
+{}
+
+bool LockIn::set(double reference_frequency, double bandwidth, double output_rate, int order, double sampling_frequency, size_t capacity) {
+	if (reference_frequency < 0.0) {
+		std::cerr << "The reference frequency must be positive" << std::endl;
+		return false;
+	}
+	if (output_rate <= 0.0 || bandwidth <= 0.0 || bandwidth >= output_rate / 2.0) {
+		std::cerr << "The bandwidth must be positive and lower than half the output rate" << std::endl;
+		return false;
+	}
+	if (order < 1 || sampling_frequency < 0.0 || capacity < 1) {
+		std::cerr << "Invalid parameters for the lock-in" << std::endl;
+		return false;
+	}
+
+	_referenceFrequency = reference_frequency;
+	_bandwidth = bandwidth;
+	_outputRate = output_rate;
+	_order = order;
+	_samplingFrequency = sampling_frequency;
+	_outputs.setCapacity(capacity);
+	_isSetup = false;
+	return true;
+}
+
+void LockIn::setup() {
+	_fs = (_samplingFrequency > 0.0) ? _samplingFrequency : static_cast<double>(SAMPLING_FREQUENCY);
+	if (_referenceFrequency >= _fs / 2.0) {
+		throw std::invalid_argument("The reference frequency must be below the Nyquist frequency");
+	}
+
+	if (!_decimatorX.set(_fs, _outputRate, _bandwidth) || !_decimatorY.set(_fs, _outputRate, _bandwidth)) {
+		throw std::invalid_argument("The output rate of the lock-in is not reachable");
+	}
+	_decimatorX.setup();
+	_decimatorY.setup();
+
+	IIRFilter filter;
+	if (!filter.set(_order, _bandwidth, 0, FilterGabarit::LOW_PASS, AnalogFilter::BUTTERWORTH, 0, 0, _outputRate)) {
+		throw std::invalid_argument("Error while setting the filter of the lock-in");
+	}
+	filter.setup();
+	_filter.setup(filter);
+
+	_rotation = std::polar(1.0, 2.0 * M_PI * _referenceFrequency / _fs);
+	_isSetup = true;
+	reset();
+}
+
+void LockIn::reset() {
+	_phasor = 1.0;
+	_samples = 0;
+	_outputIndex = 0;
+	if (_isSetup) {
+		_decimatorX.reset();
+		_decimatorY.reset();
+		_filter.reset();
+	}
+	_outputs.clear();
+	_last = LockInSample{0.0, 0.0, 0.0, 0.0, 0.0};
+}
+
+void LockIn::setFrequency(double reference_frequency) {
+	_referenceFrequency = reference_frequency;
+	if (_isSetup) {
+		// seul le pas de l'oscillateur change : la phase reste continue
+		_rotation = std::polar(1.0, 2.0 * M_PI * _referenceFrequency / _fs);
+	}
+}
+
+size_t LockIn::process(const double *input, size_t n) {
+	if (!_isSetup) {
+		throw std::invalid_argument("Lock-in is not set up");
+	}
+
+	// mélange avec l'oscillateur : 2.x.cos(wn) et -2.x.sin(wn)
+	_mixX.resize(n);
+	_mixY.resize(n);
+	for (size_t i = 0; i < n; i++) {
+		_mixX[i] =  2.0 * input[i] * _phasor.real();
+		_mixY[i] = -2.0 * input[i] * _phasor.imag();
+		_phasor *= _rotation;
+		// renormalisation de l'oscillateur contre la dérive d'amplitude
+		if (++_samples % 1024 == 0) {
+			_phasor /= std::abs(_phasor);
+		}
+	}
+
+	// décimation jusqu'au débit de sortie
+	const size_t capacity = n / _decimatorX.getDecimation() + 1;
+	_decX.resize(capacity);
+	_decY.resize(capacity);
+	size_t count = _decimatorX.process(_mixX.data(), n, _decX.data());
+	_decimatorY.process(_mixY.data(), n, _decY.data());
+
+	// filtrage passe-bas des deux voies entrelacées
+	_frames.resize(2 * count);
+	for (size_t m = 0; m < count; m++) {
+		_frames[2*m]     = _decX[m];
+		_frames[2*m + 1] = _decY[m];
+	}
+	_filter.process(_frames.data(), count);
+
+	for (size_t m = 0; m < count; m++) {
+		double X = _frames[2*m];
+		double Y = _frames[2*m + 1];
+		_last.time = static_cast<double>(_outputIndex++) / _outputRate;
+		_last.X = X;
+		_last.Y = Y;
+		_last.R = std::sqrt(X*X + Y*Y);
+		_last.theta = std::atan2(Y, X);
+		_outputs.push(_last);
+	}
+	return count;
+}
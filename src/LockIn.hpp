@@ -0,0 +1,134 @@
+#ifndef __LOCKIN_HPP
+#define __LOCKIN_HPP
+
+#include <vector>
+#include <complex>
+#include "Signal.hpp"
+#include "Filter.hpp"
+#include "FilterBank.hpp"
+#include "Decimator.hpp"
+#include "RingBuffer.hpp"
+
+/**
+ * @brief Output of the lock-in amplifier
+ * @details For an input A.cos(2.pi.f.t + phi): X = A.cos(phi), Y = A.sin(phi),
+ *          R = A and theta = phi in ]-pi, pi].
+ */
+struct LockInSample {
+	double time;  // time of the output sample in seconds, from the last reset
+	double X, Y;  // in-phase and quadrature components
+	double R;     // amplitude
+	double theta; // phase in radians
+};
+
+/**
+ * @brief Streaming lock-in amplifier
+ * @details The input is mixed with a numerically controlled oscillator, the mixed
+ *          streams are decimated to the output rate by a Decimator, then low pass
+ *          filtered by a Butterworth filter whose cutoff sets the bandwidth of the
+ *          measurement. The phase of the oscillator, the decimators and the filters
+ *          keep their state between calls to process(), so consecutive blocks are
+ *          demodulated as a single continuous signal. The outputs are pushed into a
+ *          ring buffer which keeps the most recent ones.
+ * @note The outputs are delayed by the group delay of the decimation and of the filter.
+ */
+class LockIn {
+public:
+	LockIn();
+
+	/**
+	 * @brief Set the parameters of the lock-in
+	 * @param[in] reference_frequency Frequency of the oscillator
+	 * @param[in] bandwidth Cutoff frequency of the low pass filter (below output_rate/2)
+	 * @param[in] output_rate Sampling frequency of the outputs, sampling_frequency divided by an integer
+	 * @param[in] order Order of the low pass filter
+	 * @param[in] sampling_frequency Sampling frequency of the input (0 : SAMPLING_FREQUENCY at setup)
+	 * @param[in] capacity Number of outputs kept in the ring buffer
+	 * @return true if the parameters are valid, false otherwise
+	 */
+	bool set(double reference_frequency, double bandwidth, double output_rate, int order = 4, double sampling_frequency = 0.0, size_t capacity = 4096);
+
+	/**
+	 * @brief Setup the oscillator, the decimators and the filter
+	 */
+	void setup();
+
+	/**
+	 * @brief Check if the lock-in is setup
+	 */
+	bool isSetup() const { return _isSetup; }
+
+	/**
+	 * @brief Reset the phase of the oscillator, the filters and the ring buffer
+	 */
+	void reset();
+
+	/**
+	 * @brief Change the frequency of the oscillator without phase jump
+	 * @param[in] reference_frequency New frequency of the oscillator
+	 */
+	void setFrequency(double reference_frequency);
+
+	/**
+	 * @brief Demodulate a block, following the previous one (streaming mode)
+	 * @param[in] input Input samples
+	 * @param[in] n Number of input samples
+	 * @return Number of outputs pushed into the ring buffer
+	 */
+	size_t process(const double *input, size_t n);
+
+	/**
+	 * @brief Demodulate a block, following the previous one (streaming mode)
+	 * @param[in] input Input signal
+	 * @return Number of outputs pushed into the ring buffer
+	 */
+	size_t process(const Signal &input) { return process(input.data(), input.size()); }
+
+	/**
+	 * @brief Ring buffer of the outputs, oldest first
+	 * @note Outputs can be removed with pop() once read
+	 */
+	RingBuffer<LockInSample> &getOutputs() { return _outputs; }
+	const RingBuffer<LockInSample> &getOutputs() const { return _outputs; }
+
+	/**
+	 * @brief Most recent output (X = Y = R = theta = 0 before the first one)
+	 */
+	const LockInSample &getLast() const { return _last; }
+
+	double getFrequency() const { return _referenceFrequency; }
+	double getBandwidth() const { return _bandwidth; }
+
+	/**
+	 * @brief Sampling frequency of the outputs
+	 */
+	double getOutputRate() const { return _outputRate; }
+
+	/**
+	 * @brief Decimation factor between the input and the outputs
+	 */
+	int getDecimation() const { return _decimatorX.getDecimation(); }
+
+private:
+	bool _isSetup;
+	double _referenceFrequency;
+	double _bandwidth;
+	double _outputRate;
+	int _order;
+	double _samplingFrequency;
+	double _fs; // sampling frequency used at setup
+
+	std::complex<double> _phasor;   // exp(j.w.n)
+	std::complex<double> _rotation; // exp(j.w)
+	size_t _samples;
+
+	Decimator _decimatorX, _decimatorY;
+	FilterBank<2> _filter;          // X, Y interleaved
+	std::vector<double> _mixX, _mixY, _decX, _decY, _frames;
+	size_t _outputIndex;
+
+	RingBuffer<LockInSample> _outputs;
+	LockInSample _last;
+};
+
+#endif // __LOCKIN_HPP
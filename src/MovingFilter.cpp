@@ -0,0 +1,371 @@
+#include "MovingFilter.hpp"
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+
+Signal MovingFilter::apply(const Signal &input) {
+	Signal output(input.size());
+	reset();
+	process(input.data(), output.data(), input.size());
+	return output;
+}
+
+/* -------------------------------------------------------------------------- */
+
+MovingAverage::MovingAverage(size_t window) : _index(0), _count(0), _sum(0.0), _compensation(0.0) {
+	set(window);
+}
+
+bool MovingAverage::set(size_t window) {
+	if (window < 1) {
+		std::cerr << "Window size must be positive" << std::endl;
+		return false;
+	}
+	_memory.assign(window, 0.0);
+	reset();
+	return true;
+}
+
+void MovingAverage::reset() {
+	std::fill(_memory.begin(), _memory.end(), 0.0);
+	_index = 0;
+	_count = 0;
+	_sum = 0.0;
+	_compensation = 0.0;
+}
+
+inline void MovingAverage::add(double value) {
+	// addition compensée de Kahan
+	double y = value - _compensation;
+	double t = _sum + y;
+	_compensation = (t - _sum) - y;
+	_sum = t;
+}
+
+double MovingAverage::apply(double x) {
+	const size_t N = _memory.size();
+	add(x - _memory[_index]);
+	_memory[_index] = x;
+	if (_count < N) {
+		_count++;
+	}
+	if (++_index == N) {
+		// somme exacte une fois par tour : la dérive ne peut pas s'accumuler
+		_index = 0;
+		_sum = 0.0;
+		for (size_t i = 0; i < N; i++) {
+			_sum += _memory[i];
+		}
+		_compensation = 0.0;
+	}
+	return _sum / static_cast<double>(_count);
+}
+
+void MovingAverage::process(const double *input, double *output, size_t n) {
+	for (size_t i = 0; i < n; i++) {
+		output[i] = MovingAverage::apply(input[i]);
+	}
+}
+
+/* -------------------------------------------------------------------------- */
+
+ExponentialMovingAverage::ExponentialMovingAverage(double alpha) : _alpha(1.0), _value(0.0), _initialized(false) {
+	set(alpha);
+}
+
+bool ExponentialMovingAverage::set(double alpha) {
+	if (alpha <= 0.0 || alpha > 1.0) {
+		std::cerr << "Smoothing factor must be in ]0, 1]" << std::endl;
+		return false;
+	}
+	_alpha = alpha;
+	reset();
+	return true;
+}
+
+bool ExponentialMovingAverage::setWindow(size_t window) {
+	if (window < 1) {
+		std::cerr << "Window size must be positive" << std::endl;
+		return false;
+	}
+	return set(2.0 / (static_cast<double>(window) + 1.0));
+}
+
+void ExponentialMovingAverage::reset() {
+	_value = 0.0;
+	_initialized = false;
+}
+
+double ExponentialMovingAverage::apply(double x) {
+	if (!_initialized) {
+		_value = x;
+		_initialized = true;
+	} else {
+		_value += _alpha * (x - _value);
+	}
+	return _value;
+}
+
+void ExponentialMovingAverage::process(const double *input, double *output, size_t n) {
+	if (n == 0) {
+		return;
+	}
+	size_t i = 0;
+	if (!_initialized) {
+		output[0] = ExponentialMovingAverage::apply(input[0]);
+		i = 1;
+	}
+	const double alpha = _alpha;
+	double value = _value;
+	for (; i < n; i++) {
+		value += alpha * (input[i] - value);
+		output[i] = value;
+	}
+	_value = value;
+}
+
+/* -------------------------------------------------------------------------- */
+
+template <typename Compare>
+bool MovingExtremum<Compare>::set(size_t window) {
+	if (window < 1) {
+		std::cerr << "Window size must be positive" << std::endl;
+		return false;
+	}
+	_window = window;
+	_values.assign(window, 0.0);
+	_times.assign(window, 0);
+	reset();
+	return true;
+}
+
+template <typename Compare>
+void MovingExtremum<Compare>::reset() {
+	_time = 0;
+	_head = 0;
+	_size = 0;
+}
+
+template <typename Compare>
+double MovingExtremum<Compare>::apply(double x) {
+	const size_t N = _window;
+	Compare better;
+
+	// le candidat le plus ancien sort de la fenêtre
+	if (_size > 0 && _times[_head] + N <= _time) {
+		_head = (_head + 1 == N) ? 0 : _head + 1;
+		_size--;
+	}
+	// les candidats moins bons que x ne peuvent plus être l'extremum
+	while (_size > 0) {
+		size_t back = (_head + _size - 1) % N;
+		if (better(_values[back], x)) {
+			break;
+		}
+		_size--;
+	}
+	size_t tail = (_head + _size) % N;
+	_values[tail] = x;
+	_times[tail] = _time;
+	_size++;
+	_time++;
+
+	return _values[_head];
+}
+
+template <typename Compare>
+void MovingExtremum<Compare>::process(const double *input, double *output, size_t n) {
+	for (size_t i = 0; i < n; i++) {
+		output[i] = MovingExtremum<Compare>::apply(input[i]);
+	}
+}
+
+template class MovingExtremum<std::less<double>>;
+template class MovingExtremum<std::greater<double>>;
+
+/* -------------------------------------------------------------------------- */
+
+MovingMedian::MovingMedian(size_t window) : _index(0), _count(0) {
+	set(window);
+}
+
+bool MovingMedian::set(size_t window) {
+	if (window < 1) {
+		std::cerr << "Window size must be positive" << std::endl;
+		return false;
+	}
+	_memory.assign(window, 0.0);
+	reset();
+	return true;
+}
+
+void MovingMedian::reset() {
+	_index = 0;
+	_count = 0;
+	_low.clear();
+	_high.clear();
+}
+
+void MovingMedian::rebalance() {
+	// _low contient la moitié basse, avec un élément de plus si le nombre est impair
+	while (_low.size() > _high.size() + 1) {
+		auto it = std::prev(_low.end());
+		_high.insert(*it);
+		_low.erase(it);
+	}
+	while (_high.size() > _low.size()) {
+		auto it = _high.begin();
+		_low.insert(*it);
+		_high.erase(it);
+	}
+}
+
+double MovingMedian::median() const {
+	double middle = *_low.rbegin();
+	if (_low.size() == _high.size()) {
+		return 0.5 * (middle + *_high.begin());
+	}
+	return middle;
+}
+
+double MovingMedian::apply(double x) {
+	const size_t N = _memory.size();
+
+	// retrait de l'échantillon qui sort de la fenêtre
+	if (_count == N) {
+		double old = _memory[_index];
+		if (old <= *_low.rbegin()) {
+			_low.erase(_low.find(old));
+		} else {
+			_high.erase(_high.find(old));
+		}
+	} else {
+		_count++;
+	}
+
+	// toute valeur de _low reste inférieure ou égale à toute valeur de _high
+	bool lower = _low.empty() ? (_high.empty() || x <= *_high.begin()) : (x <= *_low.rbegin());
+	if (lower) {
+		_low.insert(x);
+	} else {
+		_high.insert(x);
+	}
+	rebalance();
+
+	_memory[_index] = x;
+	if (++_index == N) {
+		_index = 0;
+	}
+	return median();
+}
+
+void MovingMedian::process(const double *input, double *output, size_t n) {
+	for (size_t i = 0; i < n; i++) {
+		output[i] = MovingMedian::apply(input[i]);
+	}
+}
+
+/* -------------------------------------------------------------------------- */
+
+MovingVariance::MovingVariance(size_t window) : _index(0), _count(0), _mean(0.0), _m2(0.0) {
+	set(window);
+}
+
+bool MovingVariance::set(size_t window) {
+	if (window < 2) {
+		std::cerr << "Window size must be at least 2" << std::endl;
+		return false;
+	}
+	_memory.assign(window, 0.0);
+	reset();
+	return true;
+}
+
+void MovingVariance::reset() {
+	_index = 0;
+	_count = 0;
+	_mean = 0.0;
+	_m2 = 0.0;
+}
+
+void MovingVariance::recompute() {
+	double sum = 0.0;
+	for (size_t i = 0; i < _count; i++) {
+		sum += _memory[i];
+	}
+	_mean = sum / static_cast<double>(_count);
+	double m2 = 0.0;
+	for (size_t i = 0; i < _count; i++) {
+		double d = _memory[i] - _mean;
+		m2 += d * d;
+	}
+	_m2 = m2;
+}
+
+double MovingVariance::variance() const {
+	return (_count > 1) ? std::max(_m2, 0.0) / static_cast<double>(_count - 1) : 0.0;
+}
+
+double MovingVariance::deviation() const {
+	return std::sqrt(variance());
+}
+
+double MovingVariance::apply(double x) {
+	const size_t N = _memory.size();
+
+	if (_count < N) {
+		// ajout d'un échantillon (Welford)
+		_count++;
+		double delta = x - _mean;
+		_mean += delta / static_cast<double>(_count);
+		_m2 += delta * (x - _mean);
+	} else {
+		// remplacement de l'échantillon le plus ancien
+		double old = _memory[_index];
+		double delta = x - old;
+		double mean = _mean + delta / static_cast<double>(N);
+		_m2 += delta * (x - mean + old - _mean);
+		_mean = mean;
+	}
+	_memory[_index] = x;
+
+	if (++_index == N) {
+		_index = 0;
+		recompute();
+	}
+	return variance();
+}
+
+void MovingVariance::process(const double *input, double *output, size_t n) {
+	for (size_t i = 0; i < n; i++) {
+		output[i] = MovingVariance::apply(input[i]);
+	}
+}
+
+/* -------------------------------------------------------------------------- */
+
+std::unique_ptr<MovingFilter> createMovingFilter(MovingFilterType type, size_t window) {
+	if (window < 1 || (type == MovingFilterType::VARIANCE && window < 2)) {
+		std::cerr << "Invalid window size for the moving filter" << std::endl;
+		return nullptr;
+	}
+
+	switch (type) {
+		case MovingFilterType::MEAN:
+			return std::make_unique<MovingAverage>(window);
+		case MovingFilterType::EMA: {
+			auto filter = std::make_unique<ExponentialMovingAverage>();
+			filter->setWindow(window);
+			return filter;
+		}
+		case MovingFilterType::MEDIAN:
+			return std::make_unique<MovingMedian>(window);
+		case MovingFilterType::MINIMUM:
+			return std::make_unique<MovingMinimum>(window);
+		case MovingFilterType::MAXIMUM:
+			return std::make_unique<MovingMaximum>(window);
+		case MovingFilterType::VARIANCE:
+			return std::make_unique<MovingVariance>(window);
+	}
+	return nullptr;
+}
@@ -0,0 +1,239 @@
+#ifndef __MOVINGFILTER_HPP
+#define __MOVINGFILTER_HPP
+
+#include <vector>
+#include <set>
+#include <memory>
+#include <functional>
+#include "Signal.hpp"
+
+/**
+ * @brief Type of a moving window statistic
+ */
+enum class MovingFilterType {
+	MEAN,     // Moving average
+	EMA,      // Exponential moving average
+	MEDIAN,   // Moving median
+	MINIMUM,  // Moving minimum
+	MAXIMUM,  // Moving maximum
+	VARIANCE, // Moving variance
+};
+
+/**
+ * @brief Base class of the streaming moving window filters
+ * @details Every filter keeps its state between calls, so that a stream can be
+ *          processed sample by sample or block by block with the same result.
+ *          Until the window is full, the statistic is computed on the samples
+ *          received so far.
+ */
+class MovingFilter {
+public:
+	virtual ~MovingFilter() = default;
+
+	/**
+	 * @brief Forget the samples received so far
+	 */
+	virtual void reset() = 0;
+
+	/**
+	 * @brief Filter one sample
+	 * @param[in] x Input sample
+	 * @return Statistic of the window ending on this sample
+	 */
+	virtual double apply(double x) = 0;
+
+	/**
+	 * @brief Filter a block of samples, following the previous one
+	 * @param[in] input Input samples
+	 * @param[out] output Output samples (may be equal to input)
+	 * @param[in] n Number of samples
+	 */
+	virtual void process(const double *input, double *output, size_t n) = 0;
+
+	/**
+	 * @brief Filter a complete signal from an empty window
+	 * @param[in] input Input signal
+	 * @return Filtered signal
+	 */
+	Signal apply(const Signal &input);
+};
+
+/**
+ * @brief Moving average with a drift-free running sum
+ * @details The sum is updated in O(1) with a compensated (Kahan) addition, and
+ *          recomputed exactly from the window every time the window wraps around,
+ *          so that rounding errors cannot accumulate over long streams.
+ */
+class MovingAverage : public MovingFilter {
+public:
+	MovingAverage(size_t window = 1);
+
+	/**
+	 * @brief Set the size of the window
+	 * @return true if the size is valid, false otherwise
+	 */
+	bool set(size_t window);
+
+	void reset() override;
+	double apply(double x) override;
+	void process(const double *input, double *output, size_t n) override;
+	using MovingFilter::apply;
+
+private:
+	inline void add(double value);
+
+	std::vector<double> _memory;
+	size_t _index;
+	size_t _count;
+	double _sum;
+	double _compensation;
+};
+
+/**
+ * @brief Exponential moving average y(n) = y(n-1) + alpha.(x(n) - y(n-1))
+ * @details The first sample initializes the output.
+ */
+class ExponentialMovingAverage : public MovingFilter {
+public:
+	ExponentialMovingAverage(double alpha = 1.0);
+
+	/**
+	 * @brief Set the smoothing factor
+	 * @param[in] alpha Smoothing factor (0 < alpha <= 1)
+	 * @return true if the factor is valid, false otherwise
+	 */
+	bool set(double alpha);
+
+	/**
+	 * @brief Set the smoothing factor equivalent to a moving average (alpha = 2/(window+1))
+	 * @param[in] window Size of the equivalent window
+	 */
+	bool setWindow(size_t window);
+
+	void reset() override;
+	double apply(double x) override;
+	void process(const double *input, double *output, size_t n) override;
+	using MovingFilter::apply;
+
+private:
+	double _alpha;
+	double _value;
+	bool _initialized;
+};
+
+/**
+ * @brief Moving minimum or maximum with a monotonic deque (amortized O(1))
+ * @tparam Compare std::less for the minimum, std::greater for the maximum
+ * @details The deque is stored in a ring of the size of the window, so that no
+ *          allocation happens while filtering.
+ */
+template <typename Compare>
+class MovingExtremum : public MovingFilter {
+public:
+	MovingExtremum(size_t window = 1) { set(window); }
+
+	/**
+	 * @brief Set the size of the window
+	 * @return true if the size is valid, false otherwise
+	 */
+	bool set(size_t window);
+
+	void reset() override;
+	double apply(double x) override;
+	void process(const double *input, double *output, size_t n) override;
+	using MovingFilter::apply;
+
+private:
+	size_t _window;
+	size_t _time;                 // index of the next sample
+	std::vector<double> _values;  // ring of the candidates, best one at _head
+	std::vector<size_t> _times;
+	size_t _head, _size;
+};
+
+using MovingMinimum = MovingExtremum<std::less<double>>;
+using MovingMaximum = MovingExtremum<std::greater<double>>;
+
+/**
+ * @brief Moving median with two balanced multisets (O(log n) per sample)
+ * @details The lower half of the window is kept in one set and the upper half in
+ *          the other; the median is read at their boundary. For an even window,
+ *          the mean of the two middle values is returned.
+ */
+class MovingMedian : public MovingFilter {
+public:
+	MovingMedian(size_t window = 1);
+
+	/**
+	 * @brief Set the size of the window
+	 * @return true if the size is valid, false otherwise
+	 */
+	bool set(size_t window);
+
+	void reset() override;
+	double apply(double x) override;
+	void process(const double *input, double *output, size_t n) override;
+	using MovingFilter::apply;
+
+private:
+	void rebalance();
+	double median() const;
+
+	std::vector<double> _memory;
+	size_t _index;
+	size_t _count;
+	std::multiset<double> _low;  // lower half, its largest value is the median
+	std::multiset<double> _high; // upper half
+};
+
+/**
+ * @brief Moving variance (unbiased, with Bessel correction) of the window
+ * @details The mean and the sum of squared deviations are updated in O(1) with
+ *          Welford's update for a replaced sample, and recomputed exactly every
+ *          time the window wraps around.
+ */
+class MovingVariance : public MovingFilter {
+public:
+	MovingVariance(size_t window = 2);
+
+	/**
+	 * @brief Set the size of the window
+	 * @return true if the size is valid, false otherwise
+	 */
+	bool set(size_t window);
+
+	void reset() override;
+	double apply(double x) override;
+	void process(const double *input, double *output, size_t n) override;
+	using MovingFilter::apply;
+
+	/**
+	 * @brief Mean of the current window
+	 */
+	double mean() const { return _mean; }
+
+	/**
+	 * @brief Standard deviation of the current window
+	 */
+	double deviation() const;
+
+private:
+	void recompute();
+	double variance() const;
+
+	std::vector<double> _memory;
+	size_t _index;
+	size_t _count;
+	double _mean;
+	double _m2;
+};
+
+/**
+ * @brief Create a moving filter
+ * @param[in] type Statistic computed by the filter
+ * @param[in] window Size of the window (equivalent window for the exponential average)
+ * @return Filter, or nullptr if the window is not valid
+ */
+std::unique_ptr<MovingFilter> createMovingFilter(MovingFilterType type, size_t window);
+
+#endif // __MOVINGFILTER_HPP
@@ -59,6 +59,15 @@ bool PID::setOutputLimits(double outMin, double outMax) {
 	return true;
 }
 
+bool PID::setSampleTime(double deltaTime) {
+	if (deltaTime <= 0) {
+		std::cerr << "The sample time must be greater than zero" << std::endl;
+		return false;
+	}
+	this->deltaTime = deltaTime;
+	return true;
+}
+
 double PID::apply(double desired_value, double input) {
 	if (!is_set) {
 		std::cerr << "PID regulator is not set" << std::endl;
@@ -71,6 +80,7 @@ double PID::apply(double desired_value, double input) {
 	integral += error * deltaTime;
 	// The derivative is the rate of change of the error
 	double derivative = (error - last_error) / deltaTime;
+	last_error = error;
 	// The output is the sum of the proportional, integral, and derivative
 	double output = kp * error + ki * integral + kd * derivative;
 
@@ -78,12 +88,13 @@ double PID::apply(double desired_value, double input) {
 	// be within the limits and prevent the system from overshooting the desired value
 	if (output < outMin) {
 		output = outMin;
-		if (error > 0) {
+		// Anti-windup: undo the integration only when it pushes the output further past the limit
+		if (error < 0) {
 			integral -= error * deltaTime;
 		}
 	} else if (output > outMax) {
 		output = outMax;
-		if (error < 0) {
+		if (error > 0) {
 			integral -= error * deltaTime;
 		}
 	}
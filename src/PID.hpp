@@ -58,6 +58,18 @@ public:
 	 */
 	bool setOutputLimits(double outMin, double outMax);
 
+	/**
+	 * Set the time between two calls to apply()
+	 * @param[in] deltaTime Sample time in seconds (1/SAMPLING_FREQUENCY by default)
+	 */
+	bool setSampleTime(double deltaTime);
+
+	/**
+	 * @brief Returns et the sample time
+	 * @return Sample time in seconds
+	 */
+	double getSampleTime() { return deltaTime; }
+
 	/**
 	 * @brief Returns et the proportional gain
 	 * @return Proportional gain
@@ -0,0 +1,218 @@
+#include "Polar.hpp"
+#include <cmath>
+#include <algorithm>
+
+namespace {
+
+// atan(z) sur [0, 1] : polynômes impairs minimax en z
+template <typename T>
+inline T atanUnit(T z, PolarPrecision precision) {
+	const T z2 = z * z;
+	switch (precision) {
+		case PolarPrecision::LOW:
+			return z * (T(0.99535795336506672) + z2 * (T(-0.28869022858639515) + z2 * T(0.079339031415764635)));
+		case PolarPrecision::MEDIUM:
+			return z * (T(0.99997721908150761) + z2 * (T(-0.33262282774110724) + z2 * (T(0.19354037476101935)
+				+ z2 * (T(-0.11642647807556233) + z2 * (T(0.052647346830706369) + z2 * T(-0.011719133808906971))))));
+		default:
+			return z * (T(0.99999933557854603) + z2 * (T(-0.33329860784241216) + z2 * (T(0.19946565644972603)
+				+ z2 * (T(-0.13908629501438236) + z2 * (T(0.096421971730247427) + z2 * (T(-0.055912324329691045)
+				+ z2 * (T(0.021862956002905651) + z2 * T(-0.0040545666537774314))))))));
+	}
+}
+
+// réduction au premier octant, sans branche pour permettre la vectorisation
+template <typename T>
+inline T atan2Poly(T y, T x, PolarPrecision precision) {
+	const T ax = std::abs(x);
+	const T ay = std::abs(y);
+	const T mx = (ax > ay) ? ax : ay;
+	const T mn = (ax > ay) ? ay : ax;
+	const T z = (mx > T(0)) ? mn / mx : T(0);
+	T a = atanUnit(z, precision);
+	a = (ay > ax) ? T(M_PI / 2) - a : a;
+	a = (x < T(0)) ? T(M_PI) - a : a;
+	return (y < T(0)) ? -a : a;
+}
+
+template <typename T>
+void convert(const T *re, const T *im, T *amplitude, T *phase, size_t n, PolarPrecision precision) {
+	if (amplitude != nullptr) {
+		for (size_t i = 0; i < n; i++) {
+			amplitude[i] = std::sqrt(re[i] * re[i] + im[i] * im[i]);
+		}
+	}
+	if (precision == PolarPrecision::EXACT) {
+		for (size_t i = 0; i < n; i++) {
+			phase[i] = std::atan2(im[i], re[i]);
+		}
+		return;
+	}
+	// une boucle par précision : le polynôme est connu à la compilation
+	switch (precision) {
+		case PolarPrecision::LOW:
+			for (size_t i = 0; i < n; i++) {
+				phase[i] = atan2Poly(im[i], re[i], PolarPrecision::LOW);
+			}
+			break;
+		case PolarPrecision::MEDIUM:
+			for (size_t i = 0; i < n; i++) {
+				phase[i] = atan2Poly(im[i], re[i], PolarPrecision::MEDIUM);
+			}
+			break;
+		default:
+			for (size_t i = 0; i < n; i++) {
+				phase[i] = atan2Poly(im[i], re[i], PolarPrecision::HIGH);
+			}
+			break;
+	}
+}
+
+} // namespace
+
+PolarConverter::PolarConverter() : _precision(PolarPrecision::MEDIUM), _unwrap(false), _hasLast(false), _last(0.0), _offset(0.0), _lastFixed(0) {
+	set();
+}
+
+void PolarConverter::set(PolarPrecision precision, bool unwrap) {
+	_precision = precision;
+	_unwrap = unwrap;
+
+	const int iterations = cordicIterations(_precision);
+	_angles.resize(iterations);
+	for (int i = 0; i < iterations; i++) {
+		// atan(2^-i) en angle binaire (2^32 pour un tour)
+		_angles[i] = static_cast<int32_t>(std::llround(std::atan(std::ldexp(1.0, -i)) / (2.0 * M_PI) * 4294967296.0));
+	}
+	reset();
+}
+
+void PolarConverter::reset() {
+	_hasLast = false;
+	_last = 0.0;
+	_offset = 0.0;
+	_lastFixed = 0;
+}
+
+int PolarConverter::cordicIterations(PolarPrecision precision) {
+	switch (precision) {
+		case PolarPrecision::LOW:    return 12;
+		case PolarPrecision::MEDIUM: return 20;
+		case PolarPrecision::HIGH:   return 26;
+		default:                     return 30;
+	}
+}
+
+double PolarConverter::atan2(double y, double x, PolarPrecision precision) {
+	if (precision == PolarPrecision::EXACT) {
+		return std::atan2(y, x);
+	}
+	return atan2Poly(y, x, precision);
+}
+
+float PolarConverter::atan2(float y, float x, PolarPrecision precision) {
+	if (precision == PolarPrecision::EXACT) {
+		return std::atan2(y, x);
+	}
+	return atan2Poly(y, x, precision);
+}
+
+template <typename T>
+void PolarConverter::unwrap(T *phase, size_t n) {
+	for (size_t i = 0; i < n; i++) {
+		double p = static_cast<double>(phase[i]);
+		if (_hasLast) {
+			double delta = p - _last;
+			if (delta > M_PI) {
+				_offset -= 2.0 * M_PI;
+			} else if (delta < -M_PI) {
+				_offset += 2.0 * M_PI;
+			}
+		}
+		_hasLast = true;
+		_last = p;
+		phase[i] = static_cast<T>(p + _offset);
+	}
+}
+
+void PolarConverter::process(const double *re, const double *im, double *amplitude, double *phase, size_t n) {
+	convert(re, im, amplitude, phase, n, _precision);
+	if (_unwrap) {
+		unwrap(phase, n);
+	}
+}
+
+void PolarConverter::process(const double *iq, size_t stride, double *amplitude, double *phase, size_t n) {
+	// désentrelacement par blocs, pour garder les boucles de conversion contiguës
+	const size_t BLOCK = 256;
+	double re[BLOCK], im[BLOCK];
+	for (size_t start = 0; start < n; start += BLOCK) {
+		const size_t count = std::min(BLOCK, n - start);
+		const double *sample = iq + start * stride;
+		for (size_t i = 0; i < count; i++, sample += stride) {
+			re[i] = sample[0];
+			im[i] = sample[1];
+		}
+		process(re, im, (amplitude != nullptr) ? amplitude + start : nullptr, phase + start, count);
+	}
+}
+
+void PolarConverter::process(const float *re, const float *im, float *amplitude, float *phase, size_t n) {
+	convert(re, im, amplitude, phase, n, _precision);
+	if (_unwrap) {
+		unwrap(phase, n);
+	}
+}
+
+void PolarConverter::process(const int32_t *re, const int32_t *im, int32_t *amplitude, int64_t *phase, size_t n) {
+	const int iterations = static_cast<int>(_angles.size());
+	// gain de la CORDIC, 1/prod(sqrt(1 + 2^-2i)) en Q31
+	double gain = 1.0;
+	for (int i = 0; i < iterations; i++) {
+		gain /= std::sqrt(1.0 + std::ldexp(1.0, -2 * i));
+	}
+	const int64_t scale = std::llround(gain * 2147483648.0);
+
+	for (size_t k = 0; k < n; k++) {
+		int64_t x = re[k];
+		int64_t y = im[k];
+		uint32_t angle = 0;
+		// demi-plan gauche : rotation de pi
+		if (x < 0) {
+			x = -x;
+			y = -y;
+			angle = 0x80000000u;
+		}
+		// mode vectoriel : y est ramené à 0, l'angle parcouru est accumulé
+		for (int i = 0; i < iterations; i++) {
+			int64_t dx = y >> i;
+			int64_t dy = x >> i;
+			if (y > 0) {
+				x += dx;
+				y -= dy;
+				angle += static_cast<uint32_t>(_angles[i]);
+			} else {
+				x -= dx;
+				y += dy;
+				angle -= static_cast<uint32_t>(_angles[i]);
+			}
+		}
+		if (amplitude != nullptr) {
+			amplitude[k] = static_cast<int32_t>((x * scale) >> 31);
+		}
+
+		int32_t wrapped = static_cast<int32_t>(angle);
+		if (_unwrap) {
+			// la différence en angle binaire sur 32 bits est déjà ramenée dans [-pi, pi[
+			if (_hasLast) {
+				_lastFixed += static_cast<int32_t>(angle - static_cast<uint32_t>(_lastFixed));
+			} else {
+				_lastFixed = wrapped;
+				_hasLast = true;
+			}
+			phase[k] = _lastFixed;
+		} else {
+			phase[k] = wrapped;
+		}
+	}
+}
@@ -0,0 +1,111 @@
+#ifndef __POLAR_HPP
+#define __POLAR_HPP
+
+#include <vector>
+#include <cstdint>
+#include "globals.hpp"
+
+/**
+ * @brief Precision of the conversion to amplitude and phase
+ * @details Maximum phase error of the floating point kernels (polynomial atan2),
+ *          and number of iterations of the fixed point CORDIC:
+ *          LOW 6e-4 rad (12 iterations), MEDIUM 2e-6 rad (20 iterations),
+ *          HIGH 4e-8 rad (26 iterations), EXACT std::atan2 (30 iterations).
+ */
+enum class PolarPrecision {
+	LOW,
+	MEDIUM,
+	HIGH,
+	EXACT,
+};
+
+/**
+ * @brief Conversion of I/Q streams to amplitude and phase
+ * @details The phase is computed by a polynomial approximation of atan2 without
+ *          branches, so the loops over the samples are vectorized; the amplitude is
+ *          sqrt(I^2 + Q^2). The fixed point variant uses a CORDIC in vectoring mode.
+ *          When unwrapping is enabled, the phase is made continuous across the
+ *          samples and across the calls to process(), until reset().
+ */
+class PolarConverter {
+public:
+	PolarConverter();
+
+	/**
+	 * @brief Set the parameters of the converter
+	 * @param[in] precision Precision of the phase
+	 * @param[in] unwrap True to remove the 2.pi jumps of the phase
+	 */
+	void set(PolarPrecision precision = PolarPrecision::MEDIUM, bool unwrap = false);
+
+	/**
+	 * @brief Forget the last phase (start of a new stream)
+	 */
+	void reset();
+
+	/**
+	 * @brief Convert a block of I/Q samples, following the previous one
+	 * @param[in] re In-phase components
+	 * @param[in] im Quadrature components
+	 * @param[out] amplitude Amplitudes (may be nullptr)
+	 * @param[out] phase Phases in ]-pi, pi], or unwrapped
+	 * @param[in] n Number of samples
+	 */
+	void process(const double *re, const double *im, double *amplitude, double *phase, size_t n);
+
+	/**
+	 * @brief Convert a block of interleaved I/Q samples, following the previous one
+	 * @param[in] iq Samples, I of sample i at iq[i*stride] and Q at iq[i*stride + 1]
+	 * @param[in] stride Distance between two samples (2 for complex numbers)
+	 * @param[out] amplitude Amplitudes (may be nullptr)
+	 * @param[out] phase Phases in ]-pi, pi], or unwrapped
+	 * @param[in] n Number of samples
+	 */
+	void process(const double *iq, size_t stride, double *amplitude, double *phase, size_t n);
+
+	/**
+	 * @brief Single precision variant
+	 */
+	void process(const float *re, const float *im, float *amplitude, float *phase, size_t n);
+
+	/**
+	 * @brief Fixed point variant (CORDIC)
+	 * @param[in] re In-phase components, |re| < 2^30
+	 * @param[in] im Quadrature components, |im| < 2^30
+	 * @param[out] amplitude Amplitudes, same scale as the inputs (may be nullptr)
+	 * @param[out] phase Phases in binary angle, 2^32 for a turn: in [-2^31, 2^31[, or unwrapped
+	 * @param[in] n Number of samples
+	 * @note The truncations of the iterations add an error of about iterations/|z| rad,
+	 *       the inputs should use most of their range.
+	 */
+	void process(const int32_t *re, const int32_t *im, int32_t *amplitude, int64_t *phase, size_t n);
+
+	/**
+	 * @brief Approximation of atan2(y, x) in ]-pi, pi]
+	 */
+	static double atan2(double y, double x, PolarPrecision precision);
+	static float atan2(float y, float x, PolarPrecision precision);
+
+	/**
+	 * @brief Number of CORDIC iterations used for a precision
+	 */
+	static int cordicIterations(PolarPrecision precision);
+
+	PolarPrecision getPrecision() const { return _precision; }
+	bool isUnwrapping() const { return _unwrap; }
+
+private:
+	// déroulement de la phase en place, à la suite du bloc précédent
+	template <typename T>
+	void unwrap(T *phase, size_t n);
+
+	PolarPrecision _precision;
+	bool _unwrap;
+	bool _hasLast;
+	double _last;    // last wrapped phase
+	double _offset;  // multiple of 2.pi added to the wrapped phase
+	int64_t _lastFixed;
+	std::vector<int32_t> _angles; // atan(2^-i) in binary angle
+};
+
+#endif // __POLAR_HPP
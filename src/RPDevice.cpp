@@ -0,0 +1,210 @@
+#include "RPDevice.hpp"
+#include <unistd.h>
+#include <chrono>
+#include <thread>
+#include <stdexcept>
+#include <algorithm>
+#include "acquisition.hpp"
+#include "globals.hpp"
+
+RPDevice::RPDevice() : _buffers(NULL), _bufferSize(0), _streaming(false), _streamSize(0)
+{}
+
+RPDevice::~RPDevice() {
+	stop();
+	release();
+}
+
+bool RPDevice::open() {
+	return rp_InitReset(true) == RP_OK;
+}
+
+void RPDevice::close() {
+	stop();
+	release();
+	rp_Release();
+}
+
+double RPDevice::now() {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void RPDevice::waitUntil(double time) {
+	double remaining = time - now();
+	if (remaining > 0) {
+		std::this_thread::sleep_for(std::chrono::duration<double>(remaining));
+	}
+}
+
+void RPDevice::reset() {
+	rp_GenReset();
+}
+
+void RPDevice::setWaveform(rp_waveform_t waveform) {
+	rp_GenWaveform(RP_CH_1, waveform);
+}
+
+void RPDevice::setArbitraryWaveform(const float *data, size_t size) {
+	std::vector<float> waveform(data, data + size);
+	rp_GenArbWaveform(RP_CH_1, waveform.data(), static_cast<uint32_t>(size));
+}
+
+void RPDevice::setFrequency(double frequency) {
+	rp_GenFreq(RP_CH_1, static_cast<float>(frequency));
+}
+
+void RPDevice::setAmplitude(double amplitude) {
+	rp_GenAmp(RP_CH_1, static_cast<float>(amplitude));
+}
+
+void RPDevice::setOffset(double offset) {
+	rp_GenOffset(RP_CH_1, static_cast<float>(offset));
+}
+
+void RPDevice::setPhase(double phase) {
+	rp_GenPhase(RP_CH_1, static_cast<float>(phase));
+}
+
+void RPDevice::setDutyCycle(double duty_cycle) {
+	rp_GenDutyCycle(RP_CH_1, static_cast<float>(duty_cycle));
+}
+
+void RPDevice::enable() {
+	rp_GenOutEnable(RP_CH_1);
+	rp_GenTriggerOnly(RP_CH_1);
+}
+
+void RPDevice::disable() {
+	rp_GenOutDisable(RP_CH_1);
+}
+
+void RPDevice::init(float trigger_level, int32_t trigger_delay) {
+	rp_AcqReset();
+	rp_AcqSetTriggerLevel(RP_T_CH_1, trigger_level);
+	rp_AcqSetTriggerLevel(RP_T_CH_2, trigger_level);
+	rp_AcqSetTriggerDelay(trigger_delay);
+
+	release();
+	_buffers = (buffers_t *) rp_createBuffer(2, BUFFER_SIZE, false, true, false);
+	_bufferSize = BUFFER_SIZE;
+}
+
+void RPDevice::release() {
+	if (_buffers != NULL) rp_deleteBuffer(_buffers);
+	_buffers = NULL;
+	_bufferSize = 0;
+}
+
+void RPDevice::acquire(Signal *channel1, Signal *channel2, rp_acq_trig_src_t trigger) {
+	if (_buffers == NULL || _bufferSize < BUFFER_SIZE) {
+		// tampons absents ou trop petits pour la taille courante
+		release();
+		_buffers = (buffers_t *) rp_createBuffer(2, BUFFER_SIZE, false, true, false);
+		_bufferSize = BUFFER_SIZE;
+		if (_buffers == NULL) {
+			throw std::runtime_error("Unable to allocate the acquisition buffers");
+		}
+	}
+
+	rp_AcqSetDecimationFactor(DECIMATION);
+	int timeDelay = getTimeDelay(DECIMATION);
+	rp_acq_trig_state_t state = RP_TRIG_STATE_TRIGGERED;
+	bool fillState = false;
+
+	/* Echantillonnage du signal */
+	rp_AcqStart();
+	usleep(timeDelay);
+	rp_AcqSetTriggerSrc(trigger);
+
+	while(1) {
+		rp_AcqGetTriggerState(&state);
+		if(state == RP_TRIG_STATE_TRIGGERED) {
+			break;
+		}
+	}
+	while(!fillState){
+		rp_AcqGetBufferFillState(&fillState);
+	}
+
+	rp_AcqStop();
+
+	uint32_t pos = 0;
+	rp_AcqGetWritePointerAtTrig(&pos);
+
+	rp_AcqGetData(pos, _buffers);
+
+	/* Enrgistrement du buffer */
+	if (channel1 != nullptr) {
+		channel1->resize(BUFFER_SIZE);
+		for (size_t i = 0; i < BUFFER_SIZE; i++) (*channel1)[i] = _buffers->ch_d[0][i];
+	}
+	if (channel2 != nullptr) {
+		channel2->resize(BUFFER_SIZE);
+		for (size_t i = 0; i < BUFFER_SIZE; i++) (*channel2)[i] = _buffers->ch_d[1][i];
+	}
+}
+
+size_t RPDevice::start(size_t samples) {
+	stop();
+
+	uint32_t address = 0, size = 0;
+	if (rp_AcqAxiGetMemoryRegion(&address, &size) != RP_OK) {
+		throw std::runtime_error("Unable to get the memory reserved for the DMA");
+	}
+	// la mémoire réservée est partagée entre les deux entrées (échantillons de 16 bits)
+	_streamSize = std::min<size_t>(samples, size / 2 / sizeof(int16_t));
+	if (_streamSize == 0) {
+		throw std::runtime_error("No memory reserved for the DMA");
+	}
+
+	rp_AcqReset();
+	rp_AcqAxiSetDecimationFactor(DECIMATION);
+	rp_AcqAxiSetTriggerDelay(RP_CH_1, static_cast<int32_t>(_streamSize));
+	rp_AcqAxiSetTriggerDelay(RP_CH_2, static_cast<int32_t>(_streamSize));
+	rp_AcqAxiSetBufferSamples(RP_CH_1, address, static_cast<uint32_t>(_streamSize));
+	rp_AcqAxiSetBufferSamples(RP_CH_2, address + size / 2, static_cast<uint32_t>(_streamSize));
+	rp_AcqAxiEnable(RP_CH_1, true);
+	rp_AcqAxiEnable(RP_CH_2, true);
+
+	// sans déclenchement, l'écriture tourne dans l'anneau jusqu'à l'arrêt
+	rp_AcqStart();
+	rp_AcqSetTriggerSrc(RP_TRIG_SRC_DISABLED);
+
+	_stream.resize(_streamSize);
+	_streaming = true;
+	return _streamSize;
+}
+
+void RPDevice::stop() {
+	if (!_streaming) return;
+	rp_AcqStop();
+	rp_AcqAxiEnable(RP_CH_1, false);
+	rp_AcqAxiEnable(RP_CH_2, false);
+	_streaming = false;
+}
+
+size_t RPDevice::getWritePointer() {
+	uint32_t pos = 0;
+	rp_AcqAxiGetWritePointer(RP_CH_1, &pos);
+	return pos % _streamSize;
+}
+
+void RPDevice::read(size_t position, size_t count, double *channel1, double *channel2) {
+	double *outputs[2] = {channel1, channel2};
+	const rp_channel_t channels[2] = {RP_CH_1, RP_CH_2};
+
+	for (int c = 0; c < 2; c++) {
+		if (outputs[c] == nullptr) continue;
+		// copie en deux morceaux si la lecture passe la fin de l'anneau
+		size_t done = 0;
+		while (done < count) {
+			size_t pos = (position + done) % _streamSize;
+			uint32_t size = static_cast<uint32_t>(std::min(count - done, _streamSize - pos));
+			if (rp_AcqAxiGetDataV(channels[c], static_cast<uint32_t>(pos), &size, _stream.data()) != RP_OK || size == 0) {
+				throw std::runtime_error("Unable to read the DMA ring");
+			}
+			for (size_t i = 0; i < size; i++) outputs[c][done + i] = _stream[i];
+			done += size;
+		}
+	}
+}
@@ -0,0 +1,58 @@
+#ifndef __RPDEVICE_HPP
+#define __RPDEVICE_HPP
+
+#include "rp.h"
+#include "rp_hw-calib.h"
+#include "rp_hw-profiles.h"
+
+#include <vector>
+#include "Device.hpp"
+
+/**
+ * @brief Red Pitaya driven through librp (generator on output 1)
+ * @note The only translation unit calling librp, left out of the simulation build
+ */
+class RPDevice : public Device, public GeneratorBackend, public AcquisitionBackend, public StreamBackend {
+public:
+	RPDevice();
+	~RPDevice() override;
+
+	bool open() override;
+	void close() override;
+	GeneratorBackend &generator() override { return *this; }
+	AcquisitionBackend &acquisition() override { return *this; }
+	StreamBackend &stream() override { return *this; }
+	double now() override;
+	void waitUntil(double time) override;
+	bool isSimulated() const override { return false; }
+
+	void reset() override;
+	void setWaveform(rp_waveform_t waveform) override;
+	void setArbitraryWaveform(const float *data, size_t size) override;
+	void setFrequency(double frequency) override;
+	void setAmplitude(double amplitude) override;
+	void setOffset(double offset) override;
+	void setPhase(double phase) override;
+	void setDutyCycle(double duty_cycle) override;
+	void enable() override;
+	void disable() override;
+
+	void init(float trigger_level, int32_t trigger_delay) override;
+	void release() override;
+	void acquire(Signal *channel1, Signal *channel2, rp_acq_trig_src_t trigger = RP_TRIG_SRC_CHA_PE) override;
+
+	size_t start(size_t samples) override;
+	void stop() override;
+	size_t getWritePointer() override;
+	void read(size_t position, size_t count, double *channel1, double *channel2) override;
+
+private:
+	buffers_t *_buffers;
+	size_t _bufferSize; // size of the buffers allocated by init()
+
+	bool _streaming;
+	size_t _streamSize;         // size of the DMA ring of each input
+	std::vector<float> _stream; // samples copied from the DMA ring
+};
+
+#endif // __RPDEVICE_HPP
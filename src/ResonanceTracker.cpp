@@ -0,0 +1,105 @@
+#include "ResonanceTracker.hpp"
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include <iostream>
+#include "globals.hpp"
+
+ResonanceTracker::ResonanceTracker() :
+	_startFrequency(0.0), _targetPhase(0.0), _span(0.0), _freqFilter(0.0), _updateRate(0.0),
+	_kp(0.0), _ki(0.0), _kd(0.0), _frequency(0.0), _phaseError(0.0), _updates(0),
+	_transientSize(0), _transientLength(0), _isSetup(false)
+{}
+
+bool ResonanceTracker::set(double start_frequency, double target_phase, double kp, double ki, double kd, double span, double freq_filter, double update_rate, size_t capacity) {
+	if (start_frequency <= 0.0 || span <= 0.0 || span >= start_frequency) {
+		std::cerr << "The start frequency must be positive and greater than the span" << std::endl;
+		return false;
+	}
+	if (kp < 0.0 || ki < 0.0 || kd < 0.0) {
+		std::cerr << "kp, ki and kd must be greater than zero" << std::endl;
+		return false;
+	}
+	if (freq_filter <= 0.0 || update_rate <= 0.0 || capacity < 1) {
+		std::cerr << "Invalid parameters for the resonance tracker" << std::endl;
+		return false;
+	}
+
+	_startFrequency = start_frequency;
+	_targetPhase = target_phase;
+	_kp = kp;
+	_ki = ki;
+	_kd = kd;
+	_span = span;
+	_freqFilter = freq_filter;
+	_updateRate = update_rate;
+	_samples.setCapacity(capacity);
+	_isSetup = false;
+	return true;
+}
+
+void ResonanceTracker::setup() {
+	if (_startFrequency + _span >= SAMPLING_FREQUENCY / 2.0) {
+		throw std::invalid_argument("The tracked frequency must stay below the Nyquist frequency");
+	}
+
+	IIRFilter filter;
+	if (!filter.set(4, _freqFilter, 0, FilterGabarit::LOW_PASS, AnalogFilter::BUTTERWORTH)) {
+		throw std::invalid_argument("Error while setting the filter of the resonance tracker");
+	}
+	filter.setup();
+	_sections = filter.getSections();
+	_transientSize = 0;
+
+	// la sortie du PID est l'écart à la fréquence de départ
+	if (!_pid.set(_kp, _ki, _kd, -_span, _span) || !_pid.setSampleTime(1.0 / _updateRate)) {
+		throw std::invalid_argument("Error while setting the PID of the resonance tracker");
+	}
+	_isSetup = true;
+	reset();
+}
+
+void ResonanceTracker::reset() {
+	_frequency = _startFrequency;
+	_phaseError = 0.0;
+	_updates = 0;
+	_pid.reset();
+	_samples.clear();
+}
+
+TrackingSample ResonanceTracker::update(const Signal &excitation, const Signal &response) {
+	if (!_isSetup) {
+		throw std::invalid_argument("Resonance tracker is not set up");
+	}
+	if (excitation.size() != response.size()) {
+		throw std::invalid_argument("The excitation and the response must have the same size");
+	}
+
+	// fin du transitoire du filtre, recalculée seulement si la taille des acquisitions change
+	if (excitation.size() != _transientSize) {
+		IIRFilter filter;
+		filter.setup(_sections);
+		_transientSize = excitation.size();
+		_transientLength = filter.transientLength(_transientSize);
+		if (_transientLength >= _transientSize) {
+			throw std::runtime_error("The acquisitions are shorter than the transient of the demodulation filter");
+		}
+	}
+
+	_dem.set(_freqFilter, _frequency);
+	_dem.setup(_sections);
+	DualDemodulation result = _dem.applyRatio(excitation, response, _transientLength, true);
+
+	TrackingSample sample;
+	sample.time = static_cast<double>(_updates++) / _updateRate;
+	sample.frequency = _frequency;
+	sample.amplitude = result.amplitude2;
+	sample.gain = result.getGain();
+	sample.phase = result.getPhase();
+	_samples.push(sample);
+
+	// erreur de phase ramenée dans ]-pi, pi] ; une phase au-dessus de la cible fait monter la fréquence
+	_phaseError = std::remainder(sample.phase - _targetPhase, 2.0 * M_PI);
+	_frequency = _startFrequency + _pid.apply(_phaseError, 0.0);
+	return sample;
+}
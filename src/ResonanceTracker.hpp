@@ -0,0 +1,107 @@
+#ifndef __RESONANCETRACKER_HPP
+#define __RESONANCETRACKER_HPP
+
+#include <vector>
+#include "Signal.hpp"
+#include "Filter.hpp"
+#include "Demodulator.hpp"
+#include "PID.hpp"
+#include "RingBuffer.hpp"
+
+/**
+ * @brief State of the tracking loop after an update
+ */
+struct TrackingSample {
+	double time;      // time of the update in seconds, from the last reset
+	double frequency; // frequency of the generator during the acquisition
+	double amplitude; // RMS amplitude of the response (CH2)
+	double gain;      // gain of the response relative to the excitation, |CH2/CH1|
+	double phase;     // phase of the response relative to the excitation, in ]-pi, pi]
+};
+
+/**
+ * @brief Phase-locked loop holding the generator on a resonance
+ * @details Each update demodulates one acquisition of the excitation (CH1) and of the
+ *          response (CH2) at the current frequency of the generator, and measures the
+ *          phase of CH2/CH1. A PID controller turns the phase error into a frequency
+ *          offset from the start frequency, limited to +-span, so the generator follows
+ *          the frequency where the phase equals the target (0 rad at the resonance of a
+ *          band pass response). Updates are expected at a fixed rate, which sets the
+ *          sample time of the PID and the time of the logged samples.
+ * @note Through a resonance the phase decreases as the frequency increases: a phase
+ *       above the target raises the frequency.
+ */
+class ResonanceTracker {
+public:
+	ResonanceTracker();
+
+	/**
+	 * @brief Set the parameters of the loop
+	 * @param[in] start_frequency Frequency of the generator at the start, near the resonance
+	 * @param[in] target_phase Phase of CH2/CH1 to hold, in radians
+	 * @param[in] kp Proportional gain, in Hz/rad
+	 * @param[in] ki Integral gain, in Hz/(rad.s)
+	 * @param[in] kd Derivative gain, in Hz.s/rad
+	 * @param[in] span Maximum distance to the start frequency, in Hz
+	 * @param[in] freq_filter Cutoff frequency of the demodulation filter
+	 * @param[in] update_rate Number of updates per second
+	 * @param[in] capacity Number of samples kept in the log
+	 * @return true if the parameters are valid, false otherwise
+	 */
+	bool set(double start_frequency, double target_phase, double kp, double ki, double kd, double span, double freq_filter, double update_rate, size_t capacity = 4096);
+
+	/**
+	 * @brief Design the demodulation filter (at SAMPLING_FREQUENCY) and reset the loop
+	 */
+	void setup();
+
+	/**
+	 * @brief Go back to the start frequency and clear the log
+	 */
+	void reset();
+
+	/**
+	 * @brief Check if the tracker is setup
+	 */
+	bool isSetup() const { return _isSetup; }
+
+	/**
+	 * @brief Measure an acquisition made at getFrequency() and correct the frequency
+	 * @param[in] excitation Signal of CH1
+	 * @param[in] response Signal of CH2, same size
+	 * @return Measure of this update, also pushed into the log
+	 * @note The samples before the end of the transient of the filter are not used
+	 */
+	TrackingSample update(const Signal &excitation, const Signal &response);
+
+	/**
+	 * @brief Frequency to generate for the next acquisition
+	 */
+	double getFrequency() const { return _frequency; }
+
+	/**
+	 * @brief Phase error of the last update, in ]-pi, pi]
+	 */
+	double getPhaseError() const { return _phaseError; }
+
+	double getUpdateRate() const { return _updateRate; }
+
+	/**
+	 * @brief Last updates, from the oldest to the most recent
+	 */
+	const RingBuffer<TrackingSample> &getSamples() const { return _samples; }
+
+private:
+	double _startFrequency, _targetPhase, _span, _freqFilter, _updateRate;
+	double _kp, _ki, _kd;
+	double _frequency, _phaseError;
+	size_t _updates;
+	std::vector<Biquad> _sections;
+	size_t _transientSize, _transientLength; // transient of the filter, for signals of _transientSize samples
+	Demodulator _dem;
+	PID _pid;
+	RingBuffer<TrackingSample> _samples;
+	bool _isSetup;
+};
+
+#endif // __RESONANCETRACKER_HPP
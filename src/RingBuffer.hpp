@@ -0,0 +1,103 @@
+#ifndef __RINGBUFFER_HPP
+#define __RINGBUFFER_HPP
+
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+/**
+ * @brief Fixed capacity circular buffer keeping the most recent elements
+ * @tparam T Type of the elements
+ * @details When the buffer is full, a new element overwrites the oldest one and the
+ *          overwritten elements are counted. The buffer is not thread safe.
+ */
+template <typename T>
+class RingBuffer {
+public:
+	/**
+	 * @param capacity Maximum number of elements kept
+	 */
+	explicit RingBuffer(size_t capacity = 1024) : _data(std::max<size_t>(capacity, 1)), _head(0), _count(0), _overwritten(0) {}
+
+	/**
+	 * @brief Change the capacity, the elements are discarded
+	 */
+	void setCapacity(size_t capacity) {
+		_data.assign(std::max<size_t>(capacity, 1), T());
+		clear();
+	}
+
+	/**
+	 * @brief Discard the elements and reset the counter of overwritten elements
+	 */
+	void clear() {
+		_head = 0;
+		_count = 0;
+		_overwritten = 0;
+	}
+
+	/**
+	 * @brief Add an element, overwriting the oldest one if the buffer is full
+	 */
+	void push(const T &value) {
+		_data[_head] = value;
+		_head = (_head + 1 == _data.size()) ? 0 : _head + 1;
+		if (_count < _data.size()) {
+			_count++;
+		} else {
+			_overwritten++;
+		}
+	}
+
+	/**
+	 * @brief Remove the oldest element
+	 * @param[out] value Oldest element
+	 * @return false if the buffer is empty
+	 */
+	bool pop(T &value) {
+		if (_count == 0) {
+			return false;
+		}
+		value = (*this)[0];
+		_count--;
+		return true;
+	}
+
+	/**
+	 * @brief Element i, from the oldest (0) to the most recent (size() - 1)
+	 */
+	const T &operator[](size_t i) const {
+		size_t index = _head + _data.size() - _count + i;
+		if (index >= _data.size()) {
+			index -= _data.size();
+		}
+		return _data[index];
+	}
+
+	/**
+	 * @brief Most recent element
+	 */
+	const T &back() const {
+		if (_count == 0) {
+			throw std::out_of_range("The ring buffer is empty");
+		}
+		return (*this)[_count - 1];
+	}
+
+	size_t size() const { return _count; }
+	size_t capacity() const { return _data.size(); }
+	bool empty() const { return _count == 0; }
+
+	/**
+	 * @brief Number of elements overwritten before being read
+	 */
+	size_t getOverwritten() const { return _overwritten; }
+
+private:
+	std::vector<T> _data;
+	size_t _head;        // position of the next element written
+	size_t _count;
+	size_t _overwritten;
+};
+
+#endif // __RINGBUFFER_HPP
@@ -0,0 +1,124 @@
+#ifndef __SPSCQUEUE_HPP
+#define __SPSCQUEUE_HPP
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <algorithm>
+
+/**
+ * @brief Bounded lock-free queue between one producer thread and one consumer thread
+ * @tparam T Type of the elements, copied in and out of the queue
+ * @details push() is only called by the producer and pop() only by the consumer. Each
+ *          index is written by a single thread: the producer publishes an element by
+ *          moving the tail with a release store, the consumer frees it by moving the
+ *          head, so neither side ever waits on a lock.
+ *          waitPush() and waitPop() put the calling thread to sleep on a counter of
+ *          events (push, pop or close) instead of spinning, until the other side
+ *          moves or closes the queue.
+ */
+template <typename T>
+class SPSCQueue {
+public:
+	/**
+	 * @param capacity Maximum number of elements in the queue
+	 */
+	explicit SPSCQueue(size_t capacity = 16) : _data(std::max<size_t>(capacity, 1) + 1), _head(0), _tail(0), _events(0), _closed(false) {}
+
+	SPSCQueue(const SPSCQueue &) = delete;
+	SPSCQueue &operator=(const SPSCQueue &) = delete;
+
+	/**
+	 * @brief Add an element (producer only)
+	 * @return false if the queue is full
+	 */
+	bool push(const T &value) {
+		const size_t tail = _tail.load(std::memory_order_relaxed);
+		const size_t next = (tail + 1 == _data.size()) ? 0 : tail + 1;
+		if (next == _head.load(std::memory_order_acquire)) {
+			return false;
+		}
+		_data[tail] = value;
+		_tail.store(next, std::memory_order_release);
+		signal();
+		return true;
+	}
+
+	/**
+	 * @brief Add an element, sleeping while the queue is full (producer only)
+	 * @return false if the queue was closed before there was room
+	 */
+	bool waitPush(const T &value) {
+		for (;;) {
+			const uint32_t events = _events.load(std::memory_order_acquire);
+			if (_closed.load(std::memory_order_acquire)) return false;
+			if (push(value)) return true;
+			_events.wait(events, std::memory_order_acquire);
+		}
+	}
+
+	/**
+	 * @brief Remove the oldest element (consumer only)
+	 * @param[out] value Oldest element
+	 * @return false if the queue is empty
+	 */
+	bool pop(T &value) {
+		const size_t head = _head.load(std::memory_order_relaxed);
+		if (head == _tail.load(std::memory_order_acquire)) {
+			return false;
+		}
+		value = _data[head];
+		_head.store((head + 1 == _data.size()) ? 0 : head + 1, std::memory_order_release);
+		signal();
+		return true;
+	}
+
+	/**
+	 * @brief Remove the oldest element, sleeping while the queue is empty (consumer only)
+	 * @param[out] value Oldest element
+	 * @return false if the queue was closed and is empty
+	 */
+	bool waitPop(T &value) {
+		for (;;) {
+			const uint32_t events = _events.load(std::memory_order_acquire);
+			if (pop(value)) return true;
+			if (_closed.load(std::memory_order_acquire)) return false;
+			_events.wait(events, std::memory_order_acquire);
+		}
+	}
+
+	/**
+	 * @brief Close the queue and wake the sleeping side (either thread)
+	 * @note The elements already pushed can still be removed
+	 */
+	void close() {
+		_closed.store(true, std::memory_order_release);
+		signal();
+	}
+
+	bool isClosed() const { return _closed.load(std::memory_order_acquire); }
+
+	/**
+	 * @brief Check if the queue is empty, exact only from the consumer thread
+	 */
+	bool empty() const {
+		return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+	}
+
+	size_t capacity() const { return _data.size() - 1; }
+
+private:
+	// réveil du thread endormi dans waitPush() ou waitPop()
+	void signal() {
+		_events.fetch_add(1, std::memory_order_release);
+		_events.notify_all();
+	}
+
+	std::vector<T> _data;                  // one more slot than the capacity, to tell full from empty
+	alignas(64) std::atomic<size_t> _head; // next element read, written by the consumer
+	alignas(64) std::atomic<size_t> _tail; // next element written, written by the producer
+	alignas(64) std::atomic<uint32_t> _events; // incremented at each push, pop or close
+	std::atomic<bool> _closed;
+};
+
+#endif // __SPSCQUEUE_HPP
@@ -1,7 +1,10 @@
 #include <limits>
 #include <cmath>
+#include <sstream>
+#include <stdexcept>
 #include "Signal.hpp"
 #include "Spectrum.hpp"
+#include "Window.hpp"
 #include "utils.hpp"
 
 Signal::Signal(const std::string &name) : std::vector<double>(BUFFER_SIZE, 0.0), mName(name) {}
@@ -559,23 +562,9 @@ static unsigned int reverseBits(unsigned int n, unsigned int bits) {
 
 #define VERSION_FFT 1
 
-void Signal::FFT(Spectrum &output_spectrum, size_t sample_offset) const {
-    size_t p = BITS_PER_SAMPLE;
-    size_t N = 1 << BITS_PER_SAMPLE;
-    while (N > this->size() - sample_offset) {
-        N >>= 1;
-        p--;
-    }
-
-    std::vector<complexd> A(N);
-
-    // Réorganisation des éléments en fonction de l'inversion des bits
-    unsigned int j;
-    for (size_t k = 0; k < N; ++k) {
-        j = reverseBits(k, p);
-        A[j] = complexd((*this)[k + sample_offset], 0);
-    }
-
+// Étages papillons de la FFT, sur les échantillons déjà rangés dans l'ordre des bits inversés
+static void transformFFT(std::vector<complexd> &A, unsigned int p, Spectrum &output_spectrum) {
+    size_t N = A.size();
 #if VERSION_FFT == 1
     // version 1
     std::vector<complexd> B(N);
@@ -631,6 +620,67 @@ void Signal::FFT(Spectrum &output_spectrum, size_t sample_offset) const {
 #endif
 }
 
+// Plus grande puissance de 2 (au plus 2^BITS_PER_SAMPLE) contenue dans n échantillons
+static size_t sizeFFT(size_t n, unsigned int &p) {
+    p = BITS_PER_SAMPLE;
+    size_t N = 1 << BITS_PER_SAMPLE;
+    while (N > n) {
+        N >>= 1;
+        p--;
+    }
+    return N;
+}
+
+void Signal::FFT(Spectrum &output_spectrum, size_t sample_offset) const {
+    unsigned int p;
+    size_t N = sizeFFT(this->size() - sample_offset, p);
+
+    std::vector<complexd> A(N);
+
+    // Réorganisation des éléments en fonction de l'inversion des bits
+    unsigned int j;
+    for (size_t k = 0; k < N; ++k) {
+        j = reverseBits(k, p);
+        A[j] = complexd((*this)[k + sample_offset], 0);
+    }
+
+    transformFFT(A, p, output_spectrum);
+}
+
+void Signal::FFT(Spectrum &output_spectrum, const Window &window, size_t sample_offset) const {
+    FFT(output_spectrum, window, WindowCorrection::NONE, sample_offset);
+}
+
+void Signal::FFT(Spectrum &output_spectrum, const Window &window, WindowCorrection correction, size_t sample_offset) const {
+    if (window.getSize() != this->size()) {
+        std::stringstream ss;
+        ss << "Input signal size does not match window size. Input size: " << this->size() << ", window size: " << window.getSize();
+        throw std::runtime_error(ss.str());
+    }
+
+    unsigned int p;
+    size_t N = sizeFFT(this->size() - sample_offset, p);
+
+    const WindowTable &table = window.getTable();
+    double scale = 1.0;
+    if (correction == WindowCorrection::AMPLITUDE && table.coherentGain > 0.0) {
+        scale = 1.0 / table.coherentGain;
+    } else if (correction == WindowCorrection::ENERGY && table.coherentGain > 0.0) {
+        scale = 1.0 / (table.coherentGain * std::sqrt(table.enbw));
+    }
+
+    std::vector<complexd> A(N);
+
+    // Fenêtrage et correction pendant le rangement dans l'ordre des bits inversés
+    const double *x = this->data() + sample_offset;
+    const double *w = table.values.data() + sample_offset;
+    for (size_t k = 0; k < N; ++k) {
+        A[reverseBits(k, p)] = complexd(x[k] * w[k] * scale, 0);
+    }
+
+    transformFFT(A, p, output_spectrum);
+}
+
 /* ------------------------------- */
 
 double Signal::calculateNoiseRMS() const {
@@ -5,9 +5,11 @@
 #include <string.h>
 #include <vector>
 #include "globals.hpp"
-#include "rp.h"
+#include "rp_enums.h"
 
 class Spectrum;
+class Window;
+enum class WindowCorrection;
 
 class Signal : public std::vector<double> {
 private:
@@ -246,6 +248,27 @@ public:
 	 */
 	void FFT(Spectrum &output_spectrum, size_t sample_offset = 0) const;
 
+	/**
+	 * Fonction pour effectuer la FFT du signal fenêtré, sans copie intermédiaire
+	 * @param[out] output_spectrum Spectre du signal fenêtré
+	 * @param[in] window Fenêtre de la taille du signal
+	 * @param[in] sample_offset Premier échantillon transformé
+	 * @details Les échantillons sont multipliés par la fenêtre au moment où ils sont rangés
+	 *          dans l'ordre des bits inversés : le résultat est celui de window.apply() suivi
+	 *          de FFT(), sans le signal fenêtré intermédiaire.
+	 */
+	void FFT(Spectrum &output_spectrum, const Window &window, size_t sample_offset = 0) const;
+
+	/**
+	 * Fonction pour effectuer la FFT du signal fenêtré avec correction du gain de la fenêtre
+	 * @param[out] output_spectrum Spectre du signal fenêtré
+	 * @param[in] window Fenêtre de la taille du signal
+	 * @param[in] correction AMPLITUDE : amplitude des raies conservée (division par le gain cohérent),
+	 *            ENERGY : densité de bruit conservée (division par le gain cohérent et par racine de l'ENBW)
+	 * @param[in] sample_offset Premier échantillon transformé
+	 */
+	void FFT(Spectrum &output_spectrum, const Window &window, WindowCorrection correction, size_t sample_offset = 0) const;
+
 	/* ------------------------------- */
 
 	// Calculer le niveau RMS du bruit
@@ -258,4 +281,4 @@ public:
 	friend std::ostream& operator << (std::ostream &out, const Signal &signal);
 };
 
-#endif // __SIGNAL_HPP
\ No newline at end of file
+#endif // __SIGNAL_HPP
\ No newline at end of file
@@ -0,0 +1,273 @@
+#include "SimulatedDevice.hpp"
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <stdexcept>
+#include "acquisition.hpp"
+
+SimulatedDevice::SimulatedDevice() : SimulatedDevice(DeviceModel())
+{}
+
+SimulatedDevice::SimulatedDevice(const DeviceModel &model) :
+	_model(model), _waveform(RP_WAVEFORM_SINE), _frequency(1000.0), _amplitude(1.0), _offset(0.0), _phase(0.0),
+	_dutyCycle(0.5), _enabled(false), _cycle(0.0), _b0(0.0), _a1(0.0), _a2(0.0), _z1(0.0), _z2(0.0),
+	_triggerLevel(0.0f), _triggerDelay(0), _write(0), _last1(0.0), _last2(0.0), _streaming(false), _streamWrite(0),
+	_time(0.0), _noise(0.0, 1.0)
+{
+	open();
+}
+
+void SimulatedDevice::setModel(const DeviceModel &model) {
+	_model = model;
+	open();
+}
+
+bool SimulatedDevice::open() {
+	reset();
+	_ring1.assign(MAX_BUFFER_SIZE, 0.0);
+	_ring2.assign(MAX_BUFFER_SIZE, 0.0);
+	_write = 0;
+	_last1 = 0.0;
+	_last2 = 0.0;
+	_streaming = false;
+	_z1 = 0.0;
+	_z2 = 0.0;
+	_time = 0.0;
+	_generator.seed(_model.seed);
+	_noise.reset();
+	return true;
+}
+
+void SimulatedDevice::reset() {
+	_waveform = RP_WAVEFORM_SINE;
+	_arbitrary.clear();
+	_frequency = 1000.0;
+	_amplitude = 1.0;
+	_offset = 0.0;
+	_phase = 0.0;
+	_dutyCycle = 0.5;
+	_enabled = false;
+	_cycle = 0.0;
+}
+
+void SimulatedDevice::setWaveform(rp_waveform_t waveform) {
+	if (waveform == RP_WAVEFORM_SWEEP) {
+		std::cerr << "The sweep waveform is not simulated, a sine is generated" << std::endl;
+		waveform = RP_WAVEFORM_SINE;
+	}
+	_waveform = waveform;
+}
+
+void SimulatedDevice::setArbitraryWaveform(const float *data, size_t size) {
+	_arbitrary.assign(data, data + size);
+}
+
+void SimulatedDevice::enable() {
+	// le déclenchement du générateur repart du début de la période
+	_enabled = true;
+	_cycle = 0.0;
+}
+
+void SimulatedDevice::init(float trigger_level, int32_t trigger_delay) {
+	_triggerLevel = trigger_level;
+	_triggerDelay = trigger_delay;
+}
+
+double SimulatedDevice::waveform(double cycle) const {
+	double c = cycle - std::floor(cycle);
+	double value;
+	switch (_waveform) {
+		case RP_WAVEFORM_SQUARE:    value = (c < 0.5) ? 1.0 : -1.0; break;
+		case RP_WAVEFORM_PWM:       value = (c < _dutyCycle) ? 1.0 : -1.0; break;
+		case RP_WAVEFORM_TRIANGLE:  value = (c < 0.5) ? 4.0 * c - 1.0 : 3.0 - 4.0 * c; break;
+		case RP_WAVEFORM_RAMP_UP:   value = 2.0 * c - 1.0; break;
+		case RP_WAVEFORM_RAMP_DOWN: value = 1.0 - 2.0 * c; break;
+		case RP_WAVEFORM_DC:        value = 1.0; break;
+		case RP_WAVEFORM_DC_NEG:    value = -1.0; break;
+		case RP_WAVEFORM_ARBITRARY:
+			value = _arbitrary.empty() ? 0.0 : _arbitrary[std::min(static_cast<size_t>(c * _arbitrary.size()), _arbitrary.size() - 1)];
+			break;
+		default:                    value = std::sin(2.0 * M_PI * c); break;
+	}
+	return _offset + _amplitude * value;
+}
+
+void SimulatedDevice::updateResonance() {
+	if (_model.resonance_frequency <= 0.0) {
+		return;
+	}
+	// passe-bande du second ordre, gain unitaire et phase nulle à la résonance
+	const double w0 = 2.0 * M_PI * getResonanceFrequency() / SAMPLING_FREQUENCY;
+	if (w0 <= 0.0 || w0 >= M_PI) {
+		throw std::invalid_argument("The resonance frequency of the simulated device must be below the Nyquist frequency");
+	}
+	const double alpha = std::sin(w0) / (2.0 * _model.quality_factor);
+	const double a0 = 1.0 + alpha;
+	_b0 = alpha / a0;
+	_a1 = -2.0 * std::cos(w0) / a0;
+	_a2 = (1.0 - alpha) / a0;
+}
+
+double SimulatedDevice::quantize(double value) const {
+	const double full_scale = _model.full_scale;
+	if (_model.adc_bits > 0) {
+		const double lsb = full_scale / static_cast<double>(1 << (_model.adc_bits - 1));
+		value = std::round(value / lsb) * lsb;
+		return std::clamp(value, -full_scale, full_scale - lsb);
+	}
+	return std::clamp(value, -full_scale, full_scale);
+}
+
+void SimulatedDevice::run(size_t count, bool record) {
+	const double step = _frequency / SAMPLING_FREQUENCY;
+	// retard et déphasage du dispositif appliqués comme un décalage de la forme d'onde
+	const double shift = _phase - _frequency * _model.delay + _model.phase / (2.0 * M_PI);
+	const bool resonant = _model.resonance_frequency > 0.0;
+	const size_t ring = _ring1.size();
+
+	for (size_t i = 0; i < count; i++) {
+		double output = _enabled ? waveform(_cycle + _phase) : 0.0;
+		double input = _enabled ? waveform(_cycle + shift) : 0.0;
+		double response = input;
+		if (resonant) {
+			response = _b0 * input + _z1;
+			_z1 = -_a1 * response + _z2;
+			_z2 = -_b0 * input - _a2 * response;
+		}
+		response *= _model.gain;
+
+		_cycle += step;
+		if (_cycle >= 1.0) {
+			_cycle -= std::floor(_cycle);
+		}
+
+		if (record || _streaming) {
+			if (_model.noise > 0.0) {
+				output += _model.noise * _noise(_generator);
+				response += _model.noise * _noise(_generator);
+			}
+			_last1 = quantize(output);
+			_last2 = quantize(response);
+		}
+		if (record) {
+			_ring1[_write] = _last1;
+			_ring2[_write] = _last2;
+			_write = (_write + 1 == ring) ? 0 : _write + 1;
+		}
+		if (_streaming) {
+			_stream1[_streamWrite] = _last1;
+			_stream2[_streamWrite] = _last2;
+			_streamWrite = (_streamWrite + 1 == _stream1.size()) ? 0 : _streamWrite + 1;
+		}
+	}
+	_time += static_cast<double>(count) / SAMPLING_FREQUENCY;
+}
+
+void SimulatedDevice::advance(double duration) {
+	const size_t count = static_cast<size_t>(std::llround(duration * SAMPLING_FREQUENCY));
+	if (_streaming) {
+		// l'anneau DMA reçoit tous les échantillons
+		updateResonance();
+		run(count, false);
+		return;
+	}
+	// seuls les derniers échantillons comptent pour l'état de la résonance (20 constantes de temps)
+	size_t simulated = 0;
+	if (_model.resonance_frequency > 0.0) {
+		const double tau = _model.quality_factor / (M_PI * getResonanceFrequency());
+		simulated = std::min(count, static_cast<size_t>(std::ceil(20.0 * tau * SAMPLING_FREQUENCY)));
+	}
+	const size_t skipped = count - simulated;
+	_cycle += static_cast<double>(skipped) * _frequency / SAMPLING_FREQUENCY;
+	_cycle -= std::floor(_cycle);
+	_time += static_cast<double>(skipped) / SAMPLING_FREQUENCY;
+
+	updateResonance();
+	run(simulated, false);
+}
+
+void SimulatedDevice::waitUntil(double time) {
+	if (time <= _time) {
+		return;
+	}
+	double duration = time - _time;
+	advance(duration);
+	if (_model.realtime) {
+		std::this_thread::sleep_for(std::chrono::duration<double>(duration));
+	}
+}
+
+void SimulatedDevice::acquire(Signal *channel1, Signal *channel2, rp_acq_trig_src_t trigger) {
+	const size_t ring = _ring1.size();
+	const double start = _time;
+	updateResonance();
+
+	// échantillons écrits après le déclenchement (ADC_BUFFER_SIZE/2 pour un retard nul)
+	const int64_t delay = static_cast<int64_t>(_triggerDelay) + static_cast<int64_t>(ring / 2);
+	const size_t post = static_cast<size_t>(std::clamp<int64_t>(delay, 1, static_cast<int64_t>(ring)));
+
+	// armement : l'anneau se remplit au moins jusqu'aux échantillons précédant le déclenchement
+	const size_t arm = static_cast<size_t>(std::llround(getTimeDelay(DECIMATION) * 1e-6 * SAMPLING_FREQUENCY));
+	run(std::max(arm, ring - post), true);
+
+	if (trigger == RP_TRIG_SRC_NOW) {
+		run(1, true);
+	} else {
+		const bool first = (trigger == RP_TRIG_SRC_CHA_PE || trigger == RP_TRIG_SRC_CHA_NE);
+		const bool rising = (trigger == RP_TRIG_SRC_CHA_PE || trigger == RP_TRIG_SRC_CHB_PE);
+		if (!first && trigger != RP_TRIG_SRC_CHB_PE && trigger != RP_TRIG_SRC_CHB_NE) {
+			throw std::invalid_argument("Trigger source not simulated");
+		}
+		// recherche du front sur l'entrée choisie, pendant au plus une seconde
+		const size_t timeout = static_cast<size_t>(SAMPLING_FREQUENCY);
+		size_t n = 0;
+		for (; n < timeout; n++) {
+			double previous = first ? _last1 : _last2;
+			run(1, true);
+			double current = first ? _last1 : _last2;
+			if (rising ? (previous < _triggerLevel && current >= _triggerLevel) : (previous > _triggerLevel && current <= _triggerLevel)) {
+				break;
+			}
+		}
+		if (n == timeout) {
+			throw std::runtime_error("No trigger on the simulated device");
+		}
+	}
+	const size_t position = (_write + ring - 1) % ring;
+	run(post - 1, true);
+
+	/* Lecture de BUFFER_SIZE échantillons depuis le déclenchement */
+	if (channel1 != nullptr) channel1->resize(BUFFER_SIZE);
+	if (channel2 != nullptr) channel2->resize(BUFFER_SIZE);
+	for (size_t i = 0; i < BUFFER_SIZE; i++) {
+		size_t k = (position + i) % ring;
+		if (channel1 != nullptr) (*channel1)[i] = _ring1[k];
+		if (channel2 != nullptr) (*channel2)[i] = _ring2[k];
+	}
+
+	if (_model.realtime) {
+		std::this_thread::sleep_for(std::chrono::duration<double>(_time - start));
+	}
+}
+
+size_t SimulatedDevice::start(size_t samples) {
+	if (samples == 0) {
+		throw std::invalid_argument("The DMA ring must not be empty");
+	}
+	updateResonance();
+	_stream1.assign(samples, 0.0);
+	_stream2.assign(samples, 0.0);
+	_streamWrite = 0;
+	_streaming = true;
+	return samples;
+}
+
+void SimulatedDevice::read(size_t position, size_t count, double *channel1, double *channel2) {
+	const size_t ring = _stream1.size();
+	for (size_t i = 0; i < count; i++) {
+		size_t k = (position + i) % ring;
+		if (channel1 != nullptr) channel1[i] = _stream1[k];
+		if (channel2 != nullptr) channel2[i] = _stream2[k];
+	}
+}
@@ -0,0 +1,131 @@
+#ifndef __SIMULATEDDEVICE_HPP
+#define __SIMULATEDDEVICE_HPP
+
+#include <vector>
+#include <random>
+#include "Device.hpp"
+#include "globals.hpp"
+
+/**
+ * @brief Device under test and analog front end of the simulated card
+ */
+struct DeviceModel {
+	double gain = 1.0;                 // gain of the device under test
+	double phase = 0.0;                // phase shift of the device under test, in radians
+	double delay = 0.0;                // delay of the device under test, in seconds
+	double resonance_frequency = 0.0;  // resonance of the device under test (0 : flat response)
+	double quality_factor = 10.0;      // quality factor of the resonance
+	double drift = 0.0;                // drift of the resonance frequency, in Hz/s
+	double noise = 0.0;                // RMS white noise on both inputs, in volts
+	int adc_bits = BITS_PER_SAMPLE;    // resolution of the ADC (0 : no quantization)
+	double full_scale = 1.0;           // range of the inputs, +-full_scale volts
+	unsigned int seed = 1;             // seed of the noise
+	bool realtime = false;             // wait for the simulated durations
+};
+
+/**
+ * @brief Card simulated on the host, deterministic for a given seed
+ * @details Input 1 is looped back on output 1 and input 2 receives the output of the
+ *          device under test: the waveform delayed and phase shifted (as a time shift of
+ *          the waveform, exact for a sine), filtered by a second order band pass at the
+ *          resonance (gain at the resonance, phase 0 at the resonance) and amplified.
+ *          Both inputs get white noise, then are clipped and quantized by the ADC. The
+ *          generator keeps its phase when its frequency changes.
+ *
+ *          An acquisition follows the driver: the ADC ring of ADC_BUFFER_SIZE samples is
+ *          filled during the arming delay (getTimeDelay()), the trigger is searched on
+ *          the samples of the chosen input, ADC_BUFFER_SIZE/2 + trigger delay samples are
+ *          written after the trigger, and BUFFER_SIZE samples are read from the trigger.
+ *          The clock of the device advances by the simulated samples and by wait().
+ *
+ *          While streaming, every sample of the inputs is written into the DMA ring,
+ *          waits included, so a reader slower than the inputs meets real overruns.
+ */
+class SimulatedDevice : public Device, public GeneratorBackend, public AcquisitionBackend, public StreamBackend {
+public:
+	SimulatedDevice();
+	explicit SimulatedDevice(const DeviceModel &model);
+
+	void setModel(const DeviceModel &model);
+	const DeviceModel &getModel() const { return _model; }
+
+	/**
+	 * @brief Resonance frequency at the current time
+	 */
+	double getResonanceFrequency() const { return _model.resonance_frequency + _model.drift * _time; }
+
+	bool open() override;
+	void close() override {}
+	GeneratorBackend &generator() override { return *this; }
+	AcquisitionBackend &acquisition() override { return *this; }
+	StreamBackend &stream() override { return *this; }
+	double now() override { return _time; }
+	void waitUntil(double time) override;
+	bool isSimulated() const override { return true; }
+
+	void reset() override;
+	void setWaveform(rp_waveform_t waveform) override;
+	void setArbitraryWaveform(const float *data, size_t size) override;
+	void setFrequency(double frequency) override { _frequency = frequency; }
+	void setAmplitude(double amplitude) override { _amplitude = amplitude; }
+	void setOffset(double offset) override { _offset = offset; }
+	void setPhase(double phase) override { _phase = phase / 360.0; }
+	void setDutyCycle(double duty_cycle) override { _dutyCycle = duty_cycle; }
+	void enable() override;
+	void disable() override { _enabled = false; }
+
+	void init(float trigger_level, int32_t trigger_delay) override;
+	void release() override {}
+	void acquire(Signal *channel1, Signal *channel2, rp_acq_trig_src_t trigger = RP_TRIG_SRC_CHA_PE) override;
+
+	size_t start(size_t samples) override;
+	void stop() override { _streaming = false; }
+	size_t getWritePointer() override { return _streamWrite; }
+	void read(size_t position, size_t count, double *channel1, double *channel2) override;
+
+private:
+	// sortie du générateur à une position dans la période (en tours)
+	double waveform(double cycle) const;
+
+	// coefficients de la résonance à l'instant courant
+	void updateResonance();
+
+	// échantillons suivants des entrées, écrits dans l'anneau de l'ADC si record (et dans l'anneau DMA pendant le streaming)
+	void run(size_t count, bool record);
+
+	// avance de l'horloge sans acquisition
+	void advance(double duration);
+
+	double quantize(double value) const;
+
+	DeviceModel _model;
+
+	// générateur
+	rp_waveform_t _waveform;
+	std::vector<float> _arbitrary;
+	double _frequency, _amplitude, _offset, _phase, _dutyCycle;
+	bool _enabled;
+	double _cycle; // position dans la période, en tours
+
+	// résonance (biquad passe-bande, forme directe II transposée)
+	double _b0, _a1, _a2;
+	double _z1, _z2;
+
+	// acquisition
+	float _triggerLevel;
+	int32_t _triggerDelay;
+	std::vector<double> _ring1, _ring2; // ADC ring of each input
+	size_t _write;                      // next position written in the rings
+	double _last1, _last2;              // last samples, for the edge detection
+
+	// streaming
+	bool _streaming;
+	std::vector<double> _stream1, _stream2; // DMA ring of each input
+	size_t _streamWrite;                    // next position written in the DMA rings
+
+	double _time;
+	std::default_random_engine _generator;
+	std::normal_distribution<double> _noise;
+};
+
+#endif // __SIMULATEDDEVICE_HPP
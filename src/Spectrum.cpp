@@ -2,6 +2,7 @@
 #include <cmath>
 #include "Spectrum.hpp"
 #include "Signal.hpp"
+#include "Polar.hpp"
 
 Spectrum::Spectrum(const std::string &name) : std::vector<complexd>(BUFFER_SIZE, 0.0), mName(name) {}
 
@@ -468,6 +469,16 @@ Signal Spectrum::calculatePhase() const {
 	return output;
 }
 
+Signal Spectrum::calculatePhase(PolarPrecision precision, bool unwrap) const {
+	const size_t N = this->size();
+	Signal output(N);
+	// les complexes sont stockés (réel, imaginaire) : conversion entrelacée de pas 2
+	PolarConverter converter;
+	converter.set(precision, unwrap);
+	converter.process(reinterpret_cast<const double *>(this->data()), 2, nullptr, output.data(), N);
+	return output;
+}
+
 /* ------------------------------- */
 
 unsigned int reverseBits(unsigned int n, unsigned int bits) {
@@ -7,6 +7,7 @@
 #include "globals.hpp"
 
 class Signal;
+enum class PolarPrecision;
 
 class Spectrum : public std::vector<complexd> {
 private:
@@ -233,6 +234,14 @@ public:
 
 	Signal calculatePhase() const;
 
+	/**
+	 * Fonction pour calculer la phase de chaque raie avec le convertisseur polaire
+	 * @param[in] precision Précision de l'arc tangente (EXACT : std::arg)
+	 * @param[in] unwrap Vrai pour supprimer les sauts de 2.pi d'une raie à la suivante
+	 * @return Phase de chaque raie
+	 */
+	Signal calculatePhase(PolarPrecision precision, bool unwrap = false) const;
+
 	/**
 	 * Fonction pour effectuer la transformée de Fourier inverse rapide (IFFT) et reconstruire le signal
 	 * @param[out] output_signal : Signal à reconstruire
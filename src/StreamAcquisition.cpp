@@ -0,0 +1,152 @@
+#include "StreamAcquisition.hpp"
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include <iostream>
+#include "globals.hpp"
+
+StreamAcquisition::StreamAcquisition() :
+	_frameSize(0), _requestedSize(0), _ringSize(0), _timeout(1.0), _samplingFrequency(0.0), _running(false),
+	_device(nullptr), _backend(nullptr), _startWrite(0), _lastWrite(0), _lastTime(0.0), _written(0), _read(0),
+	_frames(0), _overruns(0), _dropped(0), _pendingDropped(0)
+{}
+
+StreamAcquisition::~StreamAcquisition() {
+	stop();
+}
+
+bool StreamAcquisition::set(size_t frame_size, size_t ring_size, double timeout) {
+	if (frame_size == 0) {
+		std::cerr << "The frame size must be greater than zero" << std::endl;
+		return false;
+	}
+	if (ring_size < 2 * frame_size) {
+		std::cerr << "The ring must hold at least two frames" << std::endl;
+		return false;
+	}
+	if (timeout <= 0.0) {
+		std::cerr << "The timeout must be greater than zero" << std::endl;
+		return false;
+	}
+	stop();
+	_frameSize = frame_size;
+	_requestedSize = ring_size;
+	_timeout = timeout;
+	_channel1.assign(frame_size, 0.0);
+	_channel2.assign(frame_size, 0.0);
+	return true;
+}
+
+void StreamAcquisition::start() {
+	if (_frameSize == 0) {
+		throw std::runtime_error("The stream acquisition is not set");
+	}
+	stop();
+
+	_device = &getDevice();
+	_backend = &_device->stream();
+	_samplingFrequency = SAMPLING_FREQUENCY;
+	_ringSize = _backend->start(_requestedSize);
+	if (_ringSize < 2 * _frameSize) {
+		_backend->stop();
+		throw std::runtime_error("The DMA ring of the device is smaller than two frames");
+	}
+
+	_startWrite = _backend->getWritePointer();
+	_lastWrite = _startWrite;
+	_lastTime = _device->now();
+	_written = 0;
+	_read = 0;
+	_frames = 0;
+	_overruns = 0;
+	_dropped = 0;
+	_pendingDropped = 0;
+	_running = true;
+}
+
+void StreamAcquisition::stop() {
+	if (!_running) return;
+	_backend->stop();
+	_running = false;
+}
+
+void StreamAcquisition::update() {
+	const size_t write = _backend->getWritePointer();
+	const double time = _device->now();
+	uint64_t delta = (write + _ringSize - _lastWrite) % _ringSize;
+
+	// tours complets de l'anneau, invisibles sur le pointeur : déduits de l'horloge
+	const double expected = (time - _lastTime) * _samplingFrequency;
+	const double turns = std::floor((expected - static_cast<double>(delta)) / static_cast<double>(_ringSize) + 0.5);
+	if (turns > 0.0) {
+		delta += static_cast<uint64_t>(turns) * _ringSize;
+	}
+
+	_written += delta;
+	_lastWrite = write;
+	_lastTime = time;
+}
+
+bool StreamAcquisition::checkOverrun() {
+	if (_written - _read <= _ringSize) {
+		return false;
+	}
+	// reprise à une demi-longueur d'anneau derrière l'écriture
+	const uint64_t resume = _written - _ringSize / 2;
+	const uint64_t lost = resume - _read;
+	_dropped += lost;
+	_pendingDropped += lost;
+	_overruns++;
+	_read = resume;
+	return true;
+}
+
+uint64_t StreamAcquisition::getAvailable() {
+	if (!_running) return 0;
+	update();
+	return _written - _read;
+}
+
+bool StreamAcquisition::next(StreamFrame &frame) {
+	if (!_running) {
+		throw std::runtime_error("The stream acquisition is not started");
+	}
+	const double deadline = _device->now() + _timeout;
+
+	for (;;) {
+		update();
+		checkOverrun();
+
+		const uint64_t available = _written - _read;
+		if (available >= _frameSize) {
+			const size_t position = static_cast<size_t>((_startWrite + _read) % _ringSize);
+			_backend->read(position, _frameSize, _channel1.data(), _channel2.data());
+
+			// la trame doit être intacte à la fin de la copie
+			update();
+			if (checkOverrun()) {
+				continue;
+			}
+
+			frame.channel1 = _channel1.data();
+			frame.channel2 = _channel2.data();
+			frame.size = _frameSize;
+			frame.index = _read;
+			frame.time = static_cast<double>(_read) / _samplingFrequency;
+			frame.dropped = _pendingDropped;
+
+			_pendingDropped = 0;
+			_read += _frameSize;
+			_frames++;
+			return true;
+		}
+
+		const double now = _device->now();
+		if (now >= deadline) {
+			return false;
+		}
+		// attente des échantillons manquants de la trame
+		const double missing = static_cast<double>(_frameSize - available) / _samplingFrequency;
+		_device->waitUntil(std::min(deadline, now + missing));
+	}
+}
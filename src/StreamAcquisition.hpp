@@ -0,0 +1,114 @@
+#ifndef __STREAMACQUISITION_HPP
+#define __STREAMACQUISITION_HPP
+
+#include <vector>
+#include <cstdint>
+#include "Device.hpp"
+
+/**
+ * @brief Frame of consecutive samples of both inputs, read from the stream
+ * @note The samples belong to the StreamAcquisition and stay valid until the next frame
+ */
+struct StreamFrame {
+	const double *channel1; // samples of input 1
+	const double *channel2; // samples of input 2
+	size_t size;            // number of samples of each input
+	uint64_t index;         // index of the first sample, from the start of the stream
+	double time;            // time of the first sample in seconds, from the start of the stream
+	uint64_t dropped;       // samples lost by overruns just before this frame (0 : follows the previous frame)
+};
+
+/**
+ * @brief Gap-free acquisition of inputs 1 and 2, read frame by frame from the DMA ring
+ * @details The card writes both inputs continuously into the ring of the StreamBackend.
+ *          The read pointer follows the write pointer: the number of samples written is
+ *          the progress of the write pointer, plus the complete turns of the ring given
+ *          by the clock of the device, so a late reader still sees how far behind it is.
+ *          When samples are overwritten before being read (overrun), the reader jumps
+ *          to half a ring behind the write pointer and counts the dropped samples. A
+ *          frame overwritten while it was copied is dropped as well.
+ * @note The clock only resolves the turns if the write pointer is read at least every
+ *       half ring.
+ */
+class StreamAcquisition {
+public:
+	StreamAcquisition();
+	~StreamAcquisition();
+
+	/**
+	 * @brief Set the stream
+	 * @param[in] frame_size Number of samples of each frame
+	 * @param[in] ring_size Requested size of the DMA ring (at least 2 frames)
+	 * @param[in] timeout Maximum wait for a frame, in seconds
+	 * @return true if the parameters are valid, false otherwise
+	 */
+	bool set(size_t frame_size, size_t ring_size, double timeout = 1.0);
+
+	/**
+	 * @brief Start the stream on the current device, at the current DECIMATION
+	 */
+	void start();
+
+	/**
+	 * @brief Stop the stream
+	 */
+	void stop();
+
+	bool isRunning() const { return _running; }
+
+	/**
+	 * @brief Wait for the next frame and read it
+	 * @param[out] frame Next frame
+	 * @return false if no frame arrived before the timeout
+	 */
+	bool next(StreamFrame &frame);
+
+	/**
+	 * @brief Number of samples written and not read yet
+	 */
+	uint64_t getAvailable();
+
+	size_t getFrameSize() const { return _frameSize; }
+
+	/**
+	 * @brief Size of the DMA ring, known after start()
+	 */
+	size_t getRingSize() const { return _ringSize; }
+
+	/**
+	 * @brief Sampling frequency of the stream, known after start()
+	 */
+	double getSamplingFrequency() const { return _samplingFrequency; }
+
+	uint64_t getFrames() const { return _frames; }
+	uint64_t getOverruns() const { return _overruns; }
+	uint64_t getDroppedSamples() const { return _dropped; }
+
+private:
+	// avance du pointeur d'écriture depuis la dernière lecture
+	void update();
+
+	// saut du pointeur de lecture si des échantillons non lus ont été écrasés
+	bool checkOverrun();
+
+	size_t _frameSize, _requestedSize, _ringSize;
+	double _timeout;
+	double _samplingFrequency;
+	bool _running;
+
+	Device *_device;
+	StreamBackend *_backend;
+
+	size_t _startWrite;  // write pointer at the start, position of sample 0
+	size_t _lastWrite;   // write pointer at the last update
+	double _lastTime;    // time of the last update
+	uint64_t _written;   // samples written since the start
+	uint64_t _read;      // samples read or dropped since the start
+
+	uint64_t _frames, _overruns, _dropped;
+	uint64_t _pendingDropped; // dropped since the last frame
+
+	std::vector<double> _channel1, _channel2;
+};
+
+#endif // __STREAMACQUISITION_HPP
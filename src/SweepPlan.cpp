@@ -0,0 +1,184 @@
+#include "SweepPlan.hpp"
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <iostream>
+#include "globals.hpp"
+#include "utils.hpp"
+
+static const char SWEEP_PLAN_MAGIC[8] = {'S', 'W', 'P', 'L', 'A', 'N', '0', '3'};
+
+template <typename T>
+static void writeValue(std::ofstream &file, const T &value) {
+	file.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+static bool readValue(std::ifstream &file, T &value) {
+	file.read(reinterpret_cast<char *>(&value), sizeof(T));
+	return static_cast<bool>(file);
+}
+
+SweepPlan::SweepPlan() : _isSetup(false), _filterFreq(0.0), _pointsPerPeriod(1), _decimation(0), _bufferSize(0), _filterOrder(4), _zeroPhase(false) {}
+
+bool SweepPlan::set(const Signal &frequencies, double filter_freq, int points_per_period, int decimation, size_t buffer_size, int filter_order, bool zero_phase) {
+	if (frequencies.empty()) {
+		std::cerr << "The sweep needs at least one frequency" << std::endl;
+		return false;
+	}
+	if (filter_freq <= 0.0 || points_per_period < 1 || decimation < 0 || buffer_size < 1 || filter_order < 1) {
+		std::cerr << "Invalid parameters for the sweep plan" << std::endl;
+		return false;
+	}
+
+	_frequencies.assign(frequencies.begin(), frequencies.end());
+	_filterFreq = filter_freq;
+	_pointsPerPeriod = points_per_period;
+	_decimation = decimation;
+	_bufferSize = buffer_size;
+	_filterOrder = filter_order;
+	_zeroPhase = zero_phase;
+	_isSetup = false;
+	return true;
+}
+
+void SweepPlan::setup() {
+	if (_isSetup) {
+		return;
+	}
+
+	// temps de montée du filtre de démodulation à 3 tau
+	double rising_time = 3.0 / _filterFreq;
+
+	_steps.clear();
+	_steps.reserve(_frequencies.size());
+	for (double f : _frequencies) {
+		SweepStep step{f, 0, 0.0, 0, {}, Signal(_bufferSize), Signal(_bufferSize)};
+
+		step.decimation = (_decimation > 0) ? _decimation : calculateDecimation(f, _pointsPerPeriod);
+		step.samplingFrequency = static_cast<double>(MAX_SAMPLING_FREQUENCY) / step.decimation;
+
+		step.sections = _cache.get(_filterOrder, _filterFreq, 0.0, step.samplingFrequency, FilterGabarit::LOW_PASS, AnalogFilter::BUTTERWORTH);
+
+		if (_zeroPhase) {
+			// transitoire mesuré sur le filtre aller-retour, plus court qu'à 3 tau
+			IIRFilter filter;
+			filter.setup(step.sections);
+			step.indexRisingTime = filter.transientLength(_bufferSize, 1e-3, true);
+		} else {
+			step.indexRisingTime = static_cast<size_t>(std::floor(rising_time * step.samplingFrequency));
+		}
+		if (step.indexRisingTime >= _bufferSize) {
+			throw std::runtime_error("The rising time is too long.");
+		}
+
+		// mêmes références que Signal::generateWaveform
+		double sample_period = 1.0 / step.samplingFrequency;
+		for (size_t i = 0; i < _bufferSize; i++) {
+			double t = i * sample_period;
+			step.sinus[i]   = std::sin(2 * M_PI * f * t);
+			step.cosinus[i] = std::sin(2 * M_PI * f * t + M_PI/2.0);
+		}
+
+		_steps.push_back(std::move(step));
+	}
+
+	_isSetup = true;
+}
+
+bool SweepPlan::save(const std::string &filename) const {
+	if (!_isSetup) {
+		throw std::invalid_argument("Sweep plan is not set up");
+	}
+
+	std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+	if (!file) {
+		std::cerr << "Unable to write the sweep plan " << filename << std::endl;
+		return false;
+	}
+
+	file.write(SWEEP_PLAN_MAGIC, sizeof(SWEEP_PLAN_MAGIC));
+	writeValue(file, static_cast<int32_t>(MAX_SAMPLING_FREQUENCY));
+	writeValue(file, _filterFreq);
+	writeValue(file, static_cast<int32_t>(_pointsPerPeriod));
+	writeValue(file, static_cast<int32_t>(_decimation));
+	writeValue(file, static_cast<uint64_t>(_bufferSize));
+	writeValue(file, static_cast<int32_t>(_filterOrder));
+	writeValue(file, static_cast<uint8_t>(_zeroPhase));
+	writeValue(file, static_cast<uint64_t>(_frequencies.size()));
+	file.write(reinterpret_cast<const char *>(_frequencies.data()), _frequencies.size() * sizeof(double));
+
+	for (const SweepStep &step : _steps) {
+		writeValue(file, static_cast<int32_t>(step.decimation));
+		writeValue(file, step.samplingFrequency);
+		writeValue(file, static_cast<uint64_t>(step.indexRisingTime));
+		writeValue(file, static_cast<uint64_t>(step.sections.size()));
+		file.write(reinterpret_cast<const char *>(step.sections.data()), step.sections.size() * sizeof(Biquad));
+		file.write(reinterpret_cast<const char *>(step.sinus.data()), _bufferSize * sizeof(double));
+		file.write(reinterpret_cast<const char *>(step.cosinus.data()), _bufferSize * sizeof(double));
+	}
+
+	return static_cast<bool>(file);
+}
+
+bool SweepPlan::load(const std::string &filename) {
+	std::ifstream file(filename, std::ios::binary);
+	if (!file) {
+		return false;
+	}
+
+	// l'en-tête doit correspondre aux paramètres du balayage
+	char magic[sizeof(SWEEP_PLAN_MAGIC)];
+	int32_t maxFrequency, pointsPerPeriod, decimation, filterOrder;
+	uint64_t bufferSize, count;
+	uint8_t zeroPhase;
+	double filterFreq;
+	file.read(magic, sizeof(magic));
+	if (!file || std::memcmp(magic, SWEEP_PLAN_MAGIC, sizeof(magic)) != 0) {
+		std::cerr << "Invalid sweep plan file " << filename << std::endl;
+		return false;
+	}
+	if (!readValue(file, maxFrequency) || !readValue(file, filterFreq) || !readValue(file, pointsPerPeriod)
+	 || !readValue(file, decimation) || !readValue(file, bufferSize)
+	 || !readValue(file, filterOrder) || !readValue(file, zeroPhase) || !readValue(file, count)) {
+		return false;
+	}
+	if (maxFrequency != MAX_SAMPLING_FREQUENCY || filterFreq != _filterFreq || pointsPerPeriod != _pointsPerPeriod
+	 || decimation != _decimation || bufferSize != _bufferSize
+	 || filterOrder != _filterOrder || (zeroPhase != 0) != _zeroPhase || count != _frequencies.size()) {
+		return false;
+	}
+	std::vector<double> frequencies(count);
+	file.read(reinterpret_cast<char *>(frequencies.data()), count * sizeof(double));
+	if (!file || frequencies != _frequencies) {
+		return false;
+	}
+
+	std::vector<SweepStep> steps;
+	steps.reserve(count);
+	for (size_t j = 0; j < count; j++) {
+		SweepStep step{_frequencies[j], 0, 0.0, 0, {}, Signal(_bufferSize), Signal(_bufferSize)};
+		int32_t stepDecimation;
+		uint64_t indexRisingTime, numSections;
+		if (!readValue(file, stepDecimation) || !readValue(file, step.samplingFrequency)
+		 || !readValue(file, indexRisingTime) || !readValue(file, numSections) || numSections > 64) {
+			return false;
+		}
+		step.decimation = stepDecimation;
+		step.indexRisingTime = indexRisingTime;
+		step.sections.resize(numSections);
+		file.read(reinterpret_cast<char *>(step.sections.data()), numSections * sizeof(Biquad));
+		file.read(reinterpret_cast<char *>(step.sinus.data()), _bufferSize * sizeof(double));
+		file.read(reinterpret_cast<char *>(step.cosinus.data()), _bufferSize * sizeof(double));
+		if (!file) {
+			std::cerr << "Truncated sweep plan file " << filename << std::endl;
+			return false;
+		}
+		steps.push_back(std::move(step));
+	}
+
+	_steps = std::move(steps);
+	_isSetup = true;
+	return true;
+}
@@ -0,0 +1,103 @@
+#ifndef __SWEEPPLAN_HPP
+#define __SWEEPPLAN_HPP
+
+#include <vector>
+#include <string>
+#include "Signal.hpp"
+#include "Filter.hpp"
+
+/**
+ * @brief Everything needed to measure one frequency of a sweep
+ */
+struct SweepStep {
+	double frequency;          // Frequency generated and demodulated
+	int decimation;            // Decimation of the acquisition
+	double samplingFrequency;  // Sampling frequency of the acquisition
+	size_t indexRisingTime;    // First sample after the transient of the demodulation filter
+	std::vector<Biquad> sections; // Low pass filter of the demodulation
+	Signal sinus;              // Reference tables of the demodulation
+	Signal cosinus;
+};
+
+/**
+ * @brief Precomputed plan of a frequency sweep
+ * @details The decimation, the demodulation filter, the reference tables and the
+ *          end of the transient are computed once for every frequency before the
+ *          sweep, so that the loop only runs the measurements. Filter designs are
+ *          shared between frequencies with the same sampling frequency.
+ *          The plan can be saved to a binary file, and loaded back as long as
+ *          the parameters of the sweep did not change.
+ */
+class SweepPlan {
+public:
+	SweepPlan();
+
+	/**
+	 * @brief Set the parameters of the sweep
+	 * @param[in] frequencies Frequencies of the sweep
+	 * @param[in] filter_freq Cutoff frequency of the demodulation filter
+	 * @param[in] points_per_period Number of points per period used to choose the decimation
+	 * @param[in] decimation Fixed decimation, or 0 to choose it for every frequency
+	 * @param[in] buffer_size Size of the acquisitions
+	 * @param[in] filter_order Order of the demodulation filter
+	 * @param[in] zero_phase True if the demodulation filter is applied forward and backward
+	 * @return true if the parameters are valid, false otherwise
+	 */
+	bool set(const Signal &frequencies, double filter_freq, int points_per_period, int decimation, size_t buffer_size, int filter_order = 4, bool zero_phase = false);
+
+	/**
+	 * @brief Compute the steps of the sweep
+	 */
+	void setup();
+
+	/**
+	 * @brief Check if the plan is setup
+	 */
+	bool isSetup() const { return _isSetup; }
+
+	/**
+	 * @brief Number of frequencies of the sweep
+	 */
+	size_t size() const { return _steps.size(); }
+
+	/**
+	 * @brief Get a step of the sweep
+	 * @param[in] index Index of the frequency
+	 */
+	const SweepStep &operator[](size_t index) const { return _steps.at(index); }
+
+	/**
+	 * @brief Number of distinct filters designed for the sweep
+	 */
+	size_t getNumberOfDesigns() const { return _cache.size(); }
+
+	/**
+	 * @brief Save the plan to a binary file
+	 * @param[in] filename Path of the file
+	 * @return true if the file has been written
+	 */
+	bool save(const std::string &filename) const;
+
+	/**
+	 * @brief Load a plan saved with save()
+	 * @param[in] filename Path of the file
+	 * @return true if the file exists and was computed with the parameters given to set()
+	 */
+	bool load(const std::string &filename);
+
+private:
+	bool _isSetup;
+
+	std::vector<double> _frequencies;
+	double _filterFreq;
+	int _pointsPerPeriod;
+	int _decimation;
+	size_t _bufferSize;
+	int _filterOrder;
+	bool _zeroPhase;
+
+	std::vector<SweepStep> _steps;
+	FilterDesignCache _cache;
+};
+
+#endif // __SWEEPPLAN_HPP
@@ -5,7 +5,7 @@
 
 class Timer {
 public:
-	Timer() : _start(std::chrono::high_resolution_clock::now()), _end(std::chrono::high_resolution_clock::now()), _duration(0), _min_duration(0), _max_duration(0) {}
+	Timer() : _start(std::chrono::high_resolution_clock::now()), _end(std::chrono::high_resolution_clock::now()), _duration(0), _min_duration(0), _max_duration(0), _total_duration(0) {}
 
     void start() {
         _start = std::chrono::high_resolution_clock::now();
@@ -20,6 +20,7 @@ public:
         if (_duration > _max_duration) {
             _max_duration = _duration;
         }
+        _total_duration += _duration;
     }
 
     double getDuration() const {
@@ -34,12 +35,17 @@ public:
         return _max_duration;
     }
 
+    double getTotalDuration() const {
+        return _total_duration;
+    }
+
 private:
     std::chrono::time_point<std::chrono::high_resolution_clock> _start;
     std::chrono::time_point<std::chrono::high_resolution_clock> _end;
     double _duration;
     double _min_duration;
     double _max_duration;
+    double _total_duration;
 };
 
 #endif // TIMER_HPP
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "Window.hpp"
 #include <string>
+#include <complex>
 
 
 
@@ -46,76 +47,18 @@ void Window::setup() {
 		return;
 	}
 
-	_window.resize(_size);
-	if (_sample_offset) {
-		for (size_t i = 0; i < _sample_offset; ++i) {
-			_window[i] = 0.0;
-			_window[_size - 1 - i] = 0.0;
-		}
-	}
-	for (size_t i = _sample_offset; i < _size-_sample_offset; ++i) {
-		switch (_type) {
-			case WindowType::Rectangular:
-				_window[i] = 1.0;
-				break;
-			case WindowType::Triangular:
-				_window[i] = 1.0 - std::abs((i - (_size - 1) / 2.0) / (_size / 2.0));
-				break;
-			case WindowType::Parzen:
-				_window[i] = 1.0 - std::abs((i - (_size - 1) / 2.0) / (_size / 2.0));
-				break;
-			case WindowType::Welch:
-				_window[i] = 1.0 - std::pow((i - (_size - 1) / 2.0) / (_size / 2.0), 2);
-				break;
-			case WindowType::Sine:
-				_window[i] = std::sin(M_PI * i / (_size - 1));
-				break;
-			case WindowType::Hann:
-				_window[i] = 0.5 * (1 - std::cos(2 * M_PI * i / (_size - 1)));
-				break;
-			case WindowType::Hamming:
-				_window[i] = 0.54 - 0.46 * std::cos(2 * M_PI * i / (_size - 1));
-				break;
-			case WindowType::Blackman:
-				_window[i] = 0.42 - 0.5 * std::cos(2 * M_PI * i / (_size - 1)) + 0.08 * std::cos(4 * M_PI * i / (_size - 1));
-				break;
-			case WindowType::Nuttall:
-				_window[i] = 0.355768 - 0.487396 * std::cos(2 * M_PI * i / (_size - 1)) + 0.144232 * std::cos(4 * M_PI * i / (_size - 1)) - 0.012604 * std::cos(6 * M_PI * i / (_size - 1));
-				break;
-			case WindowType::BlackmanNuttall:
-				_window[i] = 0.3635819 - 0.4891775 * std::cos(2 * M_PI * i / (_size - 1)) + 0.1365995 * std::cos(4 * M_PI * i / (_size - 1)) - 0.0106411 * std::cos(6 * M_PI * i / (_size - 1));
-				break;
-			case WindowType::BlackmanHarris:
-				_window[i] = 0.35875 - 0.48829 * std::cos(2 * M_PI * i / (_size - 1)) + 0.14128 * std::cos(4 * M_PI * i / (_size - 1)) - 0.01168 * std::cos(6 * M_PI * i / (_size - 1));
-				break;
-			case WindowType::Tukey: {
-					if (i < _alpha * (_size - 1) / 2) {
-						_window[i] = 0.5 * (1 + cos(M_PI * (2.0 * i / (_alpha * (_size - 1)) - 1)));
-					} else if (i <= (_size - 1) * (1 - _alpha / 2)) {
-						_window[i] = 1.0;
-					} else {
-						_window[i] = 0.5 * (1 + cos(M_PI * (2.0 * i / (_alpha * (_size - 1)) - 2.0 / _alpha + 1)));
-					}
-				}
-				break;
-			case WindowType::PlanckTaper: {
-					double t = 2.0 * i / (_size - 1);
-					if (t <= _alpha) {
-						_window[i] = 1.0 / (exp(_alpha / t - _alpha / (2 - t)) + 1);
-					} else if (t >= 2 - _alpha) {
-						_window[i] = 1.0 / (exp(_alpha / (2 - t) - _alpha / t) + 1);
-					} else {
-						_window[i] = 1.0;
-					}
-				}
-				break;
-			default:
-				std::cerr << "Unknown window type" << std::endl;
-				return;
-		}
+	_table = WindowRegistry::get(_type, _size, _sample_offset, _alpha);
+	if (!_table) {
+		return;
 	}
 	_isSetup = true;
+}
 
+const WindowTable &Window::getTable() const {
+	if (!_isSetup) {
+		throw std::runtime_error("Window not setup");
+	}
+	return *_table;
 }
 
 Signal Window::apply(const Signal &input) {
@@ -130,8 +73,11 @@ Signal Window::apply(const Signal &input) {
 	}
 
 	Signal output(_size);
+	const double *__restrict w = _table->values.data();
+	const double *__restrict x = input.data();
+	double *__restrict y = output.data();
 	for (size_t i = 0; i < _size; ++i) {
-		output[i] = input[i] * _window[i];
+		y[i] = x[i] * w[i];
 	}
 
 	return output;
@@ -146,5 +92,151 @@ double Window::apply(double input, size_t index) {
 		throw std::runtime_error("Index out of bounds");
 	}
 
-	return input * _window[index];
-};
+	return input * _table->values[index];
+}
+
+void Window::apply(const float *input, float *output) const {
+	const float *w = getTable().valuesFloat.data();
+	for (size_t i = 0; i < _size; ++i) {
+		output[i] = input[i] * w[i];
+	}
+}
+
+/* ------------------------------- */
+
+std::mutex WindowRegistry::_mutex;
+std::map<WindowRegistry::Key, std::shared_ptr<const WindowTable>> WindowRegistry::_tables;
+
+std::shared_ptr<const WindowTable> WindowRegistry::get(WindowType type, size_t size, size_t sample_offset, float alpha) {
+	if (type != WindowType::Tukey && type != WindowType::PlanckTaper) {
+		alpha = 0.0f; // paramètre sans effet : une seule table pour toutes les valeurs
+	}
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	Key key(type, size, sample_offset, alpha);
+	auto it = _tables.find(key);
+	if (it != _tables.end()) {
+		return it->second;
+	}
+
+	std::shared_ptr<const WindowTable> table = compute(type, size, sample_offset, alpha);
+	if (table) {
+		_tables.emplace(key, table);
+	}
+	return table;
+}
+
+size_t WindowRegistry::size() {
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _tables.size();
+}
+
+void WindowRegistry::clear() {
+	std::lock_guard<std::mutex> lock(_mutex);
+	_tables.clear();
+}
+
+// Fenêtres en somme de cosinus : w = a0 - a1.cos(t) + a2.cos(2t) - a3.cos(3t)
+static bool cosineSumCoefficients(WindowType type, double a[4]) {
+	switch (type) {
+		case WindowType::Hann:            a[0] = 0.5;       a[1] = 0.5;       a[2] = 0.0;       a[3] = 0.0;       return true;
+		case WindowType::Hamming:         a[0] = 0.54;      a[1] = 0.46;      a[2] = 0.0;       a[3] = 0.0;       return true;
+		case WindowType::Blackman:        a[0] = 0.42;      a[1] = 0.5;       a[2] = 0.08;      a[3] = 0.0;       return true;
+		case WindowType::Nuttall:         a[0] = 0.355768;  a[1] = 0.487396;  a[2] = 0.144232;  a[3] = 0.012604;  return true;
+		case WindowType::BlackmanNuttall: a[0] = 0.3635819; a[1] = 0.4891775; a[2] = 0.1365995; a[3] = 0.0106411; return true;
+		case WindowType::BlackmanHarris:  a[0] = 0.35875;   a[1] = 0.48829;   a[2] = 0.14128;   a[3] = 0.01168;   return true;
+		default: return false;
+	}
+}
+
+std::shared_ptr<const WindowTable> WindowRegistry::compute(WindowType type, size_t size, size_t sample_offset, float alpha) {
+	auto table = std::make_shared<WindowTable>();
+	table->type = type;
+	table->size = size;
+	table->sampleOffset = sample_offset;
+	table->alpha = alpha;
+
+	auto &w = table->values;
+	w.assign(size, 0.0);
+	const size_t begin = sample_offset;
+	const size_t end = (size > sample_offset) ? size - sample_offset : 0;
+	const double last = (size > 1) ? static_cast<double>(size - 1) : 1.0;
+
+	// Le type est traité hors de la boucle ; une seule fonction trigonométrique par échantillon
+	double a[4];
+	if (cosineSumCoefficients(type, a)) {
+		for (size_t i = begin; i < end; ++i) {
+			double c = std::cos(2 * M_PI * i / last);
+			double c2 = 2.0 * c * c - 1.0;   // cos(2t)
+			double c3 = c * (2.0 * c2 - 1.0); // cos(3t)
+			w[i] = a[0] - a[1] * c + a[2] * c2 - a[3] * c3;
+		}
+	} else {
+		switch (type) {
+			case WindowType::Rectangular:
+				for (size_t i = begin; i < end; ++i) {
+					w[i] = 1.0;
+				}
+				break;
+			case WindowType::Triangular:
+			case WindowType::Parzen:
+				for (size_t i = begin; i < end; ++i) {
+					w[i] = 1.0 - std::abs((i - (size - 1) / 2.0) / (size / 2.0));
+				}
+				break;
+			case WindowType::Welch:
+				for (size_t i = begin; i < end; ++i) {
+					double t = (i - (size - 1) / 2.0) / (size / 2.0);
+					w[i] = 1.0 - t * t;
+				}
+				break;
+			case WindowType::Sine:
+				for (size_t i = begin; i < end; ++i) {
+					w[i] = std::sin(M_PI * i / last);
+				}
+				break;
+			case WindowType::Tukey:
+				for (size_t i = begin; i < end; ++i) {
+					if (i < alpha * (size - 1) / 2) {
+						w[i] = 0.5 * (1 + cos(M_PI * (2.0 * i / (alpha * (size - 1)) - 1)));
+					} else if (i <= (size - 1) * (1 - alpha / 2)) {
+						w[i] = 1.0;
+					} else {
+						w[i] = 0.5 * (1 + cos(M_PI * (2.0 * i / (alpha * (size - 1)) - 2.0 / alpha + 1)));
+					}
+				}
+				break;
+			case WindowType::PlanckTaper:
+				for (size_t i = begin; i < end; ++i) {
+					double t = 2.0 * i / last;
+					if (t <= alpha) {
+						w[i] = 1.0 / (exp(alpha / t - alpha / (2 - t)) + 1);
+					} else if (t >= 2 - alpha) {
+						w[i] = 1.0 / (exp(alpha / (2 - t) - alpha / t) + 1);
+					} else {
+						w[i] = 1.0;
+					}
+				}
+				break;
+			default:
+				std::cerr << "Unknown window type" << std::endl;
+				return nullptr;
+		}
+	}
+
+	table->valuesFloat.assign(w.begin(), w.end());
+
+	// gain cohérent, bande équivalente de bruit et perte de festonnement (ton à un demi-bin)
+	double sum = 0.0, sum2 = 0.0;
+	std::complex<double> half = 0.0;
+	for (size_t i = 0; i < size; ++i) {
+		sum += w[i];
+		sum2 += w[i] * w[i];
+		half += w[i] * std::polar(1.0, -M_PI * i / size);
+	}
+	table->coherentGain = sum / size;
+	table->enbw = (sum != 0.0) ? size * sum2 / (sum * sum) : 0.0;
+	table->scallopingLoss = (sum != 0.0) ? -20.0 * std::log10(std::abs(half) / std::abs(sum)) : 0.0;
+
+	return table;
+}
@@ -4,6 +4,11 @@
 #include <vector>
 #include <cmath>
 #include <string>
+#include <memory>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <new>
 #include "Signal.hpp"
 
 /**
@@ -26,8 +31,100 @@ enum class WindowType {
 	PlanckTaper
 };
 
+/**
+ * @brief Correction of the gain of the window applied to a spectrum
+ */
+enum class WindowCorrection {
+	NONE,      // Raw spectrum of the windowed signal
+	AMPLITUDE, // Amplitude of the tones preserved (divided by the coherent gain)
+	ENERGY,    // Noise density preserved (divided by the coherent gain and by sqrt(ENBW))
+};
+
+/**
+ * @brief Allocator returning memory aligned on a cache line, for the SIMD loops
+ */
+template <typename T, size_t Alignment = 64>
+struct AlignedAllocator {
+	using value_type = T;
+
+	template <typename U>
+	struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+	AlignedAllocator() = default;
+	template <typename U>
+	AlignedAllocator(const AlignedAllocator<U, Alignment> &) {}
+
+	T *allocate(size_t n) {
+		return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+	}
+	void deallocate(T *p, size_t) {
+		::operator delete(p, std::align_val_t(Alignment));
+	}
+
+	template <typename U>
+	bool operator==(const AlignedAllocator<U, Alignment> &) const { return true; }
+	template <typename U>
+	bool operator!=(const AlignedAllocator<U, Alignment> &) const { return false; }
+};
+
+/**
+ * @brief Coefficients of a window and its spectral figures, computed once
+ */
+struct WindowTable {
+	WindowType type;
+	size_t size;
+	size_t sampleOffset;
+	float alpha;
+
+	std::vector<double, AlignedAllocator<double>> values;
+	std::vector<float, AlignedAllocator<float>> valuesFloat;
+
+	double coherentGain;   // mean of the coefficients (amplitude gain on a tone)
+	double enbw;           // equivalent noise bandwidth, in bins
+	double scallopingLoss; // loss on a tone half way between two bins, in dB
+};
+
+/**
+ * @brief Process-wide registry of the window tables
+ * @details The tables are keyed by (type, size, offset, alpha) and computed on the
+ *          first request only; every later request for the same window shares the
+ *          same immutable table. The registry can be used from several threads.
+ */
+class WindowRegistry {
+public:
+	/**
+	 * @brief Get the table of a window, computed on the first call
+	 * @param[in] type Type of the window
+	 * @param[in] size Size of the window
+	 * @param[in] sample_offset Number of null coefficients at each end of the window
+	 * @param[in] alpha Parameter of the window Tukey and PlanckTaper (ignored by the others)
+	 * @return Shared table of the window
+	 */
+	static std::shared_ptr<const WindowTable> get(WindowType type, size_t size, size_t sample_offset = 0, float alpha = 0.1);
+
+	/**
+	 * @brief Number of tables in the registry
+	 */
+	static size_t size();
+
+	/**
+	 * @brief Forget the tables (those still in use stay valid)
+	 */
+	static void clear();
+
+private:
+	using Key = std::tuple<WindowType, size_t, size_t, float>;
+
+	static std::shared_ptr<const WindowTable> compute(WindowType type, size_t size, size_t sample_offset, float alpha);
+
+	static std::mutex _mutex;
+	static std::map<Key, std::shared_ptr<const WindowTable>> _tables;
+};
+
 /**
  * @brief Window class for applying a window to a signal
+ * @details The coefficients are shared with every other window of the same
+ *          parameters through the WindowRegistry.
  */
 class Window {
 public:
@@ -116,8 +213,45 @@ public:
 	 */
 	virtual double apply(double input, size_t index);
 
+	/**
+	 * @brief Apply the window to a block of single precision samples
+	 * @param[in] input Input samples, getSize() of them
+	 * @param[out] output Windowed samples (may be equal to input)
+	 */
+	void apply(const float *input, float *output) const;
+
+	/**
+	 * @brief Table of the window (coefficients and spectral figures)
+	 */
+	const WindowTable &getTable() const;
+
+	/**
+	 * @brief Coefficients of the window
+	 */
+	const double *data() const { return getTable().values.data(); }
+
+	/**
+	 * @brief Coefficients of the window in single precision
+	 */
+	const float *dataFloat() const { return getTable().valuesFloat.data(); }
+
+	/**
+	 * @brief Mean of the coefficients (amplitude gain on a tone)
+	 */
+	double getCoherentGain() const { return getTable().coherentGain; }
+
+	/**
+	 * @brief Equivalent noise bandwidth, in bins
+	 */
+	double getENBW() const { return getTable().enbw; }
+
+	/**
+	 * @brief Loss on a tone half way between two bins, in dB
+	 */
+	double getScallopingLoss() const { return getTable().scallopingLoss; }
+
 private:
-	std::vector<double> _window;
+	std::shared_ptr<const WindowTable> _table;
 	WindowType _type;
 	size_t _size;
 	size_t _sample_offset; // décalage de la fenêtre
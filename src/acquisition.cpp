@@ -4,8 +4,10 @@
 #include <sys/time.h>
 #include <time.h>
 #include <vector>
+#include <stdexcept>
 #include "acquisition.hpp"
 #include "globals.hpp"
+#include "Device.hpp"
 
 uint32_t getTimeDelay(int decimation) {	
 	/* Find optimal decimation setting */
@@ -26,135 +28,29 @@ uint32_t getTimeDelay(int decimation) {
 	}
 }
 
-static buffers_t *b = NULL;
-
 void initAcquisition(float triggerLevel, int32_t triggerDelay) {
-	rp_AcqReset();
-	rp_AcqSetTriggerLevel(RP_T_CH_1, triggerLevel);
-	rp_AcqSetTriggerDelay(triggerDelay);
-	
-	b = (buffers_t *) rp_createBuffer(2,BUFFER_SIZE,false,true,false);
+	getDevice().acquisition().init(triggerLevel, triggerDelay);
 }
 
 void releaseAcquisition() {
-	if (b != NULL) rp_deleteBuffer(b);
+	getDevice().acquisition().release();
 }
 
 void acquisitionChannel1(Signal &signal) {
-	signal.resize(BUFFER_SIZE);
-
-	rp_AcqSetDecimationFactor(DECIMATION);
-	int timeDelay = getTimeDelay(DECIMATION);
-	rp_acq_trig_state_t state = RP_TRIG_STATE_TRIGGERED;
-	bool fillState = false;
-
-	/* Echantillonnage du signal */
-	fillState = false;
-
-	rp_AcqStart();
-	usleep(timeDelay);
-	rp_AcqSetTriggerSrc(RP_TRIG_SRC_CHA_PE);
-
-	while(1) {
-		rp_AcqGetTriggerState(&state);
-		if(state == RP_TRIG_STATE_TRIGGERED) {
-			break;
-		}
-	}
-	while(!fillState){
-		rp_AcqGetBufferFillState(&fillState);
-	}
-
-	rp_AcqStop();
-
-	uint32_t pos = 0;
-	rp_AcqGetWritePointerAtTrig(&pos);
-
-	rp_AcqGetData(pos, b);
-	
-	/* Enrgistrement du buffer */
-	for (size_t i = 0; i < BUFFER_SIZE; i++) signal[i] = b->ch_d[0][i];
-
-	/* Releasing resources */
-	//rp_deleteBuffer(b);
+	getDevice().acquisition().acquire(&signal, nullptr, RP_TRIG_SRC_CHA_PE);
 }
 
 void acquisitionChannel2(Signal &signal) {
-	signal.resize(BUFFER_SIZE);
-	
-	rp_AcqSetDecimationFactor(DECIMATION);
-	int timeDelay = getTimeDelay(DECIMATION);
-	rp_acq_trig_state_t state = RP_TRIG_STATE_TRIGGERED;
-	bool fillState = false;
-
-	/* Echantillonnage du signal */
-	fillState = false;
-
-	rp_AcqStart();
-	usleep(timeDelay);
-	rp_AcqSetTriggerSrc(RP_TRIG_SRC_CHA_PE);
-
-	while(1) {
-		rp_AcqGetTriggerState(&state);
-		if(state == RP_TRIG_STATE_TRIGGERED) {
-			break;
-		}
-	}
-	while(!fillState){
-		rp_AcqGetBufferFillState(&fillState);
-	}
-
-	rp_AcqStop();
-
-	uint32_t pos = 0;
-	//rp_AcqGetWritePointerAtTrig(&pos);
-	rp_AcqGetWritePointer(&pos);
-
-	rp_AcqGetData(pos, b);
-	
-	/* Enrgistrement du buffer */
-	for (size_t i = 0; i < BUFFER_SIZE; i++) signal[i] = b->ch_d[1][i];
-
-	/* Releasing resources */
-	//rp_deleteBuffer(b);
+	getDevice().acquisition().acquire(nullptr, &signal, RP_TRIG_SRC_CHA_PE);
 }
 
 void acquisitionChannels1_2(Signal &signal1, Signal &signal2, rp_channel_trigger_t trigger) {
-	signal1.resize(BUFFER_SIZE);
-	signal2.resize(BUFFER_SIZE);
-	
-	rp_AcqSetDecimationFactor(DECIMATION);
-	int timeDelay = getTimeDelay(DECIMATION);
-	rp_acq_trig_state_t state = RP_TRIG_STATE_TRIGGERED;
-	bool fillState = false;
-
-	/* Echantillonnage du signal */
-	fillState = false;
-
-	rp_AcqStart();
-	usleep(timeDelay);
-	rp_AcqSetTriggerSrc(RP_TRIG_SRC_CHA_PE);
-
-	while(1) {
-		rp_AcqGetTriggerState(&state);
-		if(state == RP_TRIG_STATE_TRIGGERED) {
-			break;
-		}
-	}
-	while(!fillState){
-		rp_AcqGetBufferFillState(&fillState);
-	}
-
-	rp_AcqStop();
-
-	uint32_t pos = 0;
-	rp_AcqGetWritePointerAtTrig(&pos);
-
-	rp_AcqGetData(pos, b);
-	
-	/* Enrgistrement du buffer */
-	for (size_t i = 0; i < BUFFER_SIZE; i++) {
-		signal1[i] = b->ch_d[0][i];
-		signal2[i] = b->ch_d[1][i];
-	}
+	// front montant de la voie de déclenchement demandée
+	rp_acq_trig_src_t source;
+	switch (trigger) {
+		case RP_T_CH_1: source = RP_TRIG_SRC_CHA_PE; break;
+		case RP_T_CH_2: source = RP_TRIG_SRC_CHB_PE; break;
+		default: throw std::invalid_argument("The trigger must be on channel 1 or 2");
+	}
+	getDevice().acquisition().acquire(&signal1, &signal2, source);
 }
\ No newline at end of file
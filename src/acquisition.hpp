@@ -1,15 +1,14 @@
 #ifndef __ACQUISITION_HPP
 #define __ACQUISITION_HPP
 
-#include "rp.h"
-#include "rp_hw-calib.h"
-#include "rp_hw-profiles.h"
-
 #include "Signal.hpp"
 #include "Window.hpp"
+#include "Device.hpp"
 
 uint32_t getTimeDelay(int decimation);
 
+/// @note The functions below acquire through the current device (getDevice())
+
 /// @brief Initialization of the acquisition driver
 /// @param[in] trigger_level Trigger level
 /// @param[in] trigger_delay Trigger delay
@@ -29,7 +28,7 @@ void acquisitionChannel2(Signal &signal);
 /// @brief Acquisition of two channels
 /// @param[out] signal1 Signal to fill
 /// @param[out] signal2 Signal to fill
-/// @param[in] trigger Trigger channel
+/// @param[in] trigger Trigger channel, RP_T_CH_1 or RP_T_CH_2 (rising edge)
 void acquisitionChannels1_2(Signal &signal1, Signal &signal2, rp_channel_trigger_t trigger = RP_T_CH_1);
 
 #endif // __ACQUISITION_HPP
\ No newline at end of file
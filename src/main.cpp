@@ -7,6 +7,58 @@
 
 #include "tests.hpp"
 #include "modules.hpp"
+#include "Device.hpp"
+#include "SimulatedDevice.hpp"
+#include "utils.hpp"
+
+/**
+ * @brief Remove the arguments of the simulated device from the list, and select it if asked
+ * @param[in,out] args Arguments of the test or module
+ */
+static void selectDevice(std::vector<std::string> &args) {
+	bool simulate = false;
+	DeviceModel model;
+	std::vector<std::string> remaining;
+
+	for (const auto &param : args) {
+		size_t pos = param.find('=');
+		std::string name = param.substr(0, pos);
+		std::string value = (pos != std::string::npos) ? param.substr(pos + 1) : "";
+
+		if (name == "simulate" || name == "sim") {
+			simulate = stringToBool(value);
+		} else if (name == "sim_gain") {
+			model.gain = std::stod(value);
+		} else if (name == "sim_phase") {
+			model.phase = std::stod(value);
+		} else if (name == "sim_delay") {
+			model.delay = std::stod(value);
+		} else if (name == "sim_frequency") {
+			model.resonance_frequency = std::abs(std::stod(value));
+		} else if (name == "sim_q") {
+			model.quality_factor = std::abs(std::stod(value));
+		} else if (name == "sim_drift") {
+			model.drift = std::stod(value);
+		} else if (name == "sim_noise") {
+			model.noise = std::abs(std::stod(value));
+		} else if (name == "sim_bits") {
+			model.adc_bits = std::stoi(value);
+		} else if (name == "sim_full_scale") {
+			model.full_scale = std::abs(std::stod(value));
+		} else if (name == "sim_seed") {
+			model.seed = static_cast<unsigned int>(std::stoul(value));
+		} else if (name == "sim_realtime") {
+			model.realtime = stringToBool(value);
+		} else {
+			remaining.push_back(param);
+		}
+	}
+	args = remaining;
+
+	if (simulate) {
+		setDevice(std::make_unique<SimulatedDevice>(model));
+	}
+}
 
 int main(int argc, char *argv[]){
 	int res = 0;
@@ -24,6 +76,9 @@ int main(int argc, char *argv[]){
 	// Supprimer le premier argument (name)
 	args.erase(args.begin());
 
+	// Carte simulée, pour tous les tests et modules
+	selectDevice(args);
+
 	if (name == "acquire") {
 		res |= test_acquire(args);
 	} else if (name == "spectrum") {
@@ -36,8 +91,12 @@ int main(int argc, char *argv[]){
 		res |= test_realTimeAcquisition(args);
 	} else if (name == "realTimeAcquisition2") {
 		res |= test_realTimeAcquisition2(args);
+	} else if (name == "streamAcquisition") {
+		res |= test_streamAcquisition(args);
 	} else if (name == "frequencyScanning") {
 		res |= module_frequencyScanning(args);
+	} else if (name == "resonanceTracking") {
+		res |= module_resonanceTracking(args);
 	} else if (name == "help") {
 		std::cout << "Available tests:" << std::endl;
 		std::cout << "\tacquire <optional arguments>" << std::endl;
@@ -46,8 +105,16 @@ int main(int argc, char *argv[]){
 		std::cout << "\tdemodulation2 <optional arguments>" << std::endl;
 		std::cout << "\trealTimeAcquisition <optional arguments>" << std::endl;
 		std::cout << "\trealTimeAcquisition2 <optional arguments>" << std::endl;
+		std::cout << "\tstreamAcquisition <optional arguments>" << std::endl;
 		std::cout << "Available modules:" << std::endl;
 		std::cout << "\tfrequencyScanning <optional arguments>" << std::endl;
+		std::cout << "\tresonanceTracking <optional arguments>" << std::endl;
+		std::cout << "Simulated card (arguments accepted by every test and module):" << std::endl;
+		std::cout << "\tsimulate=<boolean>; sim=<boolean>\t\treplace the card by a simulated one" << std::endl;
+		std::cout << "\tsim_gain=<value>; sim_phase=<rad>; sim_delay=<s>\tresponse of the device under test on CH2" << std::endl;
+		std::cout << "\tsim_frequency=<Hz>; sim_q=<value>; sim_drift=<Hz/s>\tresonance of the device under test (0: flat)" << std::endl;
+		std::cout << "\tsim_noise=<V>; sim_bits=<integer>; sim_full_scale=<V>\tnoise and ADC of both inputs" << std::endl;
+		std::cout << "\tsim_seed=<integer>; sim_realtime=<boolean>\t\tseed of the noise, wait for the simulated durations" << std::endl;
 	} else {
 		std::cerr << "Unknown test or module name: " << name << std::endl;
 		std::cerr << "Write 'help' to see available tests or modules." << std::endl;
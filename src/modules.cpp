@@ -9,19 +9,22 @@
 #include <string>
 #include <cstring>
 #include <chrono>
+#include <thread>
+#include <atomic>
+#include <exception>
 #include <algorithm>
 #include <sys/time.h>
 #include <iostream>
 #include <iomanip>
 #include <time.h>
-#include "rp.h"
-#include "rp_hw-calib.h"
-#include "rp_hw-profiles.h"
 
 #include "Signal.hpp"
 #include "Spectrum.hpp"
 #include "Filter.hpp"
+#include "MovingFilter.hpp"
 #include "Demodulator.hpp"
+#include "SweepPlan.hpp"
+#include "ResonanceTracker.hpp"
 #include "PID.hpp"
 #include "CSVFile.hpp"
 #include "Noise.hpp"
@@ -29,7 +32,9 @@
 #include "utils.hpp"
 #include "globals.hpp"
 #include "acquisition.hpp"
+#include "SimulatedDevice.hpp"
 #include "Timer.hpp"
+#include "SPSCQueue.hpp"
 #include <stdexcept>
 
 int module_frequencyScanning(const std::vector<std::string> &args) {
@@ -66,6 +71,13 @@ int module_frequencyScanning(const std::vector<std::string> &args) {
 
 		// Taille de la memoire du filtre moyenneur
 		int averaging_filter_order = 2; 
+		MovingFilterType averaging_filter_type = MovingFilterType::MEAN;
+
+		// démodulation sans déphasage (filtrage aller-retour)
+		bool zero_phase = false;
+
+		// fichier du plan de balayage précalculé (vide : pas de sauvegarde)
+		std::string plan_file = "";
 
 		bool mode_debug = false;
 		bool measure_time = false;
@@ -78,6 +90,8 @@ int module_frequencyScanning(const std::vector<std::string> &args) {
 					std::cerr << "  This module performs a frequency sweep, generating a sequence of" << std::endl;
 					std::cerr << "  frequencies on a logarithmic scale at the output of the card," << std::endl;
 					std::cerr << "  then performing an acquisition at the input of the card." << std::endl;
+					std::cerr << "  The acquisitions run in their own thread, overlapped with the processing" << std::endl;
+					std::cerr << "  of the previous ones." << std::endl;
 					std::cerr << "  " << std::endl;
 					std::cerr << "Possibilities of utilisation : " << std::endl;
 					std::cerr << "  Debug options : " << std::endl;
@@ -124,6 +138,9 @@ int module_frequencyScanning(const std::vector<std::string> &args) {
 					std::cerr << "    averaging_filter_order=<integer>; \tafo=<integer>; " << std::endl;
 					std::cerr << "      details: this is the order of the averaging filter" << std::endl;
 					std::cerr << "      note: this argument is optional, and if not entered, the default value is " << averaging_filter_order << std::endl;
+					std::cerr << "    averaging_filter=<string>; \taf=<string>; " << std::endl;
+					std::cerr << "      details: statistic of the averaging filter (mean, ema, median), the median rejects the outliers" << std::endl;
+					std::cerr << "      note: this argument is optional, and if not entered, the default value is " << movingFilterTypeToString(averaging_filter_type) << std::endl;
 					std::cerr << "    points_per_period=<integer>; \tppp=<integer>; " << std::endl;
 					std::cerr << "      details: this is the number of points per period of the signal" << std::endl;
 					std::cerr << "      note: this argument is optional, and if not entered, the default value is " << points_per_period << std::endl;
@@ -133,6 +150,13 @@ int module_frequencyScanning(const std::vector<std::string> &args) {
 					std::cerr << "    nb_acquisitions=<integer>; \tnba=<integer>; " << std::endl;
 					std::cerr << "      details: this is the number of acquisitions to perform by frequency in sweep frequencies" << std::endl;
 					std::cerr << "      note: this argument is optional, and if not entered, the default value is " << nb_acquisitions << std::endl;
+					std::cerr << "    zero_phase=<boolean>; \tzp=<boolean>; " << std::endl;
+					std::cerr << "      details: filter the demodulation forward and backward, the transient to discard is shorter" << std::endl;
+					std::cerr << "      note: this argument is optional, and if not entered, the default value is " << zero_phase << std::endl;
+					std::cerr << "    plan_file=<string>; \tpf=<string>; " << std::endl;
+					std::cerr << "      details: binary file holding the precomputed sweep plan (filters, reference tables)," << std::endl;
+					std::cerr << "               loaded if it matches the parameters of the sweep, written otherwise" << std::endl;
+					std::cerr << "      note: this argument is optional, and if not entered, the plan is not saved" << std::endl;
 					std::cerr << "  trigger_level=<float>; trl=<float>" << std::endl;
 					std::cerr << "      note: this argument is optional, and if not entered, the default value is " << trigger_level << "." << std::endl;
 					std::cerr << "  trigger_delay=<integer>; trd=<integer>" << std::endl;
@@ -174,6 +198,8 @@ int module_frequencyScanning(const std::vector<std::string> &args) {
 							}
 						} else if (name == "averaging_filter_order" || name == "afo") {
 							averaging_filter_order = std::abs(convertToInteger(value));
+						} else if (name == "averaging_filter" || name == "af") {
+							averaging_filter_type = stringToMovingFilterType(value);
 						} else if (name == "points_per_period" || name == "ppp") {
 							points_per_period = std::abs(convertToInteger(value));
 							if (points_per_period == 0) {
@@ -193,6 +219,10 @@ int module_frequencyScanning(const std::vector<std::string> &args) {
 							trigger_level = std::stof(value);
 						} else if (name == "trigger_delay" || name == "trd") {
 							trigger_delay = std::stoi(value);
+						} else if (name == "zero_phase" || name == "zp") {
+							zero_phase = stringToBool(value);
+						} else if (name == "plan_file" || name == "pf") {
+							plan_file = value;
 						} else {
 							std::cerr << "Error: invalid argument " << param << std::endl;
 							return 1;
@@ -228,8 +258,8 @@ int module_frequencyScanning(const std::vector<std::string> &args) {
 			std::cerr  << "Measure time is enabled" << std::endl;
 		}
 
-		/* Print error, if rp_Init() function failed */
-		if (rp_InitReset(true) != RP_OK) {
+		/* Print error, if the initialization of the card failed */
+		if (!getDevice().open()) {
 			std::cerr << "Error: Rp api init failed!";
 			return 1;
 		}
@@ -252,8 +282,6 @@ int module_frequencyScanning(const std::vector<std::string> &args) {
 		std::string filename5 = "phaseOfMovement.csv";
 		CSVFile outFile5(filename5);
 
-		Signal signal1, signal2;
-		Signal windowed_signal1, windowed_signal2;
 		Signal amplitude_demodulated1, phase_demodulated1;
 		Signal amplitude_demodulated2, phase_demodulated2;
 		Signal scanning_frequencies(0, "frequency");
@@ -281,32 +309,39 @@ int module_frequencyScanning(const std::vector<std::string> &args) {
 		/* - - - - - - - - - - - - - - - - - - - - - - - */
 		/* Initialisation de la démodulation */
 		Demodulator dem;
+		dem.setZeroPhase(zero_phase);
 
 		/* Initialisation de deux filtres moyenneurs */
-		AveragingFilter averaging_filter1;
-		AveragingFilter averaging_filter2;
-		averaging_filter1.set(averaging_filter_order);
-		averaging_filter2.set(averaging_filter_order);
-
-		/* Initialisation de la fenêtre */
-		Window window;
-		if (!window.set(window_type, BUFFER_SIZE)) {
-			throw std::runtime_error("Unable to set the window function.");
+		std::unique_ptr<MovingFilter> averaging_filter1 = createMovingFilter(averaging_filter_type, std::max(averaging_filter_order, 1));
+		std::unique_ptr<MovingFilter> averaging_filter2 = createMovingFilter(averaging_filter_type, std::max(averaging_filter_order, 1));
+		if (!averaging_filter1 || !averaging_filter2) {
+			throw std::runtime_error("Unable to set the averaging filters.");
+		}
+
+		/* Préparation du plan de balayage : décimations, filtres et tables de référence */
+		SweepPlan plan;
+		if (!plan.set(scanning_frequencies, dem_filter_freq, points_per_period, hasSetDecimation ? DECIMATION : 0, BUFFER_SIZE, 4, zero_phase)) {
+			throw std::runtime_error("Unable to set the sweep plan.");
+		}
+		if (!plan_file.empty() && plan.load(plan_file)) {
+			std::cerr << "Sweep plan loaded from " << plan_file << std::endl;
+		} else {
+			plan.setup();
+			if (!plan_file.empty()) {
+				plan.save(plan_file);
+			}
 		}
-		window.setup();
 
 		std::cerr << "Frequency scanning between " << frequency_min << " Hz to " << frequency_max << " Hz" << std::endl;
 
 		/* - - - - - - - - - - - - - - - - - - - - - - - */
 		/* Balayage des fréquences */
 
-		// calculer le temps de montée du signal en fonction de la fréquence du filtre de la démodulation à 3 tau
-		double rising_time = 3.0/dem_filter_freq;
-		size_t indexRisingTime;
-		size_t sizePermanentRegime;
+		size_t indexRisingTime = 0;
 		double amplitude, phase;
 		float pourcent = 0;
-		double sumAmp = 0, sumPh = 0;
+		double sumAmp = 0;
+		complexd sumRatio = 0.0;
 		int i = 0, j = 0;
 		double phase_max = -2*M_PI;
 		int phase_max_frequency = frequency_min;
@@ -317,165 +352,216 @@ int module_frequencyScanning(const std::vector<std::string> &args) {
 		double amplitude_min = 20.0f;
 		int amplitude_min_frequency = frequency_max;
 		
-		rp_GenReset();
+		GeneratorBackend &generator = getDevice().generator();
+		generator.reset();
 
 		/* Génération du signal sinusoïdal */
-		rp_GenWaveform(RP_CH_1, RP_WAVEFORM_SINE);
-		rp_GenFreq(RP_CH_1, static_cast<int>(scanning_frequencies[0]));
-		rp_GenAmp(RP_CH_1, output_amplitude);
-		rp_GenOffset(RP_CH_1, output_offset);
-		rp_GenPhase(RP_CH_1, output_phase);
-		rp_GenOutEnable(RP_CH_1);
-		rp_GenTriggerOnly(RP_CH_1);
+		generator.setWaveform(RP_WAVEFORM_SINE);
+		generator.setFrequency(static_cast<int>(scanning_frequencies[0]));
+		generator.setAmplitude(output_amplitude);
+		generator.setOffset(output_offset);
+		generator.setPhase(output_phase);
+		generator.enable();
 		
 		Timer acq_timer;
 		Timer process_timer;
 		Timer average_timer;
 		Timer sum_timer;
 		Timer demodulation_timer;
+		Timer sweep_timer;
+		Timer wait_timer;
 
-		double f;
-		for (j = 0; j < static_cast<int>(scanning_frequencies.size()); j++) {
-			f = scanning_frequencies[j];
+		/* - - - - - - - - - - - - - - - - - - - - - - - */
+		/* Pipeline : le thread d'acquisition remplit des trames préallouées pendant que ce thread les traite */
+		struct FrameSlot {
+			Signal signal1, signal2;
+		};
+		const size_t nb_slots = 4;
+		std::vector<FrameSlot> slots(nb_slots);
+		SPSCQueue<size_t> filled_slots(nb_slots); // trames acquises, à traiter
+		SPSCQueue<size_t> free_slots(nb_slots);   // trames traitées, à remplir
+		for (size_t k = 0; k < nb_slots; k++) {
+			free_slots.push(k);
+		}
+		std::atomic<bool> producer_failed(false);
+		std::exception_ptr producer_error;
 
-			rp_GenFreq(RP_CH_1, static_cast<int>(f));
-			
-			if (!hasSetDecimation) {
-				SetDecimation(calculateDecimation(f, points_per_period));
-			}
-			dem.set(dem_filter_freq, f);
-			dem.setup();
-
-			// calculer l'indice de la valeur à la fin du régime transitoire du signal
-			indexRisingTime = static_cast<size_t>(std::floor(rising_time * SAMPLING_FREQUENCY));
-			sizePermanentRegime = BUFFER_SIZE - indexRisingTime;
-			if (indexRisingTime >= BUFFER_SIZE ) {
-				throw std::runtime_error("The rising time is too long.");
-			}
+		if (measure_time) sweep_timer.start();
 
-			usleep(delay);
+		// le générateur, la décimation et la carte n'appartiennent qu'au thread d'acquisition pendant le balayage
+		std::thread producer([&]() {
+			try {
+				for (size_t n = 0; n < scanning_frequencies.size(); n++) {
+					const SweepStep &step = plan[n];
+					generator.setFrequency(static_cast<int>(step.frequency));
+					SetDecimation(step.decimation);
 
-			sumAmp = 0, sumPh = 0;
-			for (i = 0; i < nb_acquisitions; i++) {
-				pourcent = std::floor((i + j*nb_acquisitions + 1) / static_cast<float>(nb_acquisitions * scanning_frequencies.size())*10000)/100;
-				std::cerr << "\rFrequency " << f << " Hz (" << pourcent << "%)    " << std::flush;
+					getDevice().wait(delay * 1e-6);
 
-				/* BEGIN ACQUISITION */ {
-					if (measure_time) acq_timer.start();
+					for (int k = 0; k < nb_acquisitions; k++) {
+						// sommeil jusqu'à ce qu'une trame soit libérée, ou l'arrêt du balayage
+						size_t slot;
+						if (free_slots.isClosed() || !free_slots.waitPop(slot)) return;
 
-					// Acquisition sur les channels 1 et 2 avec le trigger sur le channel 1
-					acquisitionChannels1_2(signal1, signal2, RP_T_CH_1);
+						/* BEGIN ACQUISITION */ {
+							if (measure_time) acq_timer.start();
 
-					if (measure_time) acq_timer.stop();
+							// Acquisition sur les channels 1 et 2 avec le trigger sur le channel 1
+							acquisitionChannels1_2(slots[slot].signal1, slots[slot].signal2, RP_T_CH_1);
 
-				} /* END ACQUISITION */
+							if (measure_time) acq_timer.stop();
+						} /* END ACQUISITION */
 
-				/* BEGIN PROCESSING */ {
-					if (measure_time) process_timer.start();
+						filled_slots.push(slot);
+					}
+				}
+			} catch (...) {
+				producer_error = std::current_exception();
+				producer_failed = true;
+			}
+			// réveil du thread de traitement s'il attend une trame qui ne viendra pas
+			filled_slots.close();
+		});
+
+		double f = 0;
+		try {
+			for (j = 0; j < static_cast<int>(scanning_frequencies.size()); j++) {
+				const SweepStep &step = plan[j];
+				f = step.frequency;
+
+				// fs de l'étape : SAMPLING_FREQUENCY est modifiée par le thread d'acquisition
+				dem.set(dem_filter_freq, f, step.samplingFrequency);
+				dem.setup(step.sections);
+				dem.setReference(&step.sinus, &step.cosinus);
+
+				// indice de la valeur à la fin du régime transitoire du signal (calculé dans le plan)
+				indexRisingTime = step.indexRisingTime;
+
+				sumAmp = 0;
+				sumRatio = 0.0;
+				for (i = 0; i < nb_acquisitions; i++) {
+					pourcent = std::floor((i + j*nb_acquisitions + 1) / static_cast<float>(nb_acquisitions * scanning_frequencies.size())*10000)/100;
+					std::cerr << "\rFrequency " << f << " Hz (" << pourcent << "%)    " << std::flush;
+
+					// trame suivante du thread d'acquisition
+					size_t slot;
+					if (measure_time) wait_timer.start();
+					if (!filled_slots.waitPop(slot)) {
+						if (producer_failed) std::rethrow_exception(producer_error);
+						throw std::runtime_error("The acquisition thread stopped before the end of the sweep");
+					}
+					if (measure_time) wait_timer.stop();
+					Signal &signal1 = slots[slot].signal1;
+					Signal &signal2 = slots[slot].signal2;
 
-					// Fenêtrage des signaux
-					windowed_signal1 = window.apply(signal1);
-					windowed_signal2 = window.apply(signal2);
+					/* BEGIN PROCESSING */ {
+						if (measure_time) process_timer.start();
 
-					if (measure_time) demodulation_timer.start();
+						if (measure_time) demodulation_timer.start();
 					
-					// démodulation des signaux
-					dem.apply(signal1, amplitude_demodulated1, phase_demodulated1, true);
-					dem.apply(signal2, amplitude_demodulated2, phase_demodulated2, true);
+						// démodulation des deux signaux en une passe : amplitude de CH2 et rapport H = CH2/CH1
+						DualDemodulation result = dem.applyRatio(signal1, signal2, indexRisingTime, true);
 
-					if (measure_time) demodulation_timer.stop();
+						if (measure_time) demodulation_timer.stop();
 
-					if (mode_debug) {
-						for (size_t k = 0; k < BUFFER_SIZE; k++) {
-							// Sauvegarde des signaux
-							bigSignal1[k + i*BUFFER_SIZE] = signal1[k];
-							bigSignal2[k + i*BUFFER_SIZE] = signal2[k];
+						if (measure_time) sum_timer.start();
+
+						// le rapport complexe est moyenné avant d'en prendre la phase (pas de saut de 2.pi)
+						sumAmp   += result.amplitude2;
+						sumRatio += result.ratio;
+
+						if (measure_time) sum_timer.stop();
 
-							bigAmplitudeDemodulated1[k + i*BUFFER_SIZE] = amplitude_demodulated1[k];
-							bigAmplitudeDemodulated2[k + i*BUFFER_SIZE] = amplitude_demodulated2[k];
+						if (mode_debug) {
+							// signaux démodulés complets, seulement pour la sauvegarde
+							dem.apply(signal1, signal2, amplitude_demodulated1, phase_demodulated1, amplitude_demodulated2, phase_demodulated2, true);
 
-							bigPhaseDemodulated1[k + i*BUFFER_SIZE] = phase_demodulated1[k];
-							bigPhaseDemodulated2[k + i*BUFFER_SIZE] = phase_demodulated2[k];
+							for (size_t k = 0; k < BUFFER_SIZE; k++) {
+								// Sauvegarde des signaux
+								bigSignal1[k + i*BUFFER_SIZE] = signal1[k];
+								bigSignal2[k + i*BUFFER_SIZE] = signal2[k];
 
-							// Calculer la moyenne de l'ampltitude et de la phase après le temps de montée
-							if (k >= indexRisingTime) {
-								sumAmp += amplitude_demodulated2[k];
-								sumPh  += (phase_demodulated2[k] - phase_demodulated1[k]);
+								bigAmplitudeDemodulated1[k + i*BUFFER_SIZE] = amplitude_demodulated1[k];
+								bigAmplitudeDemodulated2[k + i*BUFFER_SIZE] = amplitude_demodulated2[k];
+
+								bigPhaseDemodulated1[k + i*BUFFER_SIZE] = phase_demodulated1[k];
+								bigPhaseDemodulated2[k + i*BUFFER_SIZE] = phase_demodulated2[k];
 							}
 						}
-					} else {
-						if (measure_time) sum_timer.start();
 
-						for (size_t k = indexRisingTime; k < BUFFER_SIZE; k++) {
-							sumAmp += amplitude_demodulated2[k];
-							sumPh  += (phase_demodulated2[k] - phase_demodulated1[k]);
-						}
+						if (measure_time) process_timer.stop();
+					} /* END PROCESSING */
 
-						if (measure_time) sum_timer.stop();
-					}
-
-					if (measure_time) process_timer.stop();
-				} /* END PROCESSING */
-			}
+					free_slots.push(slot);
+				}
 
-			/* BEGIN AVERAGING */ {
-				if (measure_time) average_timer.start();
+				/* BEGIN AVERAGING */ {
+					if (measure_time) average_timer.start();
 
-				// calculer la moyenne de l'ampltitude après le temps de montée puis appliquer le filtre moyenneur
-				amplitude = averaging_filter1.apply(sumAmp / static_cast<double>(sizePermanentRegime * nb_acquisitions));
-				phase = averaging_filter2.apply(sumPh / static_cast<double>(sizePermanentRegime * nb_acquisitions));
+					// calculer la moyenne de l'ampltitude après le temps de montée puis appliquer le filtre moyenneur
+					amplitude = averaging_filter1->apply(sumAmp / static_cast<double>(nb_acquisitions));
+					phase = averaging_filter2->apply(std::arg(sumRatio));
 
-				// on vérifie si l'amplitude est plus grande que l'amplitude maximale déjà enregistrée
-				if (amplitude > amplitude_max) {
-					amplitude_max = amplitude;
-					amplitude_max_frequency = f;
-				}
-				// on vérifie si la phase est plus grande que la phase maximale déjà enregistrée
-				if (phase > phase_max) {
-					phase_max = phase;
-					phase_max_frequency = f;
-				}
+					// on vérifie si l'amplitude est plus grande que l'amplitude maximale déjà enregistrée
+					if (amplitude > amplitude_max) {
+						amplitude_max = amplitude;
+						amplitude_max_frequency = f;
+					}
+					// on vérifie si la phase est plus grande que la phase maximale déjà enregistrée
+					if (phase > phase_max) {
+						phase_max = phase;
+						phase_max_frequency = f;
+					}
 
-				// on vérifie si l'amplitude est plus petite que l'amplitude minimale déjà enregistrée
-				if (amplitude < amplitude_min) {
-					amplitude_min = amplitude;
-					amplitude_min_frequency = f;
-				}
-				// on vérifie si la phase est plus grande que la phase minimale déjà enregistrée
-				if (phase < phase_min) {
-					phase_min = phase;
-					phase_min_frequency = f;
-				}
+					// on vérifie si l'amplitude est plus petite que l'amplitude minimale déjà enregistrée
+					if (amplitude < amplitude_min) {
+						amplitude_min = amplitude;
+						amplitude_min_frequency = f;
+					}
+					// on vérifie si la phase est plus grande que la phase minimale déjà enregistrée
+					if (phase < phase_min) {
+						phase_min = phase;
+						phase_min_frequency = f;
+					}
 
-				amplitude_of_movement[j] = amplitude;
-				phase_of_movement[j] = phase;
-
-				if (measure_time) average_timer.stop();
-			} /* END AVERAGING */
-
-			/* Sauvgarde des données */
-			if (mode_debug) {
-				bigSignal1.setName("signal1_" + std::to_string(static_cast<int>(f)));
-				bigSignal2.setName("signal2_" + std::to_string(static_cast<int>(f)));
-				std::vector<Signal> bigSignals = {bigSignal1, bigSignal2};
-				bigAmplitudeDemodulated1.setName("amplitude_demodulated1_" + std::to_string(static_cast<int>(f)));
-				bigAmplitudeDemodulated2.setName("amplitude_demodulated2_" + std::to_string(static_cast<int>(f)));
-				std::vector<Signal> amplitudes_demodulated = {bigAmplitudeDemodulated1, bigAmplitudeDemodulated2};
-				bigPhaseDemodulated1.setName("phase_demodulated1_" + std::to_string(static_cast<int>(f)));
-				bigPhaseDemodulated2.setName("phase_demodulated2_" + std::to_string(static_cast<int>(f)));
-				std::vector<Signal> phases_demodulated = {bigPhaseDemodulated1, bigPhaseDemodulated2};
+					amplitude_of_movement[j] = amplitude;
+					phase_of_movement[j] = phase;
+
+					if (measure_time) average_timer.stop();
+				} /* END AVERAGING */
+
+				/* Sauvgarde des données */
+				if (mode_debug) {
+					bigSignal1.setName("signal1_" + std::to_string(static_cast<int>(f)));
+					bigSignal2.setName("signal2_" + std::to_string(static_cast<int>(f)));
+					std::vector<Signal> bigSignals = {bigSignal1, bigSignal2};
+					bigAmplitudeDemodulated1.setName("amplitude_demodulated1_" + std::to_string(static_cast<int>(f)));
+					bigAmplitudeDemodulated2.setName("amplitude_demodulated2_" + std::to_string(static_cast<int>(f)));
+					std::vector<Signal> amplitudes_demodulated = {bigAmplitudeDemodulated1, bigAmplitudeDemodulated2};
+					bigPhaseDemodulated1.setName("phase_demodulated1_" + std::to_string(static_cast<int>(f)));
+					bigPhaseDemodulated2.setName("phase_demodulated2_" + std::to_string(static_cast<int>(f)));
+					std::vector<Signal> phases_demodulated = {bigPhaseDemodulated1, bigPhaseDemodulated2};
 			
-				if (j == 0) {
-					outFile1.writeSignals(bigSignals, true);
-					outFile2.writeSignals(amplitudes_demodulated, true);
-					outFile3.writeSignals(phases_demodulated, true);
-				} else {
-					outFile1.writeSignalsToEnd(bigSignals);
-					outFile2.writeSignalsToEnd(amplitudes_demodulated);
-					outFile3.writeSignalsToEnd(phases_demodulated);
+					if (j == 0) {
+						outFile1.writeSignals(bigSignals, true);
+						outFile2.writeSignals(amplitudes_demodulated, true);
+						outFile3.writeSignals(phases_demodulated, true);
+					} else {
+						outFile1.writeSignalsToEnd(bigSignals);
+						outFile2.writeSignalsToEnd(amplitudes_demodulated);
+						outFile3.writeSignalsToEnd(phases_demodulated);
+					}
 				}
 			}
+		} catch (...) {
+			// arrêt du thread d'acquisition avant de propager l'erreur
+			free_slots.close();
+			producer.join();
+			throw;
 		}
+		producer.join();
+
+		if (measure_time) sweep_timer.stop();
 		std::cerr << "\n";
 			
 		std::vector<Signal> sigOut1 = {scanning_frequencies, amplitude_of_movement};
@@ -501,6 +587,7 @@ int module_frequencyScanning(const std::vector<std::string> &args) {
 		oss << "trigger_level = " << trigger_level << std::endl;
 		oss << "trigger_delay = " << trigger_delay << std::endl;
 		oss << "points_per_period = " 	<< points_per_period << std::endl;
+		oss << "# Decimation of the last step, see decimations for each step" << std::endl;
 		oss << "decimation = "			<< DECIMATION << std::endl;
 		oss << "buffsize = "			<< BUFFER_SIZE << std::endl;
 		oss << "nb_acquisitions = "	    << nb_acquisitions << std::endl;
@@ -516,9 +603,23 @@ int module_frequencyScanning(const std::vector<std::string> &args) {
 		oss << "window_type = "			<< windowTypeToString(window_type) << std::endl;
 		oss << "dem_filter_freq = "		<< dem_filter_freq << std::endl;
 		oss << "averaging_filter_order = " << averaging_filter_order << std::endl;
+		oss << "averaging_filter = "	<< movingFilterTypeToString(averaging_filter_type) << std::endl;
+		oss << "zero_phase = "			<< zero_phase << std::endl;
+		oss << "plan_file = "			<< plan_file << std::endl;
 		oss << std::endl;
 		oss << "[variables]" << std::endl;
+		oss << "# Sampling frequency of the last step, see sampling_frequencies for each step" << std::endl;
 		oss << "samplig_frequency = " << SAMPLING_FREQUENCY << std::endl;
+		oss << "decimations = ";
+		for (size_t n = 0; n < scanning_frequencies.size(); n++) {
+			oss << (n ? ", " : "") << plan[n].decimation;
+		}
+		oss << std::endl;
+		oss << "sampling_frequencies = ";
+		for (size_t n = 0; n < scanning_frequencies.size(); n++) {
+			oss << (n ? ", " : "") << plan[n].samplingFrequency;
+		}
+		oss << std::endl;
 		oss << "index_rising_time = " << indexRisingTime << std::endl;
 		oss << std::endl;
 		oss << "[measures]" << std::endl;
@@ -534,6 +635,18 @@ int module_frequencyScanning(const std::vector<std::string> &args) {
 			oss << "average_process_time_min = " << average_timer.getMinDuration() << std::endl;
 			oss << "demodulation_time_max = " << demodulation_timer.getMaxDuration() << std::endl;
 			oss << "demodulation_time_min = " << demodulation_timer.getMinDuration() << std::endl;
+
+			// recouvrement : la part de l'acquisition pendant laquelle le traitement n'attendait pas de trame
+			const double acquisition_total = acq_timer.getTotalDuration();
+			const double overlap = std::max(0.0, acquisition_total - wait_timer.getTotalDuration());
+			const double overlap_ratio = (acquisition_total > 0.0) ? overlap / acquisition_total : 0.0;
+			oss << "sweep_time = " << sweep_timer.getDuration() << std::endl;
+			oss << "acquisition_time_total = " << acquisition_total << std::endl;
+			oss << "process_time_total = " << process_timer.getTotalDuration() << std::endl;
+			oss << "wait_time_total = " << wait_timer.getTotalDuration() << std::endl;
+			oss << "overlap_time = " << overlap << std::endl;
+			oss << "overlap_ratio = " << overlap_ratio << std::endl;
+			std::cerr << "Acquisition overlapped with processing: " << overlap << " ms of " << acquisition_total << " ms (" << 100.0 * overlap_ratio << "%)" << std::endl;
 		}
 		oss << std::endl;
 		oss << "amplitude_max = " << amplitude_max << std::endl;
@@ -561,9 +674,287 @@ int module_frequencyScanning(const std::vector<std::string> &args) {
 		result = 1;
 	}
 	
-	rp_GenOutDisable(RP_CH_1);
+	getDevice().generator().disable();
+	releaseAcquisition();
+	getDevice().close();
+
+	return result;
+}
+
+int module_resonanceTracking(const std::vector<std::string> &args) {
+	int result;
+
+	try {
+
+		SetBufferSize(ADC_BUFFER_SIZE);
+		SetDecimation(64);
+
+		// propriétés de la boucle de suivi
+		double start_frequency = 10000;
+		double target_phase = 0.0;
+		double span = 1000;
+		double kp = 20;
+		double ki = 2000;
+		double kd = 0;
+		double update_rate = 100;
+		double duration = 10;
+
+		// propriétés du sinal généré
+		float output_amplitude = 1.0f;
+
+		// propriété démodulation
+		double dem_filter_freq = 1e3;
+
+		// propriétés acquisition
+		float  trigger_level = 0.01f;
+		int32_t trigger_delay = BUFFER_SIZE/2;
+
+		bool measure_time = false;
+
+		if (args.size() >= 1) {
+			for (auto param : args) {
+				if (param == "help") {
+					std::cerr << "\033[4;0mHelp message\033[0m" << std::endl;
+					std::cerr << "Details:" << std::endl;
+					std::cerr << "  This module follows a resonance with a phase-locked loop: the phase of" << std::endl;
+					std::cerr << "  CH2 relative to CH1 is demodulated at each acquisition, and a PID moves" << std::endl;
+					std::cerr << "  the frequency of the generator to hold this phase on the target." << std::endl;
+					std::cerr << "  The tracked frequency and amplitude are written at the update rate." << std::endl;
+					std::cerr << "  " << std::endl;
+					std::cerr << "Possibilities of utilisation : " << std::endl;
+					std::cerr << "  Debug options : " << std::endl;
+					std::cerr << "    measure_time=<boolean>" << std::endl;
+					std::cerr << "      details: this is a boolean value, which if true, will display the durations of the updates" << std::endl;
+					std::cerr << "      note: this argument is optional, and if not entered, the default value is " << measure_time << std::endl;
+					std::cerr << "  Tracking loop : " << std::endl;
+					std::cerr << "    frequency=<value>; f=<value>" << std::endl;
+					std::cerr << "      details: this is the start frequency, near the resonance" << std::endl;
+					std::cerr << "      note: this argument is optional, and if not entered, the default value is " << start_frequency << std::endl;
+					std::cerr << "    target_phase=<value>; tp=<value>" << std::endl;
+					std::cerr << "      details: this is the phase of CH2 relative to CH1 to hold, in radians" << std::endl;
+					std::cerr << "      note: this argument is optional, and if not entered, the default value is " << target_phase << std::endl;
+					std::cerr << "    span=<value>" << std::endl;
+					std::cerr << "      details: this is the maximum distance to the start frequency, in Hz" << std::endl;
+					std::cerr << "      note: this argument is optional, and if not entered, the default value is " << span << std::endl;
+					std::cerr << "    kp=<value>; ki=<value>; kd=<value>" << std::endl;
+					std::cerr << "      details: these are the gains of the PID, in Hz/rad, Hz/(rad.s) and Hz.s/rad" << std::endl;
+					std::cerr << "               the phase slope at a resonance is about 2Q/f rad/Hz" << std::endl;
+					std::cerr << "      note: these arguments are optional, and if not entered, the default values are " << kp << ", " << ki << " and " << kd << std::endl;
+					std::cerr << "    update_rate=<value>; ur=<value>" << std::endl;
+					std::cerr << "      details: this is the number of updates of the frequency per second" << std::endl;
+					std::cerr << "      note: this argument is optional, and if not entered, the default value is " << update_rate << std::endl;
+					std::cerr << "    duration=<value>; d=<value>" << std::endl;
+					std::cerr << "      details: this is the duration of the tracking, in seconds" << std::endl;
+					std::cerr << "      note: this argument is optional, and if not entered, the default value is " << duration << std::endl;
+					std::cerr << "  Generator properties : " << std::endl;
+					std::cerr << "    amplitude=<valu>; a=<value>; " << std::endl;
+					std::cerr << "      details: this is the amplitude of the signal generated by the card" << std::endl;
+					std::cerr << "      note: this argument is optional, and if not entered, the default value is " << output_amplitude << std::endl;
+					std::cerr << "  Acquisition properties : " << std::endl;
+					std::cerr << "    dem_filter_freq=<integer>; \tdff=<integer>; " << std::endl;
+					std::cerr << "      details: this is the frequency of the low pass filter to apply to the demodulation" << std::endl;
+					std::cerr << "      note: this argument is optional, and if not entered, the default value is " << dem_filter_freq << std::endl;
+					std::cerr << "    decimation=<integer>; \tdec=<integer>; " << std::endl;
+					std::cerr << "      details: this is the decimation factor of the acquisition signal" << std::endl;
+					std::cerr << "      note: this argument is optional, and if not entered, the default value is " << DECIMATION << std::endl;
+					std::cerr << "    buffer_size=<integer>; \tbs=<integer>; " << std::endl;
+					std::cerr << "      details: this is the buffer size of the acquisition signal" << std::endl;
+					std::cerr << "      note: this argument is optional, and if not entered, the default value is " << ADC_BUFFER_SIZE << std::endl;
+					std::cerr << "  trigger_level=<float>; trl=<float>" << std::endl;
+					std::cerr << "      note: this argument is optional, and if not entered, the default value is " << trigger_level << "." << std::endl;
+					std::cerr << "  trigger_delay=<integer>; trd=<integer>" << std::endl;
+					std::cerr << "      note: Enter the trigger delay in sample index." << std::endl;
+					std::cerr << "            This argument is optional, and if not entered, the default value is " << trigger_delay << "." << std::endl;
+					return 0;
+				} else {
+					// Parse other arguments
+					size_t pos = param.find('=');
+					if (pos != std::string::npos) {
+						std::string name = param.substr(0, pos);
+						std::string value = param.substr(pos + 1);
+
+						if (name == "measure_time") {
+							measure_time = stringToBool(value);
+						} else if (name == "frequency" || name == "f") {
+							start_frequency = std::stod(value);
+						} else if (name == "target_phase" || name == "tp") {
+							target_phase = std::stod(value);
+						} else if (name == "span") {
+							span = std::abs(std::stod(value));
+						} else if (name == "kp") {
+							kp = std::stod(value);
+						} else if (name == "ki") {
+							ki = std::stod(value);
+						} else if (name == "kd") {
+							kd = std::stod(value);
+						} else if (name == "update_rate" || name == "ur") {
+							update_rate = std::abs(std::stod(value));
+						} else if (name == "duration" || name == "d") {
+							duration = std::abs(std::stod(value));
+						} else if (name == "amplitude" || name == "a") {
+							output_amplitude = std::stof(value);
+						} else if (name == "dem_filter_freq" || name == "dff") {
+							dem_filter_freq = std::abs(convertToInteger(value));
+						} else if (name == "decimation" || name == "dec") {
+							SetDecimation(std::stoi(value));
+						} else if (name == "buffsize" || name == "bs") {
+							SetBufferSize(convertToInteger(value));
+						} else if (name == "trigger_level" || name == "trl") {
+							trigger_level = std::stof(value);
+						} else if (name == "trigger_delay" || name == "trd") {
+							trigger_delay = std::stoi(value);
+						} else {
+							std::cerr << "Error: invalid argument " << param << std::endl;
+							return 1;
+						}
+
+					} else {
+						std::cerr << "Error: invalid argument " << param << std::endl;
+						return 1;
+					}
+				}
+			}
+		}
+
+		// une acquisition doit tenir dans une période de mise à jour
+		if (static_cast<double>(BUFFER_SIZE) / SAMPLING_FREQUENCY > 1.0 / update_rate) {
+			std::cerr << "Error: an acquisition (" << 1e3 * BUFFER_SIZE / SAMPLING_FREQUENCY << " ms) is longer than the update period" << std::endl;
+			return 1;
+		}
+
+		ResonanceTracker tracker;
+		if (!tracker.set(start_frequency, target_phase, kp, ki, kd, span, dem_filter_freq, update_rate, static_cast<size_t>(std::ceil(duration * update_rate)) + 1)) {
+			throw std::runtime_error("Unable to set the resonance tracker.");
+		}
+		tracker.setup();
+
+		/* Print error, if the initialization of the card failed */
+		if (!getDevice().open()) {
+			std::cerr << "Error: Rp api init failed!";
+			return 1;
+		}
+		initAcquisition(trigger_level, trigger_delay);
+
+		// résonance du dispositif simulé, enregistrée pour comparaison
+		SimulatedDevice *simulated = dynamic_cast<SimulatedDevice *>(&getDevice());
+
+		GeneratorBackend &generator = getDevice().generator();
+		generator.reset();
+
+		/* Génération du signal sinusoïdal */
+		generator.setWaveform(RP_WAVEFORM_SINE);
+		generator.setFrequency(tracker.getFrequency());
+		generator.setAmplitude(output_amplitude);
+		generator.enable();
+
+		std::cerr << "+----------- START -------------+" << std::endl;
+
+		CSVFile::setTimeToFilepath();
+		std::string filename1 = "tracking.csv";
+		CSVFile outFile1(filename1);
+
+		Signal signal1, signal2;
+		const size_t nb_updates = static_cast<size_t>(std::ceil(duration * update_rate));
+		Signal resonance_frequency(0, "resonance_frequency");
+
+		Timer update_timer;
+
+		/* - - - - - - - - - - - - - - - - - - - - - - - */
+		/* Boucle de suivi, à cadence fixe */
+		const double period = 1.0 / update_rate;
+		double next = getDevice().now();
+		for (size_t n = 0; n < nb_updates; n++) {
+			acquisitionChannels1_2(signal1, signal2, RP_T_CH_1);
+			if (simulated != nullptr) {
+				resonance_frequency.push_back(simulated->getResonanceFrequency());
+			}
+
+			if (measure_time) update_timer.start();
+			TrackingSample sample = tracker.update(signal1, signal2);
+			if (measure_time) update_timer.stop();
+
+			generator.setFrequency(tracker.getFrequency());
+			next += period;
+			getDevice().waitUntil(next);
+
+			std::cerr << "\rt = " << sample.time << " s, frequency " << sample.frequency << " Hz, amplitude " << sample.amplitude << ", phase " << sample.phase << "    " << std::flush;
+		}
+		std::cerr << "\n";
+
+		/* Sauvgarde des données */
+		const RingBuffer<TrackingSample> &samples = tracker.getSamples();
+		Signal time(samples.size(), "time");
+		Signal frequency(samples.size(), "frequency");
+		Signal amplitude(samples.size(), "amplitude");
+		Signal phase(samples.size(), "phase");
+		for (size_t k = 0; k < samples.size(); k++) {
+			time[k] = samples[k].time;
+			frequency[k] = samples[k].frequency;
+			amplitude[k] = samples[k].amplitude;
+			phase[k] = samples[k].phase;
+		}
+		std::vector<Signal> sigOut1 = {time, frequency, amplitude, phase};
+		if (simulated != nullptr) {
+			sigOut1.push_back(resonance_frequency);
+		}
+		outFile1.writeSignals(sigOut1, false);
+
+		/* - - - - - - - - - - - - - - - - - - - - - - - */
+
+		std::cerr << "+--- Write descriptions file ---+" << std::endl;
+
+		std::ostringstream oss;
+
+		oss << "[program]" << std::endl;
+		oss << "type = module" << std::endl;
+		oss << "name = resonanceTracking" << std::endl;
+		oss << "simulate = " << getDevice().isSimulated() << std::endl;
+		oss << std::endl;
+		oss << "[parameters]" << std::endl;
+		oss << "# Acquisition parameters" << std::endl;
+		oss << "trigger_level = " << trigger_level << std::endl;
+		oss << "trigger_delay = " << trigger_delay << std::endl;
+		oss << "decimation = "			<< DECIMATION << std::endl;
+		oss << "buffsize = "			<< BUFFER_SIZE << std::endl;
+		oss << "dem_filter_freq = "		<< dem_filter_freq << std::endl;
+		oss << std::endl;
+		oss << "# Tracking parameters" << std::endl;
+		oss << "frequency = "			<< start_frequency << std::endl;
+		oss << "target_phase = "		<< target_phase << std::endl;
+		oss << "span = "				<< span << std::endl;
+		oss << "kp = "					<< kp << std::endl;
+		oss << "ki = "					<< ki << std::endl;
+		oss << "kd = "					<< kd << std::endl;
+		oss << "update_rate = "			<< update_rate << std::endl;
+		oss << "duration = "			<< duration << std::endl;
+		oss << "amplitude = "			<< output_amplitude << std::endl;
+		oss << std::endl;
+		oss << "[variables]" << std::endl;
+		oss << "samplig_frequency = " << SAMPLING_FREQUENCY << std::endl;
+		oss << std::endl;
+		oss << "[measures]" << std::endl;
+		if (measure_time) {
+			oss << "# Time in milliseconds" << std::endl;
+			oss << "update_time_max = " << update_timer.getMaxDuration() << std::endl;
+			oss << "update_time_min = " << update_timer.getMinDuration() << std::endl;
+		}
+		oss << "final_frequency = " << tracker.getFrequency() << std::endl;
+		oss << std::endl;
+		oss << "[files]" << std::endl;
+		oss << "file1 = " << filename1 << std::endl;
+		CSVFile::writeDescriptions(oss.str());
+
+		std::cerr << "+------------ END --------------+" << std::endl;
+
+		result = 0;
+	} catch (const std::exception &e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		result = 1;
+	}
+
+	getDevice().generator().disable();
 	releaseAcquisition();
-	rp_Release();
+	getDevice().close();
 
 	return result;
 }
\ No newline at end of file
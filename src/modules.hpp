@@ -11,4 +11,11 @@
  */
 int module_frequencyScanning(const std::vector<std::string> &args);
 
+/**
+ * @biref Module to follow a resonance with a phase-locked loop
+ * @param[in] args Arguments
+ * @note Write help message if the argument "help" is provided
+ */
+int module_resonanceTracking(const std::vector<std::string> &args);
+
 #endif // __MODULES_HPP
\ No newline at end of file
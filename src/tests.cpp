@@ -14,21 +14,23 @@
 #include <iostream>
 #include <iomanip>
 #include <time.h>
-#include "rp.h"
-#include "rp_hw-calib.h"
-#include "rp_hw-profiles.h"
 
 #include "Signal.hpp"
 #include "Spectrum.hpp"
 #include "Filter.hpp"
 #include "Demodulator.hpp"
+#include "DemodulatorBank.hpp"
 #include "PID.hpp"
 #include "CSVFile.hpp"
 #include "Noise.hpp"
 #include "Window.hpp"
+#include "Channelizer.hpp"
 #include "globals.hpp"
 #include "utils.hpp"
 #include "acquisition.hpp"
+#include "StreamAcquisition.hpp"
+#include "LockIn.hpp"
+#include "Timer.hpp"
 #include <stdexcept>
 
 int test_acquire(const std::vector<std::string> &args) {
@@ -148,7 +150,7 @@ int test_acquire(const std::vector<std::string> &args) {
 
 		/* - - - - - - - - - - - - - - - - - - - - - - - */
 		
-		if (rp_InitReset(true) != RP_OK) {
+		if (!getDevice().open()) {
 			throw std::runtime_error("Rp api init failed!");
 		}
 		
@@ -165,8 +167,6 @@ int test_acquire(const std::vector<std::string> &args) {
 		Signal output("output1(t)");
 		Signal input1("input1(t)");
 		Signal input2("input2(t)");
-		Signal windowedSignal1;
-		Signal windowedSignal2;
 		Spectrum spectrum1("INPUT1(f)");
 		Spectrum spectrum2("INPUT2(f)");
 
@@ -183,17 +183,17 @@ int test_acquire(const std::vector<std::string> &args) {
 
 		output.generateWaveform(waveform, amplitude, frequency, phase, offset, 0, duty_cycle*100);
 		
-		rp_GenReset();
-		rp_GenWaveform(RP_CH_1, waveform);
+		GeneratorBackend &generator = getDevice().generator();
+		generator.reset();
+		generator.setWaveform(waveform);
 
-		rp_GenFreq(RP_CH_1, frequency);
-		rp_GenAmp(RP_CH_1, amplitude);
-		rp_GenOffset(RP_CH_1, offset);
-		rp_GenPhase(RP_CH_1, phase);
-		rp_GenDutyCycle(RP_CH_1, duty_cycle);
+		generator.setFrequency(frequency);
+		generator.setAmplitude(amplitude);
+		generator.setOffset(offset);
+		generator.setPhase(phase);
+		generator.setDutyCycle(duty_cycle);
 
-		rp_GenOutEnable(RP_CH_1);
-		rp_GenTriggerOnly(RP_CH_1);
+		generator.enable();
 
 		/* - - - - - - - - - - - - - - - - - - - - - - - */
 
@@ -208,14 +208,9 @@ int test_acquire(const std::vector<std::string> &args) {
 
 		/* - - - - - - - - - - - - - - - - - - - - - - - */
 		
-		if (acquire_on_channel1) {
-			windowedSignal1 = window.apply(input1);
-			windowedSignal1.FFT(spectrum1);
-		}
-		if (acquire_on_channel2) {
-			windowedSignal2 = window.apply(input2);
-			windowedSignal2.FFT(spectrum2);
-		}
+		// fenêtrage effectué pendant le chargement de la FFT
+		if (acquire_on_channel1) input1.FFT(spectrum1, window);
+		if (acquire_on_channel2) input2.FFT(spectrum2, window);
 		std::cerr << "FFT successful" << std::endl;
 
 		/* - - - - - - - - - - - - - - - - - - - - - - - */
@@ -271,7 +266,7 @@ int test_acquire(const std::vector<std::string> &args) {
 		CSVFile::writeDescriptions(oss.str());
 		
 		releaseAcquisition();
-		rp_Release();
+		getDevice().close();
 		
 		std::cerr << "+------------ END --------------+" << std::endl;
 
@@ -302,6 +297,7 @@ int test_spectrum(const std::vector<std::string> &args)
 		int points_per_period = 100;
 		float  trigger_level = 0.01f;
 		int32_t trigger_delay = BUFFER_SIZE/2;
+		size_t channels = 0;
 
 		if (args.size() >= 1) {
 			for (auto param : args) {
@@ -339,6 +335,9 @@ int test_spectrum(const std::vector<std::string> &args)
 					std::cerr << "  trigger_delay=<integer>; trd=<integer>" << std::endl;
 					std::cerr << "      note: Enter the trigger delay in sample index." << std::endl;
 					std::cerr << "            This argument is optional, and if not entered, the default value is " << trigger_delay << "." << std::endl;
+					std::cerr << "  channels=<integer>; ch=<integer>" << std::endl;
+					std::cerr << "      note: Number of subbands of the polyphase channelizer (power of two)." << std::endl;
+					std::cerr << "            This argument is optional, and if not entered, the signal is not channelized." << std::endl;
 					return 0;
 				} else {
 					// Parse other arguments
@@ -384,6 +383,8 @@ int test_spectrum(const std::vector<std::string> &args)
 							trigger_level = std::stof(value);
 						} else if (name == "trigger_delay" || name == "trd") {
 							trigger_delay = std::stoi(value);
+						} else if (name == "channels" || name == "ch") {
+							channels = convertToInteger(value);
 						} else {
 							std::cerr << "Invalid argument format: " << param << std::endl;
 							return 1;
@@ -407,8 +408,8 @@ int test_spectrum(const std::vector<std::string> &args)
 			}
 		}
 
-		/* Print error, if rp_Init() function failed */
-		if (rp_InitReset(true) != RP_OK) {
+		/* Print error, if the initialization of the card failed */
+		if (!getDevice().open()) {
 			throw std::runtime_error("Rp api init failed!");
 		}
 		initAcquisition(trigger_level, trigger_delay);
@@ -427,7 +428,6 @@ int test_spectrum(const std::vector<std::string> &args)
 		/* - - - - - - - - - - - - - - - - - - - - - - - */
 
 		Signal signal("signal(t)");
-		Signal windowedSignal;
 		Spectrum spectrum("spectrum(f)");
 
 		/* - - - - - - - - - - - - - - - - - - - - - - - */
@@ -443,28 +443,74 @@ int test_spectrum(const std::vector<std::string> &args)
 		/* - - - - - - - - - - - - - - - - - - - - - - - */
 		/* Configuration du générateur de tension arbitraire */
 
-		rp_GenReset();
-		rp_GenWaveform(RP_CH_1, RP_WAVEFORM_ARBITRARY);
-		rp_GenArbWaveform(RP_CH_1, waveform.data(), BUFFER_SIZE);
-		rp_GenFreq(RP_CH_1, fundamental_frequency);
-		rp_GenAmp(RP_CH_1, 1.0f);
-		rp_GenOffset(RP_CH_1, offset);
-		rp_GenPhase(RP_CH_1, phase);
+		GeneratorBackend &generator = getDevice().generator();
+		generator.reset();
+		generator.setWaveform(RP_WAVEFORM_ARBITRARY);
+		generator.setArbitraryWaveform(waveform.data(), BUFFER_SIZE);
+		generator.setFrequency(fundamental_frequency);
+		generator.setAmplitude(1.0f);
+		generator.setOffset(offset);
+		generator.setPhase(phase);
 		
-		rp_GenOutEnable(RP_CH_1);
-		rp_GenTriggerOnly(RP_CH_1);
+		generator.enable();
 		
 		/* - - - - - - - - - - - - - - - - - - - - - - - */
 		/* Echantillonnage du signal */
 		acquisitionChannel1(signal);
 		std::cerr << "Acquisition successful" << std::endl;
-		windowedSignal = window.apply(signal);
 
 		/* Calcul des transformées de fourier discrètes des signaux avec BUFFER_SIZE zero padding */
+		/* (le fenêtrage est effectué pendant le chargement de la FFT) */
 		
-		windowedSignal.FFT(spectrum);
+		signal.FFT(spectrum, window);
 		std::cerr << "FFT calculation successful" << std::endl;
 
+		/* Découpage en sous-bandes : amplitude moyenne de chaque voie */
+		if (channels > 0) {
+			Channelizer channelizer;
+			if (!channelizer.set(channels)) {
+				std::cerr << "Error: Unable to set the channelizer." << std::endl;
+				return 1;
+			}
+			channelizer.setup();
+			std::vector<std::vector<complexd>> streams = channelizer.apply(signal);
+			size_t transient = channelizer.getPrototype().size() / channelizer.getDecimation() + 1;
+			for (size_t k = 0; k < streams.size(); k++) {
+				double power = 0.0;
+				size_t count = 0;
+				for (size_t m = transient; m < streams[k].size(); m++, count++) {
+					power += std::norm(streams[k][m]);
+				}
+				// une sinusoïde réelle d'amplitude A donne A/2 dans sa voie
+				double amplitude = (count > 0) ? 2.0 * std::sqrt(power / count) : 0.0;
+				std::cerr << "Channel " << k << " (" << channelizer.getChannelFrequency(k, SAMPLING_FREQUENCY) << " Hz): amplitude " << amplitude << std::endl;
+			}
+		}
+
+		/* Amplitude et phase de chaque raie générée, en une seule passe */
+		{
+			std::vector<double> tones(frequencies.begin(), frequencies.end());
+			std::vector<double> sorted = tones;
+			std::sort(sorted.begin(), sorted.end());
+			double spacing = sorted[0];
+			for (size_t k = 1; k < sorted.size(); k++) {
+				spacing = std::min(spacing, sorted[k] - sorted[k-1]);
+			}
+			DemodulatorBank bank;
+			if (spacing > 0.0 && bank.set(tones, spacing / 10.0, 16)) {
+				bank.setup();
+				std::vector<Signal> tone_amplitudes, tone_phases;
+				bank.apply(signal, tone_amplitudes, tone_phases);
+				// moyenne sur la seconde moitié, après le régime transitoire du filtre
+				for (size_t k = 0; k < tones.size(); k++) {
+					size_t half = tone_amplitudes[k].size() / 2;
+					double amplitude = tone_amplitudes[k].mean(half);
+					double tone_phase = tone_phases[k].mean(half);
+					std::cerr << "Tone " << tones[k] << " Hz: amplitude " << amplitude << ", phase " << tone_phase << " rad" << std::endl;
+				}
+			}
+		}
+
 		/* - - - - - - - - - - - - - - - - - - - - - - - */
 		/* Sauvgarde des résultats */
 
@@ -523,7 +569,7 @@ int test_spectrum(const std::vector<std::string> &args)
 		CSVFile::writeDescriptions(oss.str());
 
 		releaseAcquisition();
-		rp_Release();
+		getDevice().close();
 		
 		std::cerr << "+------------ END --------------+" << std::endl;
 
@@ -560,6 +606,7 @@ int test_demodulation(const std::vector<std::string> &args) {
 		bool acquire_on_channel2 = false;
 		float  trigger_level = 0.01f;
 		int32_t trigger_delay = BUFFER_SIZE/2;
+		int harmonics = 0;
 		
 		if (args.size() >= 1) {
 			for (auto param : args) {
@@ -603,6 +650,9 @@ int test_demodulation(const std::vector<std::string> &args) {
 					std::cerr << "  trigger_delay=<integer>; trd=<integer>" << std::endl;
 					std::cerr << "      note: Enter the trigger delay in sample index." << std::endl;
 					std::cerr << "            This argument is optional, and if not entered, the default value is " << trigger_delay << "." << std::endl;
+					std::cerr << "  harmonics=<integer>; hm=<integer>" << std::endl;
+					std::cerr << "      note: Number of harmonics of the oscillator frequency measured on channel 1, with their THD." << std::endl;
+					std::cerr << "            This argument is optional, and if not entered, the harmonics are not measured." << std::endl;
 					return 0;
 				} else {
 					// Parse other arguments
@@ -654,6 +704,8 @@ int test_demodulation(const std::vector<std::string> &args) {
 							trigger_level = std::stof(value);
 						} else if (name == "trigger_delay" || name == "trd") {
 							trigger_delay = std::stoi(value);
+						} else if (name == "harmonics" || name == "hm") {
+							harmonics = convertToInteger(value);
 						} else {
 							std::cerr << "Invalid argument: " << param << std::endl;
 							return 1;
@@ -674,8 +726,8 @@ int test_demodulation(const std::vector<std::string> &args) {
 			return 1;
 		}
 
-		/* Print error, if rp_Init() function failed */
-		if (rp_InitReset(true) != RP_OK) {
+		/* Print error, if the initialization of the card failed */
+		if (!getDevice().open()) {
 			throw std::runtime_error("Rp api init failed!");
 		}
 		initAcquisition(trigger_level, trigger_delay);
@@ -704,8 +756,6 @@ int test_demodulation(const std::vector<std::string> &args) {
 
 		Signal signal1("signal1(t)");
 		Signal signal2("signal2(t)");
-		Signal windowedSignal1;
-		Signal windowedSignal2;
 		Signal signal_demAmpli1("amplitude1(t)");
 		Signal signal_demAmpli2("amplitude2(t)");
 		Signal signal_demPhase1("phase1(t)");
@@ -733,16 +783,16 @@ int test_demodulation(const std::vector<std::string> &args) {
 		/* - - - - - - - - - - - - - - - - - - - - - - - */
 		/* Configuration du générateur de tension arbitraire */
 
-		rp_GenReset();
-		rp_GenWaveform(RP_CH_1, RP_WAVEFORM_ARBITRARY);
-		rp_GenArbWaveform(RP_CH_1, waveform.data(), BUFFER_SIZE);
-		rp_GenFreq(RP_CH_1, fundamental_frequency);
-		rp_GenAmp(RP_CH_1, 1.0f);
-		rp_GenOffset(RP_CH_1, offset);
-		rp_GenPhase(RP_CH_1, phase);
+		GeneratorBackend &generator = getDevice().generator();
+		generator.reset();
+		generator.setWaveform(RP_WAVEFORM_ARBITRARY);
+		generator.setArbitraryWaveform(waveform.data(), BUFFER_SIZE);
+		generator.setFrequency(fundamental_frequency);
+		generator.setAmplitude(1.0f);
+		generator.setOffset(offset);
+		generator.setPhase(phase);
 		
-		rp_GenOutEnable(RP_CH_1);
-		rp_GenTriggerOnly(RP_CH_1);
+		generator.enable();
 		
 		/* - - - - - - - - - - - - - - - - - - - - - - - */
 		/* Echantillonnage du signal */
@@ -752,9 +802,6 @@ int test_demodulation(const std::vector<std::string> &args) {
 		else acquisitionChannels1_2(signal1, signal2, RP_T_CH_2);
 		std::cerr << "Acqusition successful" << std::endl;
 		
-		if (acquire_on_channel1) windowedSignal1 = window.apply(signal1);
-		if (acquire_on_channel2) windowedSignal2 = window.apply(signal2);
-		
 		/* - - - - - - - - - - - - - - - - - - - - - - - */
 		/* Démodulation du signal */
 		
@@ -762,11 +809,30 @@ int test_demodulation(const std::vector<std::string> &args) {
 		if (acquire_on_channel2) dem.apply(signal2, signal_demAmpli2, signal_demPhase2, true);
 		std::cerr << "Demodulation successful" << std::endl;
 
+		/* Harmoniques de la fréquence de l'oscillateur, en une seule passe */
+		if (acquire_on_channel1 && harmonics > 0) {
+			std::vector<int> orders(harmonics);
+			std::iota(orders.begin(), orders.end(), 1);
+			DemodulatorBank harmonic_dem;
+			if (harmonic_dem.setHarmonics(freq_oscillator, orders, dem_filter_freq)) {
+				harmonic_dem.setup();
+				std::vector<Signal> harmonic_amplitudes, harmonic_phases;
+				harmonic_dem.apply(signal1, harmonic_amplitudes, harmonic_phases, true);
+				size_t steady = BUFFER_SIZE / 2;
+				for (size_t k = 0; k < harmonic_amplitudes.size(); k++) {
+					std::cerr << "Harmonic " << orders[k] << " (" << orders[k] * freq_oscillator << " Hz): amplitude " << harmonic_amplitudes[k].mean(steady) << std::endl;
+				}
+				std::cerr << "THD: " << 100.0 * harmonic_dem.getTHD(harmonic_amplitudes, steady) << " %" << std::endl;
+			} else {
+				std::cerr << "Harmonics not measured" << std::endl;
+			}
+		}
+
 		/* - - - - - - - - - - - - - - - - - - - - - - - */
 		/* Calcul des transformées de fourier discrètes des signaux avec BUFFER_SIZE zero padding */
 		
-		if (acquire_on_channel1) windowedSignal1.FFT(spectrum1);
-		if (acquire_on_channel2) windowedSignal2.FFT(spectrum2);
+		if (acquire_on_channel1) signal1.FFT(spectrum1, window);
+		if (acquire_on_channel2) signal2.FFT(spectrum2, window);
 
 		std::cerr << "Calculation fft signals successful" << std::endl;
 		
@@ -865,7 +931,7 @@ int test_demodulation(const std::vector<std::string> &args) {
 		result = 1;
 	}
 	releaseAcquisition();
-	rp_Release();
+	getDevice().close();
 	return result;
 }
 
@@ -980,8 +1046,8 @@ int test_demodulation2(const std::vector<std::string> &args) {
 			}
 		}
 
-		/* Print error, if rp_Init() function failed */
-		if (rp_InitReset(true) != RP_OK) {
+		/* Print error, if the initialization of the card failed */
+		if (!getDevice().open()) {
 			std::runtime_error("Rp api init failed!");
 		}
 		initAcquisition();
@@ -1041,16 +1107,16 @@ int test_demodulation2(const std::vector<std::string> &args) {
 			int fundamental_frequency;
 			std::vector<float> waveform = generate_waveform_with_n_sinus(BUFFER_SIZE, freqs, amps, fundamental_frequency);
 			
-			rp_GenReset();
-			rp_GenWaveform(RP_CH_1, RP_WAVEFORM_ARBITRARY);
-			rp_GenArbWaveform(RP_CH_1, waveform.data(), BUFFER_SIZE);
-			rp_GenFreq(RP_CH_1, fundamental_frequency);
-			rp_GenAmp(RP_CH_1, 1.0f);
-			rp_GenOffset(RP_CH_1, offset);
-			rp_GenPhase(RP_CH_1, phase);
+			GeneratorBackend &generator = getDevice().generator();
+			generator.reset();
+			generator.setWaveform(RP_WAVEFORM_ARBITRARY);
+			generator.setArbitraryWaveform(waveform.data(), BUFFER_SIZE);
+			generator.setFrequency(fundamental_frequency);
+			generator.setAmplitude(1.0f);
+			generator.setOffset(offset);
+			generator.setPhase(phase);
 			
-			rp_GenOutEnable(RP_CH_1);
-			rp_GenTriggerOnly(RP_CH_1);
+			generator.enable();
 			
 			/* - - - - - - - - - - - - - - - - - - - - - - - */
 			/* Echantillonnage du signal */
@@ -1174,7 +1240,7 @@ int test_demodulation2(const std::vector<std::string> &args) {
 	}
 
 	releaseAcquisition();
-	rp_Release();
+	getDevice().close();
 	return result;
 }
 
@@ -1264,8 +1330,8 @@ int test_realTimeAcquisition(const std::vector<std::string> &args) {
 			}
 		}
 		
-		/* Print error, if rp_Init() function failed */
-		if (rp_InitReset(true) != RP_OK) {
+		/* Print error, if the initialization of the card failed */
+		if (!getDevice().open()) {
 			throw std::runtime_error("Rp api init failed!");
 		}
 
@@ -1275,39 +1341,28 @@ int test_realTimeAcquisition(const std::vector<std::string> &args) {
 		Signal signal("output");
 		Signal loop_axis(0, "loop_axis");
 		Signal elapsedTimesBuffer(0, "elapsed_time");
-		buffers_t *b = rp_createBuffer(2,BUFFER_SIZE,false,false,true);
 
 		/* - - - - - - - - - - - - - - - - - - - - - - - */
 		/* Initialisation du signal */
 		
 		/* Generating frequency */
-		rp_GenWaveform(RP_CH_1, RP_WAVEFORM_SINE);
+		GeneratorBackend &generator = getDevice().generator();
+		generator.setWaveform(RP_WAVEFORM_SINE);
 
-		rp_GenFreq(RP_CH_1, frequency);
-		rp_GenAmp(RP_CH_1, amplitude);
-		rp_GenOffset(RP_CH_1, offset);
-		rp_GenPhase(RP_CH_1, phase);
-		rp_GenSetInitGenValue(RP_CH_1, 0.0);
+		generator.setFrequency(frequency);
+		generator.setAmplitude(amplitude);
+		generator.setOffset(offset);
+		generator.setPhase(phase);
 
-		rp_GenOutEnable(RP_CH_1);
-		rp_GenTriggerOnly(RP_CH_1);
+		generator.enable();
 
 		/* - - - - - - - - - - - - - - - - - - - - - - - */
 		/* Initialisation de l'acquisition */
 
 		std::cerr << "" << std::endl;
 
-		rp_AcqReset();
-		rp_AcqSetDecimationFactor(DECIMATION);
-		rp_AcqSetTriggerLevel(RP_T_CH_1, 0.01);
-		rp_AcqSetTriggerDelay(ADC_BUFFER_SIZE/2.0);
-
-		int timeDelay = getTimeDelay(DECIMATION);
-		uint32_t c;
-		int rateCounter = 5; /* smaling rate counter */
-		rp_acq_trig_state_t state = RP_TRIG_STATE_TRIGGERED;
-		bool fillState = false;
-
+		AcquisitionBackend &acquisition = getDevice().acquisition();
+		acquisition.init(0.01f, ADC_BUFFER_SIZE/2);
 
 		clock_t cpuclock;
 		float elapsedTime;
@@ -1315,45 +1370,14 @@ int test_realTimeAcquisition(const std::vector<std::string> &args) {
 		for (int loop = 0; loop < nb_loop; loop++) {
 			std::cerr << "\rLoop :" << std::setw(17) << loop << "/" << nb_loop  << std::flush;
 			/* Echantillonnage du signal */
-			fillState = false;
 
 			// get initial time-stamp
 			cpuclock = clock();
 
-			rp_AcqStart();
-			rp_AcqSetTriggerSrc(RP_TRIG_SRC_NOW);
-
-			/*length and smaling rate*/
-			for (int z = 0; z < rateCounter; z++){
-				rp_AcqGetPreTriggerCounter(&c);
-				usleep(timeDelay);
-				//std::cerr << "Pre counter " << c << std::endl;
-			}
-
-			while(1) {
-				rp_AcqGetTriggerState(&state);
-				if(state == RP_TRIG_STATE_TRIGGERED) {
-					break;
-				} else {
-					usleep(1);
-				}
-			}
-			while(!fillState){
-				rp_AcqGetBufferFillState(&fillState);
-			}
-
-			rp_AcqStop();
+			acquisition.acquire(&signal, nullptr, RP_TRIG_SRC_NOW);
 
 			// get final time-stamp
 			cpuclock = clock() - cpuclock;
-
-			uint32_t pos = 0;
-			rp_AcqGetWritePointerAtTrig(&pos);
-
-			rp_AcqGetData(pos, b);
-
-			/* Enrgistrement du buffer */
-			for (size_t i = 0; i < BUFFER_SIZE; i++) signal[i] = b->ch_f[0][i];
 			
 			loop_axis.push_back(loop);
 			elapsedTime = ((float)cpuclock)/(CLOCKS_PER_SEC / 1000); // calculate the elapsed time in ms
@@ -1361,7 +1385,7 @@ int test_realTimeAcquisition(const std::vector<std::string> &args) {
 		}
 
 		/* Releasing resources */
-		rp_deleteBuffer(b);
+		acquisition.release();
 		
 		/* - - - - - - - - - - - - - - - - - - - - - - - */
 
@@ -1404,7 +1428,7 @@ int test_realTimeAcquisition(const std::vector<std::string> &args) {
 		std::cerr << "Exception: " << e.what() << std::endl;
 		result = 1;
 	}
-	rp_Release();
+	getDevice().close();
 	return result;
 }
 
@@ -1497,95 +1521,53 @@ int test_realTimeAcquisition2(const std::vector<std::string> &args) {
 		Signal elapsedTimesBuffer(0, "elapsed_time");
 		
 		for (int loop = 0; loop < nb_loop; loop++) {
-			if (rp_InitReset(true) != RP_OK) {
+			if (!getDevice().open()) {
 				throw std::runtime_error("Rp api init failed!");
 			}
 
-			buffers_t *b = rp_createBuffer(2,BUFFER_SIZE,false,false,true);
 
 			/* - - - - - - - - - - - - - - - - - - - - - - - */
 			/* Initialisation du signal */
 			
 			/* Generating frequency */
-			rp_GenWaveform(RP_CH_1, RP_WAVEFORM_SINE);
+			GeneratorBackend &generator = getDevice().generator();
+			generator.setWaveform(RP_WAVEFORM_SINE);
 
-			rp_GenFreq(RP_CH_1, frequency);
-			rp_GenAmp(RP_CH_1, amplitude);
-			rp_GenOffset(RP_CH_1, offset);
-			rp_GenPhase(RP_CH_1, phase);
-			rp_GenSetInitGenValue(RP_CH_1, 0.0);
+			generator.setFrequency(frequency);
+			generator.setAmplitude(amplitude);
+			generator.setOffset(offset);
+			generator.setPhase(phase);
 
-			rp_GenOutEnable(RP_CH_1);
-			rp_GenTriggerOnly(RP_CH_1);
+			generator.enable();
 
 			/* - - - - - - - - - - - - - - - - - - - - - - - */
 			/* Initialisation de l'acquisition */
 
-			rp_AcqReset();
-			rp_AcqSetDecimationFactor(DECIMATION);
-			rp_AcqSetTriggerLevel(RP_T_CH_1, 0.01);
-			rp_AcqSetTriggerDelay(ADC_BUFFER_SIZE/2.0);
-
-			int timeDelay = getTimeDelay(DECIMATION);
-			uint32_t c;
-			int rateCounter = 5; /* smaling rate counter */
-			rp_acq_trig_state_t state = RP_TRIG_STATE_TRIGGERED;
-			bool fillState = false;
-
+			AcquisitionBackend &acquisition = getDevice().acquisition();
+			acquisition.init(0.01f, ADC_BUFFER_SIZE/2);
 
 			clock_t cpuclock;
 			float elapsedTime;
 		
 			std::cerr << "\rLoop :" << std::setw(17) << loop << "/" << nb_loop  << std::flush;
 			/* Echantillonnage du signal */
-			fillState = false;
 
 			// get initial time-stamp
 			cpuclock = clock();
 
-			rp_AcqStart();
-			rp_AcqSetTriggerSrc(RP_TRIG_SRC_NOW);
-
-			/*length and smaling rate*/
-			for (int z = 0; z < rateCounter; z++){
-				rp_AcqGetPreTriggerCounter(&c);
-				usleep(timeDelay);
-				//std::cerr << "Pre counter " << c << std::endl;
-			}
-
-			while(1) {
-				rp_AcqGetTriggerState(&state);
-				if(state == RP_TRIG_STATE_TRIGGERED) {
-					break;
-				} else {
-					usleep(1);
-				}
-			}
-			while(!fillState){
-				rp_AcqGetBufferFillState(&fillState);
-			}
-
-			rp_AcqStop();
+			acquisition.acquire(&signal, nullptr, RP_TRIG_SRC_NOW);
 
 			// get final time-stamp
 			cpuclock = clock() - cpuclock;
-
-			uint32_t pos = 0;
-			rp_AcqGetWritePointerAtTrig(&pos);
-
-			rp_AcqGetData(pos, b);
-			
-			/* Enrgistrement du buffer */
-			for (size_t i = 0; i < BUFFER_SIZE; i++) signal[i] = b->ch_f[0][i];
 			
 			loop_axis.push_back(loop);
 			elapsedTime = ((float)cpuclock)/(CLOCKS_PER_SEC / 1000); // calculate the elapsed time in ms
 			elapsedTimesBuffer.push_back(elapsedTime);
 
 			/* Releasing resources */
-			rp_deleteBuffer(b);
+			acquisition.release();
 
-			rp_Release();
+			getDevice().close();
 		}
 		
 		/* - - - - - - - - - - - - - - - - - - - - - - - */
@@ -1632,3 +1614,230 @@ int test_realTimeAcquisition2(const std::vector<std::string> &args) {
 	return result;
 }
 
+int test_streamAcquisition(const std::vector<std::string> &args) {
+	int result;
+
+	try {
+		SetDecimation(64);
+
+		double frequency   = 10e3;
+		float  amplitude   = 1.0f;
+		size_t frame_size  = 4096;
+		size_t ring_size   = 1 << 18;
+		double duration    = 1.0;
+		double bandwidth   = 100;
+		double output_rate = 1000;
+		int    process_time = 0;
+		bool   measure_time = false;
+
+		if (args.size() >= 1) {
+			for (auto param : args) {
+
+				// Vérifier si l'argument est "help"
+				if (param == "help") {
+					std::cerr << "\033[4;0mHelp message\033[0m" << std::endl;
+					std::cerr << "Details:" << std::endl;
+					std::cerr << "  This application streams analog inputs 1 and 2 without gaps through the DMA ring," << std::endl;
+					std::cerr << "  while a sine is generated on analog output 1. Each frame feeds a lock-in per input," << std::endl;
+					std::cerr << "  and the gain and phase of input 2 relative to input 1 are written to a csv file," << std::endl;
+					std::cerr << "  with the overruns and the dropped samples of the stream." << std::endl;
+					std::cerr << "Possibilities of utilisation : " << std::endl;
+					std::cerr << "  frequency=<value>; f=<value>" << std::endl;
+					std::cerr << "      note: this argument is optional, and if not entered, the default value is " << frequency << "." << std::endl;
+					std::cerr << "  amplitude=<value>; a=<value>" << std::endl;
+					std::cerr << "      note: this argument is optional, and if not entered, the default value is " << amplitude << "." << std::endl;
+					std::cerr << "  decimation=<integer>; dec=<integer>" << std::endl;
+					std::cerr << "      note: this argument is optional, and if not entered, the default value is " << DECIMATION << "." << std::endl;
+					std::cerr << "  frame_size=<integer>; frs=<integer>" << std::endl;
+					std::cerr << "      details : number of samples handed to the lock-ins at once" << std::endl;
+					std::cerr << "      note: this argument is optional, and if not entered, the default value is " << frame_size << "." << std::endl;
+					std::cerr << "  ring_size=<integer>; rs=<integer>" << std::endl;
+					std::cerr << "      details : requested size of the DMA ring, limited by the memory reserved for the DMA" << std::endl;
+					std::cerr << "      note: this argument is optional, and if not entered, the default value is " << ring_size << "." << std::endl;
+					std::cerr << "  duration=<value>; d=<value>" << std::endl;
+					std::cerr << "      details : duration of the stream, in seconds" << std::endl;
+					std::cerr << "      note: this argument is optional, and if not entered, the default value is " << duration << "." << std::endl;
+					std::cerr << "  bandwidth=<value>; bw=<value>" << std::endl;
+					std::cerr << "      note: this argument is optional, and if not entered, the default value is " << bandwidth << "." << std::endl;
+					std::cerr << "  output_rate=<value>; or=<value>" << std::endl;
+					std::cerr << "      details : rounded to the sampling frequency divided by an integer" << std::endl;
+					std::cerr << "      note: this argument is optional, and if not entered, the default value is " << output_rate << "." << std::endl;
+					std::cerr << "  process_time=<integer>; pt=<integer>" << std::endl;
+					std::cerr << "      details : extra time spent on each frame, in microseconds, to emulate a slow consumer" << std::endl;
+					std::cerr << "      note: this argument is optional, and if not entered, the default value is " << process_time << "." << std::endl;
+					std::cerr << "  measure_time=<boolean>" << std::endl;
+					std::cerr << "      note: this argument is optional, and if not entered, the default value is " << measure_time << "." << std::endl;
+					return 0;
+				} else {
+					// Parse other arguments
+					size_t pos = param.find('=');
+					if (pos != std::string::npos) {
+						std::string name = param.substr(0, pos);
+						std::string value = param.substr(pos + 1);
+
+						if (name == "frequency" || name == "f") {
+							frequency = std::stod(value);
+						} else if (name == "amplitude" || name == "a") {
+							amplitude = std::stof(value);
+						} else if (name == "decimation" || name == "dec") {
+							SetDecimation(std::stoi(value));
+						} else if (name == "frame_size" || name == "frs") {
+							frame_size = std::abs(convertToInteger(value));
+						} else if (name == "ring_size" || name == "rs") {
+							ring_size = std::abs(convertToInteger(value));
+						} else if (name == "duration" || name == "d") {
+							duration = std::abs(std::stod(value));
+						} else if (name == "bandwidth" || name == "bw") {
+							bandwidth = std::stod(value);
+						} else if (name == "output_rate" || name == "or") {
+							output_rate = std::stod(value);
+						} else if (name == "process_time" || name == "pt") {
+							process_time = std::abs(convertToInteger(value));
+						} else if (name == "measure_time") {
+							measure_time = stringToBool(value);
+						} else {
+							std::cerr << "Invalid argument format: " << param << std::endl;
+							return 1;
+						}
+					} else {
+						std::cerr << "Invalid argument format: " << param << std::endl;
+						return 1;
+					}
+				}
+			}
+		}
+
+		/* - - - - - - - - - - - - - - - - - - - - - - - */
+
+		StreamAcquisition stream;
+		if (!stream.set(frame_size, ring_size)) {
+			throw std::runtime_error("Unable to set the stream acquisition.");
+		}
+
+		// débit de sortie ramené à un sous-multiple de la fréquence d'échantillonnage
+		output_rate = SAMPLING_FREQUENCY / std::max(1.0, std::round(SAMPLING_FREQUENCY / output_rate));
+
+		// une détection synchrone par entrée, le rapport des deux ne dépend pas de la phase de l'oscillateur
+		const size_t capacity = static_cast<size_t>(std::ceil(duration * output_rate)) + 1;
+		LockIn lockin1, lockin2;
+		if (!lockin1.set(frequency, bandwidth, output_rate, 4, 0.0, capacity) || !lockin2.set(frequency, bandwidth, output_rate, 4, 0.0, capacity)) {
+			throw std::runtime_error("Unable to set the lock-in.");
+		}
+		lockin1.setup();
+		lockin2.setup();
+
+		if (!getDevice().open()) {
+			throw std::runtime_error("Rp api init failed!");
+		}
+
+		GeneratorBackend &generator = getDevice().generator();
+		generator.reset();
+		generator.setWaveform(RP_WAVEFORM_SINE);
+		generator.setFrequency(frequency);
+		generator.setAmplitude(amplitude);
+		generator.enable();
+
+		std::cerr << "+----------- START -------------+" << std::endl;
+
+		Signal time(0, "time");
+		Signal amplitude1(0, "amplitude1");
+		Signal amplitude2(0, "amplitude2");
+		Signal gain(0, "gain");
+		Signal phase(0, "phase");
+
+		Timer process_timer;
+		uint64_t dropped = 0;
+
+		stream.start();
+		StreamFrame frame;
+		for (;;) {
+			if (!stream.next(frame)) {
+				throw std::runtime_error("No frame from the stream before the timeout.");
+			}
+			dropped += frame.dropped;
+
+			if (measure_time) process_timer.start();
+			lockin1.process(frame.channel1, frame.size);
+			lockin2.process(frame.channel2, frame.size);
+			if (measure_time) process_timer.stop();
+
+			if (process_time > 0) {
+				getDevice().wait(process_time * 1e-6);
+			}
+
+			// les sorties sont datées sur le flux, échantillons perdus compris
+			LockInSample out1, out2;
+			while (lockin1.getOutputs().pop(out1) && lockin2.getOutputs().pop(out2)) {
+				std::complex<double> ratio = std::complex<double>(out2.X, out2.Y) / std::complex<double>(out1.X, out1.Y);
+				time.push_back(out1.time + static_cast<double>(dropped) / stream.getSamplingFrequency());
+				amplitude1.push_back(out1.R);
+				amplitude2.push_back(out2.R);
+				gain.push_back(std::abs(ratio));
+				phase.push_back(std::arg(ratio));
+			}
+
+			double end = frame.time + static_cast<double>(frame.size) / stream.getSamplingFrequency();
+			std::cerr << "\rt = " << end << " s, frames " << stream.getFrames() << ", overruns " << stream.getOverruns() << ", dropped " << stream.getDroppedSamples() << "    " << std::flush;
+			if (end >= duration) {
+				break;
+			}
+		}
+		stream.stop();
+		std::cerr << "\n";
+
+		/* - - - - - - - - - - - - - - - - - - - - - - - */
+
+		std::cerr << "Write results in csv files" << std::endl;
+
+		CSVFile::setTimeToFilepath();
+		std::string filename1 = "stream.csv";
+		CSVFile outFile1(filename1);
+		std::vector<Signal> outSig = {time, amplitude1, amplitude2, gain, phase};
+		outFile1.writeSignals(outSig, false);
+
+		/* - - - - - - - - - - - - - - - - - - - - - - - */
+
+		std::cerr << "Write descriptions file" << std::endl;
+
+		std::ostringstream oss;
+
+		oss << "[program]" << std::endl;
+		oss << "type = test" << std::endl;
+		oss << "name = streamAcquisition" << std::endl;
+		oss << "[parameters]" << std::endl;
+		oss << "frequency = "			<< frequency << std::endl;
+		oss << "amplitude = "			<< amplitude << std::endl;
+		oss << "decimation = "			<< DECIMATION << std::endl;
+		oss << "frame_size = "			<< frame_size << std::endl;
+		oss << "ring_size = "			<< stream.getRingSize() << std::endl;
+		oss << "duration = "			<< duration << std::endl;
+		oss << "bandwidth = "			<< bandwidth << std::endl;
+		oss << "output_rate = "			<< output_rate << std::endl;
+		oss << "process_time = "		<< process_time << std::endl;
+		oss << "[variables]" << std::endl;
+		oss << "samplig_frequency = "	<< stream.getSamplingFrequency() << std::endl;
+		oss << "[measures]" << std::endl;
+		oss << "frames = "				<< stream.getFrames() << std::endl;
+		oss << "overruns = "			<< stream.getOverruns() << std::endl;
+		oss << "dropped_samples = "		<< stream.getDroppedSamples() << std::endl;
+		if (measure_time) {
+			oss << "# Time in milliseconds" << std::endl;
+			oss << "process_time_max = " << process_timer.getMaxDuration() << std::endl;
+			oss << "process_time_min = " << process_timer.getMinDuration() << std::endl;
+		}
+		oss << "[files]" << std::endl;
+		oss << "file1 = " << filename1 << std::endl;
+		CSVFile::writeDescriptions(oss.str());
+
+		std::cerr << "+------------ END --------------+" << std::endl;
+
+		result = 0;
+	} catch (const std::exception &e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		result = 1;
+	}
+
+	getDevice().generator().disable();
+	getDevice().close();
+	return result;
+}
@@ -45,4 +45,11 @@ int test_realTimeAcquisition(const std::vector<std::string> &args);
  */
 int test_realTimeAcquisition2(const std::vector<std::string> &args);
 
+/**
+ * @brief Test the gap-free acquisition through the DMA ring
+ * @param[in] args Arguments
+ * @note Write help message if the argument "help" is provided
+ */
+int test_streamAcquisition(const std::vector<std::string> &args);
+
 #endif // __TEST_HPP
\ No newline at end of file
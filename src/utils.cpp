@@ -12,8 +12,6 @@
 #include <iostream>
 #include <iomanip>
 #include <time.h>
-#include "rp_hw-calib.h"
-#include "rp_hw-profiles.h"
 
 double modulo(double value, double modulo) {
     // Utiliser fmod pour trouver le reste de value / modulo
@@ -170,6 +168,44 @@ std::string windowTypeToString(WindowType type) {
 	}
 }
 
+MovingFilterType stringToMovingFilterType(const std::string &str) {
+	MovingFilterType type = MovingFilterType::MEAN;
+	std::string _str = toLower(str);
+	if (_str == "mean" || _str == "average") {
+		type = MovingFilterType::MEAN;
+	} else if (_str == "ema" || _str == "exponential") {
+		type = MovingFilterType::EMA;
+	} else if (_str == "median") {
+		type = MovingFilterType::MEDIAN;
+	} else if (_str == "min" || _str == "minimum") {
+		type = MovingFilterType::MINIMUM;
+	} else if (_str == "max" || _str == "maximum") {
+		type = MovingFilterType::MAXIMUM;
+	} else if (_str == "variance") {
+		type = MovingFilterType::VARIANCE;
+	}
+	return type;
+}
+
+std::string movingFilterTypeToString(MovingFilterType type) {
+	switch (type) {
+		case MovingFilterType::MEAN:
+			return "Mean";
+		case MovingFilterType::EMA:
+			return "EMA";
+		case MovingFilterType::MEDIAN:
+			return "Median";
+		case MovingFilterType::MINIMUM:
+			return "Minimum";
+		case MovingFilterType::MAXIMUM:
+			return "Maximum";
+		case MovingFilterType::VARIANCE:
+			return "Variance";
+		default:
+			return "Unknown";
+	}
+}
+
 // for string delimiter
 std::vector<std::string> split(std::string s, std::string delimiter) {
 	size_t pos_start = 0, pos_end, delim_len = delimiter.length();
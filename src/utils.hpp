@@ -5,10 +5,11 @@
 #include <vector>
 #include <complex>
 #include <cmath>
-#include "rp.h"
+#include "rp_enums.h"
 
 #include "Signal.hpp"
 #include "Window.hpp"
+#include "MovingFilter.hpp"
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -30,6 +31,10 @@ WindowType stringToWindowType(const std::string &str);
 
 std::string windowTypeToString(WindowType type);
 
+MovingFilterType stringToMovingFilterType(const std::string &str);
+
+std::string movingFilterTypeToString(MovingFilterType type);
+
 // for string delimiter
 std::vector<std::string> split(std::string s, std::string delimiter);
 